@@ -0,0 +1,151 @@
+#include "AllocationTracker.h"
+
+#include "imgui.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+AllocationTracker::Bucket AllocationTracker::buckets[AllocationTracker::MaxScopes];
+std::atomic<int> AllocationTracker::used{ 1 };  // bucket 0 is "(other)"
+std::atomic<long long> AllocationTracker::total{ 0 };
+
+namespace {
+    // innermost scope of the calling thread, only the UI thread opens any
+    thread_local int currentScope = 0;
+    thread_local long long threadTotal = 0;
+
+    // ImGui's allocator before install(), allocations are passed on to it
+    ImGuiMemAllocFunc previousAlloc = nullptr;
+    ImGuiMemFreeFunc previousFree = nullptr;
+    void* previousUserData = nullptr;
+
+    void* trackedAlloc(size_t size, void*) {
+        AllocationTracker::record(size);
+        return previousAlloc(size, previousUserData);
+    }
+
+    void trackedFree(void* ptr, void*) {
+        previousFree(ptr, previousUserData);
+    }
+}
+
+AllocationTracker::Scope::Scope(const char* name) : previous(currentScope) {
+    currentScope = find(name);
+}
+
+AllocationTracker::Scope::~Scope() {
+    currentScope = previous;
+}
+
+int AllocationTracker::find(const char* name) {
+    int count = used.load(std::memory_order_acquire);
+    for (int i = 1; i < count; i++) {
+        if (buckets[i].name == name || std::strcmp(buckets[i].name, name) == 0) return i;
+    }
+    // scopes open on the UI thread only, so nothing else adds buckets
+    if (count == MaxScopes) return 0;
+    buckets[count].name = name;
+    used.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+void AllocationTracker::install() {
+    if (previousAlloc) return;
+    ImGui::GetAllocatorFunctions(&previousAlloc, &previousFree, &previousUserData);
+    ImGui::SetAllocatorFunctions(trackedAlloc, trackedFree, nullptr);
+}
+
+void AllocationTracker::record(size_t bytes) {
+    Bucket& bucket = buckets[currentScope];
+    bucket.allocations.fetch_add(1, std::memory_order_relaxed);
+    bucket.bytes.fetch_add((long long)bytes, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    threadTotal++;
+}
+
+void AllocationTracker::frame() {
+    int count = used.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        Bucket& bucket = buckets[i];
+        bucket.last.allocations = bucket.allocations.exchange(0, std::memory_order_relaxed);
+        bucket.last.bytes = bucket.bytes.exchange(0, std::memory_order_relaxed);
+        if (bucket.last.allocations > bucket.peak.allocations) bucket.peak = bucket.last;
+    }
+}
+
+int AllocationTracker::scopeCount() {
+    return used.load(std::memory_order_acquire);
+}
+
+const char* AllocationTracker::scopeName(int scope) {
+    return scope == 0 ? "(other)" : buckets[scope].name;
+}
+
+AllocationTracker::Counts AllocationTracker::lastFrame(int scope) {
+    return buckets[scope].last;
+}
+
+AllocationTracker::Counts AllocationTracker::peak(int scope) {
+    return buckets[scope].peak;
+}
+
+long long AllocationTracker::totalAllocations() {
+    return total.load(std::memory_order_relaxed);
+}
+
+long long AllocationTracker::threadAllocations() {
+    return threadTotal;
+}
+
+void AllocationTracker::showOverlay(bool* open) {
+    ImGui::SetNextWindowPos(ImVec2(480.0f, 380.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Allocations", open, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing)) {
+        ImGui::End();
+        return;
+    }
+    Counts sum;
+    if (ImGui::BeginTable("scopes", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("Allocs");
+        ImGui::TableSetupColumn("Bytes");
+        ImGui::TableSetupColumn("Peak");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < scopeCount(); i++) {
+            Counts last = lastFrame(i);
+            sum.allocations += last.allocations;
+            sum.bytes += last.bytes;
+            // anything above zero in a steady frame is worth a look
+            ImVec4 color = last.allocations > 0 ? ImVec4(0.8f, 0.2f, 0.2f, 1.0f) : ImGui::GetStyleColorVec4(ImGuiCol_Text);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextColored(color, "%s", scopeName(i));
+            ImGui::TableNextColumn();
+            ImGui::TextColored(color, "%lld", last.allocations);
+            ImGui::TableNextColumn();
+            ImGui::TextColored(color, "%lld", last.bytes);
+            ImGui::TableNextColumn();
+            ImGui::Text("%lld", peak(i).allocations);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Last frame: %lld allocations, %lld bytes", sum.allocations, sum.bytes);
+    ImGui::End();
+}
+
+#ifdef ALLOCATION_TRACKING
+void* operator new(std::size_t size) {
+    AllocationTracker::record(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Counts heap allocations frame by frame and charges each one to the innermost
+// AllocationTracker::Scope open on the UI thread. Global operator new is only replaced
+// when ALLOCATION_TRACKING is defined; install() adds ImGui's own allocator on top.
+// Allocations on other threads, or outside every scope, go to "(other)".
+// A steady frame should show zero everywhere
+class AllocationTracker {
+public:
+    static const int MaxScopes = 16;
+
+    struct Counts {
+        long long allocations = 0;
+        long long bytes = 0;
+    };
+
+    // charges allocations to name until destroyed; name must be a string literal
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        int previous;
+    };
+
+    // routes ImGui's allocator through the tracker, keeping whatever was set before.
+    // Call after the context is created
+    static void install();
+    // from operator new and the ImGui allocator
+    static void record(size_t bytes);
+    // ends the frame: the counts gathered since the last call become lastFrame()
+    static void frame();
+
+    static int scopeCount();
+    static const char* scopeName(int scope);
+    static Counts lastFrame(int scope);
+    // largest single frame so far
+    static Counts peak(int scope);
+    // every allocation since start-up, on all threads
+    static long long totalAllocations();
+    // the calling thread's share of totalAllocations()
+    static long long threadAllocations();
+
+    // window with last frame's counts per scope
+    static void showOverlay(bool* open = nullptr);
+
+private:
+    struct Bucket {
+        const char* name = nullptr;
+        std::atomic<long long> allocations{ 0 }, bytes{ 0 };
+        Counts last, peak;
+    };
+    static Bucket buckets[MaxScopes];
+    static std::atomic<int> used;
+    static std::atomic<long long> total;
+
+    static int find(const char* name);
+};
+
+#ifdef ALLOCATION_TRACKING
+#define TRACK_ALLOCATIONS(name) AllocationTracker::Scope allocation_scope(name)
+#else
+#define TRACK_ALLOCATIONS(name) ((void)0)
+#endif
@@ -1,376 +1,1938 @@
-﻿#pragma once
-
-#include "App.h"
-
-#include "imgui.h"
-#include <string>
-#include <memory>
-#include <iostream>
-#include <cstdlib>
-
-//base class for all Equations
-class Equation {
-public:
-    virtual std::string toString() = 0;
-    virtual ~Equation() {}
-};
-
-//class First-Order DE
-class FirstOrderLinearEquation : public Equation {
-public:
-    std::string P;
-    int Q;
-    static bool isHomogeneous;
-    static bool hasVariableCoefficient;
-
-public:
-    // Constructor with user input
-    FirstOrderLinearEquation() {
-        UpdateInputs();
-    }
-    // UpdateInputs
-    void UpdateInputs() {
-        P = hasVariableCoefficient ? std::to_string(rand() % 10 + 1) + "x"  : std::to_string(rand() % 10 + 1);
-
-        Q = isHomogeneous ? 0 : rand() % 10 + 1;
-    }
-    // toString
-    std::string toString() override {
-        std::string equationType = (isHomogeneous ? "Homogeneous" : "Non-Homogeneous");
-        std::string coefficientType = (hasVariableCoefficient ? "Variable Coefficient" : "Constant Coefficient");
-        return "Generated First-Order Linear DE\n (" + equationType + ", " + coefficientType + "):\n"
-            "dy/dx + " + P + "y = " + std::to_string(Q);
-    }
-};
-
-//class Cauchy-Euler Equation
-class CauchyEulerEquation : public Equation {
-private:
-    int a;
-    int b;
-
-public:
-    // Constructor
-    CauchyEulerEquation() : a(rand() % 10 + 1), b(rand() % 10 + 1) {}
-    // toString
-    std::string toString() override {
-        return "Generated Cauchy-Euler Equation:\nx^2 * d^2y/dx^2 + " + std::to_string(a) + "x*dy/dx + " + std::to_string(b) + "y = 0";
-    }
-};
-
-//class Higher Order Equation
-class HigherOrderEquation : public Equation {
-private:
-    int a, b, c;
-
-public:
-    // Constructor
-    HigherOrderEquation() : a(rand() % 10 + 1), b(rand() % 10 + 1), c(rand() % 10 + 1) {}
-    // toString
-    std::string toString() override {
-        return "Generated Higher-Order DE:\nd^2y/dx^2 + " + std::to_string(a) + "dy/dx + " + std::to_string(b) + "y = " + std::to_string(c);
-    }
-};
-
-//class Partial Equation
-class PartialEquation : public Equation {
-private:
-    int alpha, beta;
-
-public:
-    // Constructor
-    PartialEquation() : alpha(rand() % 10 + 1), beta(rand() % 10 + 1) {}
-    // toString
-    std::string toString() override {
-        return "Generated Partial DE:\n∂^2u/∂x^2 + " + std::to_string(alpha) + "*∂u/∂x = " + std::to_string(beta);
-    }
-};
-
-//class System of Equations
-class SystemOfEquations : public Equation {
-private:
-    int x_coeff, y_coeff, rhs;
-
-public:
-    // Constructor
-    SystemOfEquations() : x_coeff(rand() % 5 + 1), y_coeff(rand() % 5 + 1), rhs(rand() % 10 + 1) {}
-    // toString
-    std::string toString() override {
-        return "Generated System of Equations:\ndx/dt = " + std::to_string(x_coeff) + "x + " + std::to_string(y_coeff) + "y,\n"
-            "dy/dt = " + std::to_string(rhs) + "x";
-    }
-};
-
-//class ExactEquation
-class ExactEquation : public Equation {
-private:
-    int a, b, c; // coefficients
-    int equationType; // (1 for ln, 2 for kx)
-
-public:
-    // Constructor
-    ExactEquation() {
-        a = (rand() % 10 + 1); // Random coefficient a
-        b = (rand() % 10 + 1); // Random coefficient b
-        c = (rand() % 10 + 1); // Random constant multiplier for kx
-        equationType = rand() % 2 + 1; // Choose randomly between 1 and 2
-    }
-    // toString
-    std::string toString() override {
-        if (equationType == 1) {
-            //type 1: ln-based equation
-            return "Generated Exact Equation:\n" +
-                std::to_string(a) + "ln(y)*dy + " +
-                std::to_string(b) + "ln(x)*dx = 0";
-        }
-        else {
-            //type 2: kx-based equation
-            return "Generated Exact Equation:\n" +
-                std::to_string(a * c) + "y*dy + " +
-                std::to_string(b * c) + "x*dx = 0";
-        }
-    }
-};
-
-//class Seperable Equation
-class SeparableEquation : public Equation {
-private:
-    int p, q; // coefficients for the separable equation
-
-public:
-    // Constructor
-    SeparableEquation() : p(rand() % 10 + 1), q(rand() % 10 + 1) {}
-    // toString
-    std::string toString() override {
-        return "Generated Separable Equation:\n(dy/" + std::to_string(p) + "y) = (dx/" + std::to_string(q) + "x)";
-    }
-};
-
-//class Laplace Transform Equation
-class LaplaceTransformEquation : public Equation {
-private:
-    int a, b, c; // coefficients for the differential equation
-    int trigChoice; // determines if sin, cos, or both are included
-
-public:
-    // Constructor
-    LaplaceTransformEquation()
-        : a(rand() % 10 + 1), b(rand() % 10 + 1), c(rand() % 10 + 1), trigChoice(rand() % 3) {
-    }
-    // toString
-    std::string toString() override {
-        std::string equation = "Generated Laplace Equation:\n";
-        equation += "y'(t) + " + std::to_string(a) + "y(t) = ";
-
-        // Randomly decide to use sin, cos, or both
-        if (trigChoice == 0) {
-            equation += std::to_string(b) + "sin(" + std::to_string(c) + "t)";
-        }
-        else if (trigChoice == 1) {
-            equation += std::to_string(b) + "cos(" + std::to_string(c) + "t)";
-        }
-        else {
-            equation += std::to_string(b) + "sin(" + std::to_string(c) + "t) + cos(" + std::to_string(c) + "t)";
-        }
-
-        return equation;
-    }
-};
-
-//class Equation Generator
-class EquationGenerator {
-public:
-    // generateEquation
-    static std::shared_ptr<Equation> generateEquation(int choice) {
-        if (choice == 1) {
-            return std::make_shared<FirstOrderLinearEquation>();
-        }
-        else if (choice == 2) {
-            return std::make_shared<CauchyEulerEquation>();
-        }
-        else if (choice == 3) {
-            return std::make_shared<HigherOrderEquation>();
-        }
-        else if (choice == 4) {
-            return std::make_shared<PartialEquation>();
-        }
-        else if (choice == 5) {
-            return std::make_shared<SystemOfEquations>();
-        }
-        else if (choice == 6) {
-            return std::make_shared<SeparableEquation>();
-        }
-        else if (choice == 7) {
-            return std::make_shared<ExactEquation>();
-        }
-        else if (choice == 8) {
-            return std::make_shared<LaplaceTransformEquation>();
-        }
-        else {
-            std::cout << "Invalid choice. Returning nullptr.\n";
-            return nullptr;
-        }
-    }
-};
-
-
-bool FirstOrderLinearEquation::isHomogeneous = true;  // default value
-bool FirstOrderLinearEquation::hasVariableCoefficient = false;  // default value
-
-// App Namespace for imgui implementation
-namespace App {
-
-    //Declarations
-    static std::string name = "9th Grade Algebra expert";
-
-    static bool show_demo_window = false;
-    static bool equation_selection_window = true;
-    static bool equation_display_window = false;
-    static bool first_order_helper_window = false;
-
-    static int equation_choice = 2;
-    static int last_equation_choice = 0;
-
-    // smart pointer to selected equation
-    static std::shared_ptr<Equation> current_equation = std::make_shared<FirstOrderLinearEquation>();
-
-    // mutator for FirstOrderParametersWindow
-    void setFirstOrderHelperBool(bool val) {
-        first_order_helper_window = val;
-    }
-    // Renders First Order Linear Equation Helper Popup
-    void RenderFirstOrderParametersWindow() {
-        if (first_order_helper_window && std::dynamic_pointer_cast<FirstOrderLinearEquation>(current_equation)) {
-            ImGui::OpenPopup("First Order Linear");
-        }
-
-        if (ImGui::BeginPopupModal("First Order Linear", &first_order_helper_window, ImGuiWindowFlags_AlwaysAutoResize)) {
-            ImGui::Text("Configure Equation Parameters");
-            ImGui::Separator();
-
-            FirstOrderLinearEquation* eq = dynamic_cast<FirstOrderLinearEquation*>(current_equation.get());
-            if (eq) {
-                // Ask if the equation is homogeneous
-                ImGui::Checkbox("Homogeneous?", &eq->isHomogeneous);
-
-                // Ask if the equation has variable coefficient
-                ImGui::Checkbox("Variable coefficient?", &eq->hasVariableCoefficient);
-
-                // Confirm Button Logic
-                if (ImGui::Button("Confirm")) {
-                    // Update equation coefficients
-                    eq->UpdateInputs();
-                    // Close the helper window
-                    ImGui::CloseCurrentPopup();
-                    first_order_helper_window = false;
-                }
-            }
-
-            ImGui::EndPopup();
-        }
-    }
-
-    // Renders Main Equation Generation Window
-    void RenderEquationSelectionWindow() {
-        if (equation_selection_window) {
-            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f), ImGuiCond_Always);
-            ImGui::SetNextWindowSize(ImVec2(800.0f, 600.0f), ImGuiCond_Always);
-
-            ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.9f, 0.95f, 1.0f, 1.0f));
-
-            ImGui::Begin("Generate Equation", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBringToFrontOnFocus);
-            // Dropdown of buttons to select the type of equation to generate
-            float windowWidth = ImGui::GetContentRegionAvail().x;
-            float textWidth = ImGui::CalcTextSize("Select Equation Type:").x;
-
-            ImGui::SetCursorPosX((windowWidth - textWidth) * 0.5f);
-            ImGui::Text("Select Equation Type:");
-
-            /*ImGui::Text("test: %d, %d", equation_choice, last_equation_choice);
-            FirstOrderLinearEquation* eq = dynamic_cast<FirstOrderLinearEquation*>(current_equation.get());
-            if (eq) {
-                // Text command reflecting instance data
-                ImGui::Text("test: %s, %s",
-                    eq->isHomogeneous ? "true" : "false",
-                    eq->hasVariableCoefficient ? "true" : "false");
-            } testing */
-
-            ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 10);
-            // creating radio buttons
-            const char* labels[] = { "First-Order Linear", "Cauchy-Euler", "Higher-Order", "Partial ", "System of Equations", "Seperable", "Exact", "Laplace Transform"};
-            for (int i = 0; i < 8; i++) {
-                textWidth = ImGui::CalcTextSize(labels[i]).x;
-                ImGui::SetCursorPosX((windowWidth - textWidth) * 0.5f - 20.0f);
-                ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 2);
-                ImGui::RadioButton(labels[i], &equation_choice, i + 1);
-            }
-            ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 20);
-
-            if (equation_choice==1 && last_equation_choice!=equation_choice) {
-                first_order_helper_window = true; // Open the helper window
-            }
-            last_equation_choice = equation_choice; // Update the last selection
-
-            ImGui::SetCursorPosX((windowWidth - 200) * 0.5f);
-            if (ImGui::Button("Generate Equation", ImVec2(200, 50)) && !equation_display_window) {
-                current_equation = EquationGenerator::generateEquation(equation_choice); // Update current equation
-                equation_display_window = true;
-            }
-
-            ImGui::End();
-            ImGui::PopStyleColor();
-
-        }
-    }
-
-    // Renders Equation Output
-    void RenderEquationDisplayWindow() {
-        if (equation_display_window) {
-            ImGui::OpenPopup("Equation Display");
-            ImGui::BeginPopupModal("Equation Display", &equation_display_window, ImGuiWindowFlags_AlwaysAutoResize);
-
-            // Display the generated equation
-            if (current_equation) {
-                ImGui::Text("%s", current_equation->toString().c_str());
-            }
-            else {
-                ImGui::Text("No equation generated!");
-            }
-            // Close Button for the display window
-            if (ImGui::Button("Close")) {
-                equation_display_window = false;
-            }
-
-            ImGui::EndPopup();
-        }
-    }
-
-    // Render the Welcome Window
-    void RenderWelcomeWindow() {
-        static int counter = 0;
-        if (show_demo_window) {
-            ImGui::ShowDemoWindow(&show_demo_window);
-        }
-
-        ImGui::SetNextWindowPos(ImVec2(9, 490));
-        ImGui::SetNextWindowSize(ImVec2(290.0f, 60.0f), ImGuiCond_Always);
-        ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(1.0f, 1.0f, 0.7f, 1.0f));
-
-        ImGui::Begin("Welcome");
-        ImGui::Text("Welcome, %s", name.c_str());
-        //ImGui::Checkbox("Demo Window", &show_demo_window);
-
-        ImGui::End();
-        ImGui::PopStyleColor();
-    }
-
-
-    // Main Render Function for UI
-    void RenderUI() {
-        RenderFirstOrderParametersWindow(); // Render the first order parameters equation's helper popup
-        RenderEquationSelectionWindow();    // Render the main application window
-        RenderEquationDisplayWindow();      // Render generated equation
-        RenderWelcomeWindow();              // Render the welcome window
-    }
-}
-
+#pragma once
+
+#include "App.h"
+#include "Exactness.h"
+#include "Polynomial.h"
+#include "Inverse.h"
+#include "LinearSystem.h"
+#include "Integrator.h"
+#include "Expr.h"
+#include "Bytecode.h"
+#include "Simplifier.h"
+#include "Dedup.h"
+#include "Parser.h"
+#include "Grader.h"
+#include "Calculus.h"
+#include "Rational.h"
+#include "Steps.h"
+#include "Series.h"
+#include "RetainedDrawList.h"
+#include "TextLayout.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "Prefetch.h"
+#include "History.h"
+
+#include "imgui.h"
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+//base class for all Equations
+class Equation {
+public:
+    Equation() {}
+    // the derivation thunk captures this, so equations are only shared, never copied
+    Equation(const Equation&) = delete;
+    Equation& operator=(const Equation&) = delete;
+
+    virtual std::string toString() = 0;
+    // the equation as a hash-consed expression, identical subterms share nodes in the arena
+    virtual const Expr* toExpr(ExprArena& arena) = 0;
+    // general solution structure, empty when the type doesn't provide one
+    virtual std::string solutionForm() { return ""; }
+    // right-hand side f of y' = f(t, y) for first-order equations, nullptr otherwise
+    virtual const Expr* slope(ExprArena&) { return nullptr; }
+    // name of t in slope()
+    virtual std::string independentVariable() { return "x"; }
+    // family and coefficients, scalar multiples of scale-invariant equations share a key
+    virtual EquationKey key() = 0;
+    // worked solution, derived the first time it is asked for
+    const std::vector<SolutionStep>& steps() { return derivation.get(); }
+    bool stepsExpanded() const { return derivation.expanded(); }
+    virtual ~Equation() {}
+
+protected:
+    // the derivation behind steps(), only run for equations whose steps are viewed or exported
+    virtual std::vector<SolutionStep> buildSteps() { return {}; }
+
+    LazySteps derivation{ [this] { return buildSteps(); } };
+};
+
+//class First-Order DE
+class FirstOrderLinearEquation : public Equation {
+public:
+    int P;          // coefficient of y
+    bool variableP; // P is multiplied by x
+    int Q;
+    static thread_local bool isHomogeneous;
+    static thread_local bool hasVariableCoefficient;
+
+public:
+    // Constructor with user input
+    FirstOrderLinearEquation() {
+        UpdateInputs();
+    }
+    // UpdateInputs
+    void UpdateInputs() {
+        P = Random::next() % 10 + 1;
+        variableP = hasVariableCoefficient;
+
+        Q = isHomogeneous ? 0 : Random::next() % 10 + 1;
+        derivation.reset();
+    }
+    // solutionForm
+    std::string solutionForm() override {
+        // y = (1/mu) (integral of mu Q dx + C) with mu = e^(integral of P(x) dx)
+        ExprArena& arena = ExprArena::shared();
+        const Expr* Px = variableP ? arena.mul({ arena.constant(P), arena.var("x") }) : arena.constant(P);
+        const Expr* exponent = Calculus::integral(Px, "x", arena);
+        const Expr* mu = arena.func("exp", exponent);
+        const Expr* decay = arena.func("exp", Calculus::scale(exponent, -1, 1, arena));
+        std::string s = "Integrating Factor: " + ExprFormat::format(mu) + "\ny = ";
+        if (Q == 0) {
+            return s + ExprFormat::format(arena.mul({ arena.var("C"), decay }));
+        }
+        const Expr* integrand = arena.mul({ arena.constant(Q), mu });
+        const Expr* integral = Calculus::integral(integrand, "x", arena);
+        if (!integral) {
+            // e^(x^2) has no elementary antiderivative
+            return s + ExprFormat::format(decay) + "*(integral of " + ExprFormat::format(integrand) + " dx + C)";
+        }
+        return s + ExprFormat::format(arena.mul({ decay, arena.add({ integral, arena.var("C") }) }));
+    }
+    // buildSteps
+    std::vector<SolutionStep> buildSteps() override {
+        ExprArena& arena = ExprArena::shared();
+        const Expr* y = arena.var("y");
+        const Expr* C = arena.var("C");
+        const Expr* Px = variableP ? arena.mul({ arena.constant(P), arena.var("x") }) : arena.constant(P);
+        const Expr* exponent = Calculus::integral(Px, "x", arena);
+        const Expr* mu = arena.func("exp", exponent);
+        const Expr* decay = arena.func("exp", Calculus::scale(exponent, -1, 1, arena));
+        const Expr* muQ = arena.mul({ arena.constant(Q), mu });
+        std::string muy = ExprFormat::format(arena.mul({ mu, y }));
+
+        std::vector<SolutionStep> steps;
+        steps.push_back({ "Standard form", "y' + P(x)y = Q(x) with P(x) = " + ExprFormat::format(Px) + ", Q(x) = " + std::to_string(Q) });
+        steps.push_back({ "Integrating factor", "mu(x) = e^(integral of P(x) dx) = " + ExprFormat::format(mu) });
+        steps.push_back({ "Multiply by mu", "(" + muy + ")' = " + (Q == 0 ? "0" : ExprFormat::format(muQ)) });
+        if (Q == 0) {
+            steps.push_back({ "Integrate", muy + " = C" });
+            steps.push_back({ "General solution", "y = " + ExprFormat::format(arena.mul({ C, decay })) });
+            steps.push_back({ "Initial condition", "y(0) = 1 gives C = 1, y = " + ExprFormat::format(decay) });
+            return steps;
+        }
+        const Expr* integral = Calculus::integral(muQ, "x", arena);
+        if (!integral) {
+            std::string integrand = ExprFormat::format(muQ);
+            steps.push_back({ "Integrate", "integral of " + integrand + " dx has no elementary form" });
+            steps.push_back({ "General solution", "y = " + ExprFormat::format(decay) + "*(integral of " + integrand + " dx + C)" });
+            steps.push_back({ "Initial condition", "y(0) = 1 gives y = " + ExprFormat::format(decay) + "*(1 + integral from 0 to x of " + integrand + " dx)" });
+            return steps;
+        }
+        steps.push_back({ "Integrate", muy + " = " + ExprFormat::format(arena.add({ integral, C })) });
+        steps.push_back({ "General solution", "y = " + ExprFormat::format(arena.mul({ decay, arena.add({ integral, C }) })) });
+        if (!variableP) {
+            // mu(0) = 1 and the integral is (Q/P)e^(Px), so y(0) = Q/P + C
+            Rational c0 = Rational(1) - Rational(Q, P);
+            steps.push_back({ "Initial condition", "y(0) = 1 gives C = " + c0.toString() + ", y = " +
+                ExprFormat::format(arena.mul({ decay, Calculus::collect(arena.add({ integral, c0.toExpr(arena) }), arena) })) });
+        }
+        return steps;
+    }
+    // toExpr
+    const Expr* toExpr(ExprArena& arena) override {
+        const Expr* x = arena.var("x");
+        const Expr* y = arena.var("y");
+        const Expr* Py = variableP ? arena.mul({ arena.constant(P), x, y }) : arena.mul({ arena.constant(P), y });
+        return arena.equation(arena.add({ arena.deriv(y, "x"), Py }), arena.constant(Q));
+    }
+    // slope
+    const Expr* slope(ExprArena& arena) override {
+        // y' = Q - P(x) y
+        const Expr* x = arena.var("x");
+        const Expr* y = arena.var("y");
+        const Expr* Py = variableP ? arena.mul({ arena.constant(-P), x, y }) : arena.mul({ arena.constant(-P), y });
+        return arena.add({ arena.constant(Q), Py });
+    }
+    // key
+    EquationKey key() override {
+        // dy/dx is monic, so the coefficients are already unique
+        EquationKey k;
+        k.family = 1;
+        k.coeffs = { P, variableP ? 1 : 0, Q };
+        return k;
+    }
+    // toString
+    std::string toString() override {
+        // from this equation, the settings may have changed since it was made
+        std::string equationType = (Q == 0 ? "Homogeneous" : "Non-Homogeneous");
+        std::string coefficientType = (variableP ? "Variable Coefficient" : "Constant Coefficient");
+        return "Generated First-Order Linear DE\n (" + equationType + ", " + coefficientType + "):\n" +
+            ExprFormat::format(toExpr(ExprArena::shared()));
+    }
+};
+
+//class Cauchy-Euler Equation
+class CauchyEulerEquation : public Equation {
+private:
+    int a;
+    int b;
+    std::vector<PolyRoot> roots; // roots of the indicial equation r^2 + (a-1)r + b = 0
+
+public:
+    // Constructor
+    CauchyEulerEquation() : a(Random::next() % 10 + 1), b(Random::next() % 10 + 1) {
+        if (InverseGenerator::enabled) {
+            // pick the indicial roots first and build a, b from them
+            roots = InverseGenerator::sampleRoots(2, true);
+            InverseGenerator::cauchyEuler(roots, a, b);
+        }
+        else {
+            roots = PolynomialRoots::solve({ 1.0, double(a - 1), double(b) });
+        }
+    }
+    // solutionForm
+    std::string solutionForm() override {
+        return "Indicial Roots: " + PolynomialRoots::formatRoots(roots) + "\n" + generalSolution();
+    }
+    // y = ... for the three root cases
+    std::string generalSolution() {
+        std::string s = "y = ";
+        const PolyRoot& r = roots[0];
+        std::string p1 = PolynomialRoots::formatNumber(r.value.real());
+        if (r.value.imag() != 0.0) {
+            std::string q = PolynomialRoots::formatNumber(std::fabs(r.value.imag()));
+            std::string arg = (q == "1" ? "" : q) + "ln(x)";
+            std::string trig = "C1cos(" + arg + ") + C2sin(" + arg + ")";
+            return s + (p1 == "0" ? trig : "x^(" + p1 + ")*(" + trig + ")");
+        }
+        if (r.multiplicity == 2) {
+            return s + "x^(" + p1 + ")*(C1 + C2ln(x))";
+        }
+        return s + "C1x^(" + p1 + ") + C2x^(" + PolynomialRoots::formatNumber(roots[1].value.real()) + ")";
+    }
+    // buildSteps
+    std::vector<SolutionStep> buildSteps() override {
+        ExprArena& arena = ExprArena::shared();
+        const Expr* r = arena.var("r");
+        std::vector<const Expr*> indicial(1, arena.pow(r, 2));
+        if (a != 1) indicial.push_back(arena.mul({ arena.constant(a - 1), r }));
+        if (b != 0) indicial.push_back(arena.constant(b));
+
+        std::vector<SolutionStep> steps;
+        steps.push_back({ "Trial solution", "y = x^r gives r(r - 1) + " + std::to_string(a) + "r + " + std::to_string(b) + " = 0" });
+        steps.push_back({ "Indicial equation", ExprFormat::format(arena.equation(arena.add(indicial), arena.constant(0))) });
+        const PolyRoot& r1 = roots[0];
+        std::string kind = r1.value.imag() != 0.0 ? " (complex pair p +- qi)" : r1.multiplicity == 2 ? " (repeated)" : " (distinct real)";
+        steps.push_back({ "Indicial roots", PolynomialRoots::formatRoots(roots) + kind });
+        steps.push_back({ "General solution", generalSolution() });
+
+        // y(1) = C1 and y'(1) is linear in C1, C2 in every case
+        double c1, c2;
+        if (r1.value.imag() != 0.0) {
+            c1 = 1.0;
+            c2 = -r1.value.real() / std::fabs(r1.value.imag());
+        }
+        else if (r1.multiplicity == 2) {
+            c1 = 1.0;
+            c2 = -r1.value.real();
+        }
+        else {
+            double p = r1.value.real(), q = roots[1].value.real();
+            c1 = q / (q - p);
+            c2 = -p / (q - p);
+        }
+        steps.push_back({ "Initial conditions", "y(1) = 1, y'(1) = 0 give C1 = " + PolynomialRoots::formatNumber(c1) +
+            ", C2 = " + PolynomialRoots::formatNumber(c2) });
+        return steps;
+    }
+    // toExpr
+    const Expr* toExpr(ExprArena& arena) override {
+        const Expr* x = arena.var("x");
+        const Expr* y = arena.var("y");
+        return arena.equation(arena.add({
+            arena.mul({ arena.pow(x, 2), arena.deriv(y, "x", 2) }),
+            arena.mul({ arena.constant(a), x, arena.deriv(y, "x") }),
+            arena.mul({ arena.constant(b), y }) }), arena.constant(0));
+    }
+    // key
+    EquationKey key() override {
+        EquationKey k;
+        k.family = 2;
+        k.coeffs = { a, b };
+        return k;
+    }
+    // toString
+    std::string toString() override {
+        return "Generated Cauchy-Euler Equation:\n" + ExprFormat::format(toExpr(ExprArena::shared()));
+    }
+};
+
+//class Higher Order Equation
+class HigherOrderEquation : public Equation {
+private:
+    int a, b, c;
+    std::vector<int> coeffs; // characteristic polynomial r^n + coeffs[0]r^(n-1) + ... + coeffs[n-1]
+    std::vector<PolyRoot> roots;
+
+    // characteristic polynomial, highest degree first
+    std::vector<double> characteristic() const {
+        std::vector<double> poly(1, 1.0);
+        for (int k : coeffs) poly.push_back(k);
+        return poly;
+    }
+
+public:
+    static thread_local int order; // 2 keeps the classic a, b, c form
+
+    // Constructor
+    HigherOrderEquation() : HigherOrderEquation(true) {}
+    // Constructor, solveNow = false leaves the roots to generateBatch
+    explicit HigherOrderEquation(bool solveNow) : a(Random::next() % 10 + 1), b(Random::next() % 10 + 1), c(Random::next() % 10 + 1) {
+        if (InverseGenerator::enabled) {
+            // characteristic roots first, forcing chosen so c / coeffs[n-1] is an integer
+            roots = InverseGenerator::sampleRoots(order < 2 ? 2 : order, false);
+            coeffs = InverseGenerator::expand(roots);
+            c = coeffs.back() * (Random::next() % 5 + 1);
+            if (coeffs.size() == 2) { a = coeffs[0]; b = coeffs[1]; }
+            return;
+        }
+        if (order <= 2) {
+            coeffs = { a, b };
+        }
+        else {
+            for (int k = 0; k < order; k++) coeffs.push_back(Random::next() % 10 + 1);
+        }
+        if (solveNow) roots = PolynomialRoots::solve(characteristic());
+    }
+    // equation i the same as one made after Random::Scope(seed + i), with the characteristic
+    // roots of all of them found in one batch, side by side in the root finder's lanes
+    static std::vector<std::shared_ptr<HigherOrderEquation>> generateBatch(unsigned seed, size_t count) {
+        std::vector<std::shared_ptr<HigherOrderEquation>> equations;
+        std::vector<std::vector<double>> polys;
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < count; i++) {
+            Random::Scope random(seed + (unsigned)i);
+            equations.push_back(std::make_shared<HigherOrderEquation>(false));
+            // inverse-built equations already know their roots
+            if (equations.back()->roots.empty()) {
+                polys.push_back(equations.back()->characteristic());
+                pending.push_back(i);
+            }
+        }
+        std::vector<std::vector<PolyRoot>> roots;
+        PolynomialRoots::solveBatch(polys, roots);
+        for (size_t i = 0; i < pending.size(); i++) equations[pending[i]]->roots = roots[i];
+        return equations;
+    }
+    // solutionForm
+    std::string solutionForm() override {
+        std::string s = "Characteristic Roots: " + PolynomialRoots::formatRoots(roots) + "\n"
+            "y = " + PolynomialRoots::solutionForm(roots);
+        // constant forcing term gives the particular solution c / coeffs[n-1]
+        s += " + " + Rational(c, coeffs.back()).toString();
+        return s + "\n" + answerKey();
+    }
+    // buildSteps
+    std::vector<SolutionStep> buildSteps() override {
+        ExprArena& arena = ExprArena::shared();
+        const Expr* r = arena.var("r");
+        int n = (int)coeffs.size();
+        std::vector<const Expr*> poly(1, arena.pow(r, n));
+        for (int k = 0; k < n; k++) {
+            int d = n - 1 - k;
+            if (coeffs[k] == 0) continue;
+            poly.push_back(d == 0 ? arena.constant(coeffs[k]) : arena.mul({ arena.constant(coeffs[k]), d == 1 ? r : arena.pow(r, d) }));
+        }
+        std::string homogeneous = PolynomialRoots::solutionForm(roots);
+        std::string particular = Rational(c, coeffs.back()).toString();
+
+        std::vector<SolutionStep> steps;
+        steps.push_back({ "Characteristic equation", ExprFormat::format(arena.equation(arena.add(poly), arena.constant(0))) });
+        steps.push_back({ "Characteristic roots", PolynomialRoots::formatRoots(roots) });
+        steps.push_back({ "Homogeneous solution", "y_h = " + homogeneous });
+        steps.push_back({ "Particular solution", "constant forcing, y_p = " + std::to_string(c) + "/" + std::to_string(coeffs.back()) + " = " + particular });
+        steps.push_back({ "General solution", "y = " + homogeneous + " + " + particular });
+        steps.push_back({ "Initial conditions", answerKey() });
+        return steps;
+    }
+    // y(1) for y(0) = 1 and zero initial derivatives, integrated as a first-order system
+    std::string answerKey() {
+        int n = (int)coeffs.size();
+        std::vector<double> A(n * n, 0.0);
+        for (int i = 0; i + 1 < n; i++) A[i * n + i + 1] = 1.0;
+        for (int j = 0; j < n; j++) A[(n - 1) * n + j] = -coeffs[n - 1 - j];
+        double forcing = c;
+        OdeProblem problem = OdeProblem::linear(A, n, [n, forcing](double, int row) { return row == n - 1 ? forcing : 0.0; });
+
+        std::vector<double> y0(n, 0.0);
+        y0[0] = 1.0;
+        Integrator::Result r = Integrator::integrate(problem, y0, 0.0, 1.0);
+        if (!r.completed) return "y(1) not found, the integrator ran out of steps";
+        return "y(1) = " + PolynomialRoots::formatNumber(r.y[0]) + " for y(0) = 1, zero initial derivatives";
+    }
+    // toExpr
+    const Expr* toExpr(ExprArena& arena) override {
+        const Expr* y = arena.var("y");
+        int n = (int)coeffs.size();
+        std::vector<const Expr*> terms(1, arena.deriv(y, "x", n));
+        for (int k = 0; k < n; k++) {
+            int d = n - 1 - k;
+            terms.push_back(arena.mul({ arena.constant(coeffs[k]), d == 0 ? y : arena.deriv(y, "x", d) }));
+        }
+        return arena.equation(arena.add(terms), arena.constant(c));
+    }
+    // key
+    EquationKey key() override {
+        EquationKey k;
+        k.family = 3;
+        k.coeffs.assign(coeffs.begin(), coeffs.end());
+        k.coeffs.push_back(c);
+        return k;
+    }
+    // toString
+    std::string toString() override {
+        std::string header = coeffs.size() == 2 ? "Generated Higher-Order DE:\n" :
+            "Generated Higher-Order DE (Order " + std::to_string(coeffs.size()) + "):\n";
+        return header + ExprFormat::format(toExpr(ExprArena::shared()));
+    }
+};
+
+//class Partial Equation
+class PartialEquation : public Equation {
+private:
+    int alpha, beta;
+
+public:
+    // Constructor
+    PartialEquation() : alpha(Random::next() % 10 + 1), beta(Random::next() % 10 + 1) {}
+    // buildSteps
+    std::vector<SolutionStep> buildSteps() override {
+        // only x-derivatives appear, so it is an ODE in x whose constants may depend on the other variables
+        ExprArena& arena = ExprArena::shared();
+        const Expr* x = arena.var("x");
+        const Expr* uh = arena.add({ arena.var("C1"), arena.mul({ arena.var("C2"), arena.func("exp", arena.mul({ arena.constant(-alpha), x })) }) });
+        // 0 is a characteristic root, so the constant forcing needs u_p = Kx with alpha K = beta
+        Rational K(beta, alpha);
+        const Expr* up = K == 1 ? x : arena.mul({ K.toExpr(arena), x });
+
+        std::vector<SolutionStep> steps;
+        steps.push_back({ "Reduce to an ODE", "only x-derivatives appear, so C1 and C2 may depend on the other variables" });
+        steps.push_back({ "Characteristic equation", "r^2 + " + std::to_string(alpha) + "r = 0, roots 0 and " + std::to_string(-alpha) });
+        steps.push_back({ "Homogeneous solution", "u_h = " + ExprFormat::format(uh) });
+        steps.push_back({ "Particular solution", "u_p = Kx with " + std::to_string(alpha) + "K = " + std::to_string(beta) + ", u_p = " + ExprFormat::format(up) });
+        steps.push_back({ "General solution", "u = " + ExprFormat::format(arena.add({ uh, up })) });
+        return steps;
+    }
+    // toExpr
+    const Expr* toExpr(ExprArena& arena) override {
+        const Expr* u = arena.var("u");
+        return arena.equation(arena.add({
+            arena.deriv(u, "x", 2, DerivStyle::Partial),
+            arena.mul({ arena.constant(alpha), arena.deriv(u, "x", 1, DerivStyle::Partial) }) }), arena.constant(beta));
+    }
+    // key
+    EquationKey key() override {
+        EquationKey k;
+        k.family = 4;
+        k.coeffs = { alpha, beta };
+        return k;
+    }
+    // toString
+    std::string toString() override {
+        return "Generated Partial DE:\n" + ExprFormat::format(toExpr(ExprArena::shared()));
+    }
+};
+
+//class System of Equations
+class SystemOfEquations : public Equation {
+private:
+    int x_coeff, y_coeff, rhs;
+    std::vector<PolyRoot> eigenvalues; // of [[x_coeff, y_coeff], [rhs, 0]]
+    LinearSystem system; // used instead when dimension > 2
+
+public:
+    static thread_local int dimension; // 2 keeps the classic x, y form
+
+    // Constructor
+    SystemOfEquations() : x_coeff(Random::next() % 5 + 1), y_coeff(Random::next() % 5 + 1), rhs(Random::next() % 10 + 1) {
+        if (dimension > 2) {
+            // integer eigenvalues are built in, so this is always a "nice" system
+            system = LinearSystem::random(dimension);
+        }
+        else if (InverseGenerator::enabled) {
+            // eigenvalues first, then a matrix with that trace and determinant
+            eigenvalues = InverseGenerator::sampleRoots(2, false);
+            InverseGenerator::system(eigenvalues, x_coeff, y_coeff, rhs);
+        }
+        else {
+            eigenvalues = PolynomialRoots::solve({ 1.0, double(-x_coeff), double(-y_coeff * rhs) });
+        }
+    }
+    // solutionForm
+    std::string solutionForm() override {
+        if (system.n > 0) {
+            return systemSolutionForm();
+        }
+        return "Eigenvalues: " + PolynomialRoots::formatRoots(eigenvalues) + "\n" + generalSolution() + "\n" + answerKey();
+    }
+    // (x, y) = ... for distinct real, defective and complex eigenvalues
+    std::string generalSolution() {
+        const PolyRoot& l1 = eigenvalues[0];
+        if (l1.value.imag() == 0.0 && l1.multiplicity == 1) {
+            // eigenvector of lambda is (lambda, rhs)
+            const PolyRoot& l2 = eigenvalues[1];
+            auto vec = [this](double l) { return "(" + PolynomialRoots::formatNumber(l) + ", " + std::to_string(rhs) + ")"; };
+            auto rate = [](double l) {
+                std::string k = PolynomialRoots::formatNumber(l);
+                return (k == "1" ? "" : k == "-1" ? "-" : k) + "t";
+            };
+            return "(x, y) = C1" + vec(l1.value.real()) + "e^(" + rate(l1.value.real()) + ") + C2" +
+                vec(l2.value.real()) + "e^(" + rate(l2.value.real()) + ")";
+        }
+        if (l1.value.imag() == 0.0) {
+            // defective double eigenvalue: v = (lambda, rhs) and (A - lambda I)w = v for w = (1, 0)
+            std::string l = PolynomialRoots::formatNumber(l1.value.real());
+            return "(x, y) = (C1(" + l + ", " + std::to_string(rhs) + ") + C2(t(" + l + ", " + std::to_string(rhs) +
+                ") + (1, 0)))e^(" + l + "t)";
+        }
+        return "x(t), y(t) = " + PolynomialRoots::solutionForm(eigenvalues, "t") + " (constants differ per component)";
+    }
+    // buildSteps
+    std::vector<SolutionStep> buildSteps() override {
+        std::vector<SolutionStep> steps;
+        if (system.n > 0) {
+            std::string eigen;
+            for (int v : system.eigenvalues) eigen += (eigen.empty() ? "" : ", ") + std::to_string(v);
+            steps.push_back({ "Matrix form", "x' = Ax with A the " + std::to_string(system.n) + "x" + std::to_string(system.n) + " coefficient matrix" });
+            steps.push_back({ "Eigenvalues", eigen + " (integer by construction)" });
+            steps.push_back({ "Check", "det(A) = " + LinearSystem::determinant(system.A, system.n).toString() + " = product of the eigenvalues" });
+            steps.push_back({ "General solution", "x(t) = e^(At)x(0) = sum of C_i v_i e^(lambda_i t)" });
+            steps.push_back({ "Initial conditions", systemAnswerKey() });
+            return steps;
+        }
+        ExprArena& arena = ExprArena::shared();
+        const Expr* l = arena.var("lambda");
+        std::vector<const Expr*> poly(1, arena.pow(l, 2));
+        if (x_coeff != 0) poly.push_back(arena.mul({ arena.constant(-x_coeff), l }));
+        if (y_coeff * rhs != 0) poly.push_back(arena.constant(-y_coeff * rhs));
+        steps.push_back({ "Matrix form", "(x, y)' = A(x, y) with A = [[" + std::to_string(x_coeff) + ", " + std::to_string(y_coeff) + "], [" +
+            std::to_string(rhs) + ", 0]]" });
+        steps.push_back({ "Characteristic equation", "det(A - lambda I) = " + ExprFormat::format(arena.equation(arena.add(poly), arena.constant(0))) });
+        steps.push_back({ "Eigenvalues", PolynomialRoots::formatRoots(eigenvalues) });
+        steps.push_back({ "General solution", generalSolution() });
+        steps.push_back({ "Initial conditions", answerKey() });
+        return steps;
+    }
+    // (x(1), y(1)) for x(0) = y(0) = 1
+    std::string answerKey() {
+        std::vector<double> A = { double(x_coeff), double(y_coeff), double(rhs), 0.0 };
+        Integrator::Result r = Integrator::integrate(OdeProblem::linear(A, 2), { 1.0, 1.0 }, 0.0, 1.0);
+        if (!r.completed) return "(x(1), y(1)) not found, the integrator ran out of steps";
+        return "(x(1), y(1)) = (" + PolynomialRoots::formatNumber(r.y[0]) + ", " + PolynomialRoots::formatNumber(r.y[1]) +
+            ") for x(0) = y(0) = 1";
+    }
+    // eigenvalues, exact determinant and a numeric answer key for the N x N system
+    std::string systemSolutionForm() {
+        std::string s = "Eigenvalues:";
+        for (int v : system.eigenvalues) s += " " + std::to_string(v);
+        s += "\ndet(A) = " + LinearSystem::determinant(system.A, system.n).toString();
+        return s + "\n" + systemAnswerKey();
+    }
+    // x(1) from x(0) = (1, ..., 1)
+    std::string systemAnswerKey() {
+        std::vector<double> x = system.evolve(std::vector<double>(system.n, 1.0), 1.0);
+        std::string s = "x(1) for x(0) = (1, ..., 1):";
+        for (int i = 0; i < system.n; i++) {
+            s += (i % 4 == 0 ? "\n  " : "  ") + std::string("x") + std::to_string(i + 1) + " = " + PolynomialRoots::formatNumber(x[i]);
+        }
+        return s;
+    }
+    // toExpr
+    const Expr* toExpr(ExprArena& arena) override {
+        if (system.n > 0) {
+            // dx_i/dt = sum of A_ij x_j
+            int n = system.n;
+            std::vector<const Expr*> vars, rows;
+            for (int i = 0; i < n; i++) vars.push_back(arena.var("x" + std::to_string(i + 1)));
+            for (int i = 0; i < n; i++) {
+                std::vector<const Expr*> terms;
+                for (int j = 0; j < n; j++) terms.push_back(arena.mul({ arena.constant(double(system.A[i * n + j])), vars[j] }));
+                rows.push_back(arena.equation(arena.deriv(vars[i], "t"), arena.add(terms)));
+            }
+            return arena.system(rows);
+        }
+        const Expr* x = arena.var("x");
+        const Expr* y = arena.var("y");
+        return arena.system({
+            arena.equation(arena.deriv(x, "t"), arena.add({ arena.mul({ arena.constant(x_coeff), x }), arena.mul({ arena.constant(y_coeff), y }) })),
+            arena.equation(arena.deriv(y, "t"), arena.mul({ arena.constant(rhs), x })) });
+    }
+    // key
+    EquationKey key() override {
+        // dimension first, then the matrix row by row
+        EquationKey k;
+        k.family = 5;
+        if (system.n > 0) {
+            k.coeffs.push_back(system.n);
+            k.coeffs.insert(k.coeffs.end(), system.A.begin(), system.A.end());
+        }
+        else {
+            k.coeffs = { 2, x_coeff, y_coeff, rhs, 0 };
+        }
+        return k;
+    }
+    // toString
+    std::string toString() override {
+        std::string size = std::to_string(system.n);
+        std::string header = system.n > 0 ? "Generated System of Equations (" + size + "x" + size + "):\n" : "Generated System of Equations:\n";
+        return header + ExprFormat::format(toExpr(ExprArena::shared()));
+    }
+};
+
+//class ExactEquation
+class ExactEquation : public Equation {
+private:
+    int a, b, c; // coefficients
+    int equationType; // (1 for ln, 2 for kx, 3 for potential template)
+    ExactForm form; // M dx + N dy = 0
+
+    // builds M and N for the chosen type
+    void buildForm() {
+        if (equationType == 1) {
+            form.M = { { b, 1, 0, 0, TermFactor::Ln, TermFactor::One } };
+            form.N = { { a, 1, 0, 0, TermFactor::One, TermFactor::Ln } };
+        }
+        else if (equationType == 2) {
+            form.M = { { b * c, 1, 1, 0, TermFactor::One, TermFactor::One } };
+            form.N = { { a * c, 1, 0, 1, TermFactor::One, TermFactor::One } };
+        }
+        else {
+            form = ExactForm::randomExact();
+        }
+    }
+
+    // draws the coefficients and the type, then builds M and N
+    void draw() {
+        a = (Random::next() % 10 + 1); // Random coefficient a
+        b = (Random::next() % 10 + 1); // Random coefficient b
+        c = (Random::next() % 10 + 1); // Random constant multiplier for kx
+        equationType = Random::next() % 3 + 1; // Choose randomly between 1, 2 and 3
+        buildForm();
+    }
+
+    // the shown M and N match the form and the shown potential differentiates back to them
+    bool check() {
+        ExprArena& arena = ExprArena::shared();
+        const Expr* M;
+        const Expr* N;
+        sides(arena, M, N);
+        const Expr* F = potentialExpr(arena);
+        const Expr* Fx = F ? Calculus::derivative(F, "x", arena) : nullptr;
+        const Expr* Fy = F ? Calculus::derivative(F, "y", arena) : nullptr;
+        if (!Fx || !Fy) return false;
+        const std::vector<std::string> vars = { "x", "y" };
+        ExprProgram m, n, fx, fy;
+        return ExprProgram::compile(M, vars, m) && ExprProgram::compile(N, vars, n) &&
+            ExprProgram::compile(Fx, vars, fx) && ExprProgram::compile(Fy, vars, fy) &&
+            ExactnessVerifier::verify(form, m, n, fx, fy);
+    }
+
+public:
+    static const int MaxDraws = 8;
+
+    // Constructor
+    ExactEquation() {
+        // a draw that fails the check is drawn again; should every draw fail, the
+        // plain x dx + y dy form is kept rather than looping on
+        for (int i = 0; i < MaxDraws; i++) {
+            draw();
+            if (check()) return;
+        }
+        a = b = c = 1;
+        equationType = 2;
+        buildForm();
+    }
+    // M and N of M dx + N dy = 0
+    void sides(ExprArena& arena, const Expr*& M, const Expr*& N) {
+        const Expr* x = arena.var("x");
+        const Expr* y = arena.var("y");
+        if (equationType == 1) {
+            M = arena.mul({ arena.constant(b), arena.func("ln", x) });
+            N = arena.mul({ arena.constant(a), arena.func("ln", y) });
+        }
+        else if (equationType == 2) {
+            M = arena.mul({ arena.constant(b * c), x });
+            N = arena.mul({ arena.constant(a * c), y });
+        }
+        else {
+            M = ExactForm::termsToExpr(arena, form.M);
+            N = ExactForm::termsToExpr(arena, form.N);
+        }
+    }
+    // potential function F(x,y), nullptr when neither route can integrate the form
+    const Expr* potentialExpr(ExprArena& arena) {
+        // F = integral of M dx + integral of (N - dF/dy) dy, the rest has to be free of x
+        const Expr* M;
+        const Expr* N;
+        sides(arena, M, N);
+        const Expr* Fx = Calculus::integral(M, "x", arena);
+        const Expr* dFy = Fx ? Calculus::derivative(Fx, "y", arena) : nullptr;
+        if (dFy) {
+            const Expr* rest = Calculus::collect(arena.add({ N, Calculus::scale(dFy, -1, 1, arena) }), arena);
+            const Expr* Fy = Calculus::dependsOn(rest, "x") ? nullptr : Calculus::integral(rest, "y", arena);
+            if (Fy) return Calculus::collect(arena.add({ Fx, Fy }), arena);
+        }
+        // term by term integration of the exact form
+        std::vector<ExactTerm> terms;
+        return form.potentialTerms(terms) ? ExactForm::termsToExpr(arena, terms) : nullptr;
+    }
+    // potential function F(x,y) = C
+    std::string potential() {
+        const Expr* F = potentialExpr(ExprArena::shared());
+        return F ? ExprFormat::format(F) + " = C" : "";
+    }
+    // solutionForm
+    std::string solutionForm() override {
+        std::string F = potential();
+        return F.empty() ? "" : "Potential: " + F;
+    }
+    // buildSteps
+    std::vector<SolutionStep> buildSteps() override {
+        ExprArena& arena = ExprArena::shared();
+        const Expr* M;
+        const Expr* N;
+        sides(arena, M, N);
+        std::vector<SolutionStep> steps;
+        steps.push_back({ "M and N", "M = " + ExprFormat::format(M) + ", N = " + ExprFormat::format(N) });
+        const Expr* My = Calculus::derivative(M, "y", arena);
+        const Expr* Nx = Calculus::derivative(N, "x", arena);
+        if (My && Nx) {
+            steps.push_back({ "Exactness check", "dM/dy = " + ExprFormat::format(Calculus::collect(My, arena)) +
+                ", dN/dx = " + ExprFormat::format(Calculus::collect(Nx, arena)) });
+        }
+
+        // same route as potentialExpr(), every call below hits the memo of the first one
+        const Expr* Fx = Calculus::integral(M, "x", arena);
+        const Expr* dFy = Fx ? Calculus::derivative(Fx, "y", arena) : nullptr;
+        const Expr* rest = dFy ? Calculus::collect(arena.add({ N, Calculus::scale(dFy, -1, 1, arena) }), arena) : nullptr;
+        const Expr* Fy = rest && !Calculus::dependsOn(rest, "x") ? Calculus::integral(rest, "y", arena) : nullptr;
+        if (!Fy) {
+            steps.push_back({ "Potential", "term by term, " + form.potential() });
+            return steps;
+        }
+        const Expr* F = Calculus::collect(arena.add({ Fx, Fy }), arena);
+        steps.push_back({ "Integrate M in x", "F = " + ExprFormat::format(Fx) + " + g(y)" });
+        steps.push_back({ "Match N", "g'(y) = N - dF/dy = " + ExprFormat::format(rest) + ", g(y) = " + ExprFormat::format(Fy) });
+        steps.push_back({ "Potential", ExprFormat::format(F) + " = C" });
+        ExprProgram program;
+        if (ExprProgram::compile(F, { "x", "y" }, program)) {
+            const double point[] = { 1.0, 1.0 };
+            steps.push_back({ "Initial condition", "through (1, 1): C = " + PolynomialRoots::formatNumber(program.eval(point)) });
+        }
+        return steps;
+    }
+    // toExpr
+    const Expr* toExpr(ExprArena& arena) override {
+        const Expr* x = arena.var("x");
+        const Expr* y = arena.var("y");
+        const Expr* dx = arena.differential("x");
+        const Expr* dy = arena.differential("y");
+        const Expr* zero = arena.constant(0);
+        if (equationType == 1) {
+            //type 1: ln-based equation
+            return arena.equation(arena.add({
+                arena.mul({ arena.constant(a), arena.func("ln", y), dy }),
+                arena.mul({ arena.constant(b), arena.func("ln", x), dx }) }), zero);
+        }
+        else if (equationType == 2) {
+            //type 2: kx-based equation
+            return arena.equation(arena.add({
+                arena.mul({ arena.constant(a * c), y, dy }),
+                arena.mul({ arena.constant(b * c), x, dx }) }), zero);
+        }
+        //type 3: M dx + N dy from a random potential
+        return arena.equation(arena.add({
+            arena.mul({ ExactForm::termsToExpr(arena, form.M), dx }),
+            arena.mul({ ExactForm::termsToExpr(arena, form.N), dy }) }), zero);
+    }
+    // slope
+    const Expr* slope(ExprArena& arena) override {
+        // M dx + N dy = 0 gives y' = -M/N
+        const Expr* M;
+        const Expr* N;
+        sides(arena, M, N);
+        return arena.div(arena.neg(M), N);
+    }
+    // key
+    EquationKey key() override {
+        // "... = 0" is unchanged by a common factor, so the coefficients are gcd-normalized.
+        // Every type builds form, and the key is taken from it alone, so the same M and N
+        // made by two types are the same equation
+        EquationKey k;
+        k.family = 7;
+        size_t from = form.appendKey(k.coeffs);
+        CoefficientKey::normalize(k.coeffs, from);
+        return k;
+    }
+    // toString
+    std::string toString() override {
+        return "Generated Exact Equation:\n" + ExprFormat::format(toExpr(ExprArena::shared()));
+    }
+};
+
+//class Seperable Equation
+class SeparableEquation : public Equation {
+private:
+    int p, q; // coefficients for the separable equation
+
+public:
+    // Constructor
+    SeparableEquation() : p(Random::next() % 10 + 1), q(Random::next() % 10 + 1) {}
+    // solutionForm
+    std::string solutionForm() override {
+        // integrate both sides
+        ExprArena& arena = ExprArena::shared();
+        const Expr* one = arena.constant(1);
+        const Expr* lhs = Calculus::integral(arena.div(one, arena.mul({ arena.constant(p), arena.var("y") })), "y", arena);
+        const Expr* rhs = Calculus::integral(arena.div(one, arena.mul({ arena.constant(q), arena.var("x") })), "x", arena);
+        return ExprFormat::format(arena.equation(lhs, arena.add({ rhs, arena.var("C") })));
+    }
+    // buildSteps
+    std::vector<SolutionStep> buildSteps() override {
+        // (1/p)ln(y) = (1/q)ln(x) + C, so y = Kx^(p/q)
+        ExprArena& arena = ExprArena::shared();
+        const Expr* x = arena.var("x");
+        Rational power(p, q);
+        const Expr* xp = power == 1 ? x : arena.pow(x, power.toExpr(arena));
+        std::vector<SolutionStep> steps;
+        steps.push_back({ "Separate variables", ExprFormat::format(toExpr(arena)) });
+        steps.push_back({ "Integrate both sides", solutionForm() });
+        steps.push_back({ "Solve for y", "multiply by " + std::to_string(p) + " and exponentiate, y = " + ExprFormat::format(arena.mul({ arena.var("K"), xp })) });
+        steps.push_back({ "Initial condition", "y(1) = 1 gives K = 1, y = " + ExprFormat::format(xp) });
+        return steps;
+    }
+    // toExpr
+    const Expr* toExpr(ExprArena& arena) override {
+        return arena.equation(
+            arena.div(arena.differential("y"), arena.mul({ arena.constant(p), arena.var("y") })),
+            arena.div(arena.differential("x"), arena.mul({ arena.constant(q), arena.var("x") })));
+    }
+    // slope
+    const Expr* slope(ExprArena& arena) override {
+        // y' = p y / (q x)
+        return arena.div(arena.mul({ arena.constant(p), arena.var("y") }), arena.mul({ arena.constant(q), arena.var("x") }));
+    }
+    // key
+    EquationKey key() override {
+        // dy/(py) = dx/(qx) only depends on p : q
+        EquationKey k;
+        k.family = 6;
+        k.coeffs = { p, q };
+        CoefficientKey::normalize(k.coeffs);
+        return k;
+    }
+    // toString
+    std::string toString() override {
+        return "Generated Separable Equation:\n" + ExprFormat::format(toExpr(ExprArena::shared()));
+    }
+};
+
+//class Laplace Transform Equation
+class LaplaceTransformEquation : public Equation {
+private:
+    int a, b, c; // coefficients for the differential equation
+    int trigChoice; // determines if sin, cos, or both are included
+
+    // forcing s sin(ct) + k cos(ct), particular solution A sin(ct) + B cos(ct)
+    void particular(Rational& sinPart, Rational& cosPart, Rational& A, Rational& B) {
+        sinPart = trigChoice == 1 ? 0 : b;
+        cosPart = trigChoice == 0 ? 0 : (trigChoice == 1 ? b : 1);
+        Rational norm = Rational(a) * a + Rational(c) * c;
+        A = (Rational(a) * sinPart + Rational(c) * cosPart) / norm;
+        B = (Rational(a) * cosPart - Rational(c) * sinPart) / norm;
+    }
+    // y(t) for y(0) = 0, the residue of Y(s) at s = -a is -B
+    const Expr* timeDomain(ExprArena& arena) {
+        Rational sinPart, cosPart, A, B;
+        particular(sinPart, cosPart, A, B);
+        const Expr* t = arena.var("t");
+        const Expr* ct = arena.mul({ arena.constant(c), t });
+        return Rational::combination(arena, { A, B, -B },
+            { arena.func("sin", ct), arena.func("cos", ct), arena.func("exp", arena.mul({ arena.constant(-a), t })) });
+    }
+
+public:
+    // Constructor
+    LaplaceTransformEquation()
+        : a(Random::next() % 10 + 1), b(Random::next() % 10 + 1), c(Random::next() % 10 + 1), trigChoice(Random::next() % 3) {
+    }
+    // toExpr
+    const Expr* toExpr(ExprArena& arena) override {
+        const Expr* t = arena.var("t");
+        const Expr* y = arena.func("y", t);
+        const Expr* ct = arena.mul({ arena.constant(c), t });
+        const Expr* lhs = arena.add({ arena.deriv(y, "t", 1, DerivStyle::Prime), arena.mul({ arena.constant(a), y }) });
+
+        // Randomly decide to use sin, cos, or both
+        const Expr* rhs;
+        if (trigChoice == 0) {
+            rhs = arena.mul({ arena.constant(b), arena.func("sin", ct) });
+        }
+        else if (trigChoice == 1) {
+            rhs = arena.mul({ arena.constant(b), arena.func("cos", ct) });
+        }
+        else {
+            rhs = arena.add({ arena.mul({ arena.constant(b), arena.func("sin", ct) }), arena.func("cos", ct) });
+        }
+        return arena.equation(lhs, rhs);
+    }
+    // solutionForm
+    std::string solutionForm() override {
+        ExprArena& arena = ExprArena::shared();
+        return "Y(s) = F(s)/(s + " + std::to_string(a) + ")\ny(t) = " + ExprFormat::format(timeDomain(arena)) + " for y(0) = 0";
+    }
+    // buildSteps
+    std::vector<SolutionStep> buildSteps() override {
+        ExprArena& arena = ExprArena::shared();
+        Rational sinPart, cosPart, A, B;
+        particular(sinPart, cosPart, A, B);
+        const Expr* s = arena.var("s");
+        const Expr* pole = arena.add({ s, arena.constant(a) });
+        const Expr* quadratic = arena.add({ arena.pow(s, 2), arena.constant(c * c) });
+        // L{sin(ct)} = c/(s^2 + c^2), L{cos(ct)} = s/(s^2 + c^2)
+        const Expr* numerator = Rational::combination(arena, { cosPart, sinPart * c }, { s, nullptr });
+        const Expr* F = arena.div(numerator, quadratic);
+
+        std::vector<SolutionStep> steps;
+        steps.push_back({ "Transform", "sY(s) - y(0) + " + (a == 1 ? std::string() : std::to_string(a)) + "Y(s) = " + ExprFormat::format(F) });
+        steps.push_back({ "Solve for Y(s)", "y(0) = 0 gives Y(s) = " + ExprFormat::format(arena.div(numerator, arena.mul({ pole, quadratic }))) });
+        steps.push_back({ "Partial fractions", "Y(s) = K/(" + ExprFormat::format(pole) + ") + (Bs + D)/(" + ExprFormat::format(quadratic) + ")" +
+            " with B = " + B.toString() + ", D = " + (A * c).toString() });
+        steps.push_back({ "Residue at s = " + std::to_string(-a), "(s + " + std::to_string(a) + ")Y(s) at s = " + std::to_string(-a) + " is K = " + (-B).toString() });
+        steps.push_back({ "Invert", "y(t) = " + ExprFormat::format(timeDomain(arena)) });
+        return steps;
+    }
+    // slope
+    const Expr* slope(ExprArena& arena) override {
+        // y' = forcing - a y, the rhs of toExpr with y(t) read as the plain variable y
+        const Expr* forcing = toExpr(arena)->args[1];
+        return arena.add({ forcing, arena.mul({ arena.constant(-a), arena.var("y") }) });
+    }
+    // independentVariable
+    std::string independentVariable() override { return "t"; }
+    // key
+    EquationKey key() override {
+        EquationKey k;
+        k.family = 8;
+        k.coeffs = { a, b, c, trigChoice };
+        return k;
+    }
+    // toString
+    std::string toString() override {
+        return "Generated Laplace Equation:\n" + ExprFormat::format(toExpr(ExprArena::shared()));
+    }
+};
+
+//class Frobenius Series Equation
+class FrobeniusEquation : public Equation {
+private:
+    int half, whole; // indicial roots half/2 and whole, never an integer apart
+    int a1;         // A(x) = 2 + a1 x
+    int b0, b1;     // B(x) = b0 + b1 x
+    int c0, c1, q;  // C(x) = c0 + c1 x e^(qx), q = 0 leaves C linear
+    // both series solutions, solved when first needed and again after the terms setting changes
+    std::vector<double> series[2];
+    double residuals[2] = { 0.0, 0.0 };
+    bool solvable = true;
+    int solvedTerms = 0;
+
+    // A, B, C of x^2 A(x) y'' + x B(x) y' + C(x) y = 0 to n coefficients, as T
+    template <class T>
+    void coefficientSeries(int n, std::vector<T>& A, std::vector<T>& B, std::vector<T>& C) const {
+        A = { T(2), T(a1) };
+        B = { T(b0), T(b1) };
+        // c1 x e^(qx) = sum of c1 q^(m-1)/(m-1)! x^m
+        C.assign(n > 2 ? n : 2, T(0));
+        C[0] = T(c0);
+        T term = T(c1);
+        for (int m = 1; m < (int)C.size(); m++) {
+            C[m] = term;
+            if (q == 0) break;
+            term = term * T(q) / T(m);
+        }
+    }
+    Rational root(int i) const { return i == 0 ? Rational(half, 2) : Rational(whole); }
+    void solve() {
+        if (solvedTerms == terms) return;
+        solvedTerms = terms;
+        // exp series composed with qx, the products behind it are Karatsuba-sized for long series
+        std::vector<double> A = { 2.0, double(a1) }, B = { double(b0), double(b1) }, C(terms > 2 ? terms : 2, 0.0);
+        std::vector<double> E(terms, 1.0);
+        for (int m = 1; m < terms; m++) E[m] = E[m - 1] / m;
+        std::vector<double> eq = PowerSeries::compose(E, { 0.0, double(q) }, terms);
+        C[0] = c0;
+        for (int m = 1; m < (int)C.size(); m++) C[m] = c1 * eq[m - 1];
+        solvable = true;
+        for (int i = 0; i < 2; i++) {
+            double r = root(i).toDouble();
+            solvable = FrobeniusSolver::solve(A, B, C, r, terms, series[i]) && solvable;
+            residuals[i] = FrobeniusSolver::residual(A, B, C, r, series[i]);
+        }
+    }
+    // x^r (1 + a1 x + ...) with the first few coefficients exact
+    std::string leadingTerms(int i) {
+        ExprArena& arena = ExprArena::shared();
+        const int shown = 5;
+        std::vector<Rational> A, B, C, a;
+        coefficientSeries(shown, A, B, C);
+        FrobeniusSolver::coefficients(A, B, C, root(i), shown, a);
+        const Expr* x = arena.var("x");
+        std::vector<const Expr*> powers;
+        for (int n = 0; n < shown; n++) powers.push_back(n == 0 ? nullptr : n == 1 ? x : arena.pow(x, n));
+        std::string sum = ExprFormat::format(Rational::combination(arena, a, powers)) + " + ...";
+        Rational r = root(i);
+        if (r == 0) return sum;
+        return ExprFormat::format(r == 1 ? x : arena.pow(x, r.toExpr(arena))) + "*(" + sum + ")";
+    }
+    // y1(0.5), y2(0.5) from the full series
+    std::string answerKey() {
+        solve();
+        std::string s;
+        for (int i = 0; i < 2; i++) {
+            double v = std::pow(0.5, root(i).toDouble()) * FrobeniusSolver::evaluate(series[i], 0.5);
+            s += (i ? ", y2(0.5) = " : "y1(0.5) = ") + PolynomialRoots::formatNumber(v);
+        }
+        return s;
+    }
+    std::string verification() {
+        solve();
+        char buffer[96];
+        snprintf(buffer, sizeof(buffer), "%d terms each, largest residual %.1e", terms, std::max(residuals[0], residuals[1]));
+        return solvable ? buffer : "recurrence broke down";
+    }
+
+public:
+    static thread_local int terms; // series terms solved and verified per solution
+
+    // Constructor
+    FrobeniusEquation() {
+        // (2r - half)(r - whole) = 2r^2 + (b0 - 2)r + c0 with half odd, so the roots differ by a half-integer
+        half = 2 * (Random::next() % 4) - 3;
+        whole = Random::next() % 5 - 2;
+        b0 = 2 - half - 2 * whole;
+        c0 = half * whole;
+        a1 = Random::next() % 3;
+        b1 = Random::next() % 7 - 3;
+        c1 = (Random::next() % 3 + 1) * (Random::next() % 2 ? 1 : -1);
+        q = Random::next() % 4 - 1;
+    }
+    // solutionForm
+    std::string solutionForm() override {
+        return "Indicial Roots: " + root(0).toString() + ", " + root(1).toString() + "\n"
+            "y1 = " + leadingTerms(0) + "\ny2 = " + leadingTerms(1) + "\ny = C1y1 + C2y2\n" + verification() + "\n" + answerKey();
+    }
+    // buildSteps
+    std::vector<SolutionStep> buildSteps() override {
+        ExprArena& arena = ExprArena::shared();
+        const Expr* x = arena.var("x");
+        const Expr* r = arena.var("r");
+        // p = B/A and q = C/A, the standard form y'' + (p/x)y' + (q/x^2)y = 0
+        const int shown = 4;
+        std::vector<double> A, B, C;
+        coefficientSeries(shown, A, B, C);
+        std::vector<double> p = PowerSeries::divide(B, A, shown), qs = PowerSeries::divide(C, A, shown);
+        auto head = [&](const std::vector<double>& c) {
+            std::vector<const Expr*> terms;
+            for (int n = 0; n < shown; n++) {
+                if (c[n] != 0.0) terms.push_back(arena.mul({ arena.constant(std::round(c[n] * 1000.0) / 1000.0), n == 0 ? arena.constant(1) : arena.pow(x, n) }));
+            }
+            return (terms.empty() ? std::string("0") : ExprFormat::format(arena.add(terms))) + " + ...";
+        };
+        std::vector<const Expr*> indicial = { arena.mul({ arena.constant(2), arena.pow(r, 2) }) };
+        if (b0 != 2) indicial.push_back(arena.mul({ arena.constant(b0 - 2), r }));
+        if (c0 != 0) indicial.push_back(arena.constant(c0));
+
+        std::vector<SolutionStep> steps;
+        steps.push_back({ "Regular singular point", "x = 0, with p(x) = B/A = " + head(p) + " and q(x) = C/A = " + head(qs) + " analytic there" });
+        std::vector<const Expr*> trial = { arena.mul({ arena.constant(2), r, arena.add({ r, arena.constant(-1) }) }) };
+        if (b0 != 0) trial.push_back(arena.mul({ arena.constant(b0), r }));
+        if (c0 != 0) trial.push_back(arena.constant(c0));
+        Rational gap = root(0) - root(1);
+        steps.push_back({ "Indicial equation", ExprFormat::format(arena.add(trial)) + " = " +
+            ExprFormat::format(arena.equation(arena.add(indicial), arena.constant(0))) });
+        steps.push_back({ "Indicial roots", root(0).toString() + " and " + root(1).toString() + ", " + (gap.sign() < 0 ? -gap : gap).toString() +
+            " apart, so neither series needs a log term" });
+        steps.push_back({ "Recurrence", "F(n + r)a_n = -(sum over k >= 1 of [A_k(m + r)(m + r - 1) + B_k(m + r) + C_k]a_m), m = n - k" });
+        steps.push_back({ "First solution", "y1 = " + leadingTerms(0) });
+        steps.push_back({ "Second solution", "y2 = " + leadingTerms(1) });
+        steps.push_back({ "General solution", "y = C1y1 + C2y2" });
+        steps.push_back({ "Verification", verification() });
+        steps.push_back({ "Values", answerKey() });
+        return steps;
+    }
+    // toExpr
+    const Expr* toExpr(ExprArena& arena) override {
+        const Expr* x = arena.var("x");
+        const Expr* y = arena.var("y");
+        auto linear = [&](int c, const Expr* term) {
+            // c + term with zero parts dropped
+            if (!term) return arena.constant(c);
+            return c == 0 ? term : arena.add({ arena.constant(c), term });
+        };
+        const Expr* A = linear(2, a1 == 0 ? nullptr : arena.mul({ arena.constant(a1), x }));
+        const Expr* B = linear(b0, b1 == 0 ? nullptr : arena.mul({ arena.constant(b1), x }));
+        const Expr* C = linear(c0, arena.mul({ arena.constant(c1), x, q == 0 ? arena.constant(1) : arena.func("exp", arena.mul({ arena.constant(q), x })) }));
+        std::vector<const Expr*> terms = { arena.mul({ arena.pow(x, 2), A, arena.deriv(y, "x", 2) }) };
+        if (b0 != 0 || b1 != 0) terms.push_back(arena.mul({ x, B, arena.deriv(y, "x") }));
+        terms.push_back(arena.mul({ C, y }));
+        return arena.equation(arena.add(terms), arena.constant(0));
+    }
+    // key
+    EquationKey key() override {
+        EquationKey k;
+        k.family = 9;
+        k.coeffs = { a1, b0, b1, c0, c1, q };
+        return k;
+    }
+    // toString
+    std::string toString() override {
+        return "Generated Frobenius Series Equation:\n" + ExprFormat::format(toExpr(ExprArena::shared()));
+    }
+};
+
+// Everything an equation depends on besides its random seed. The generators read the
+// settings statics of the thread they run on, so the prefetch thread applies a copy first
+struct GeneratorSettings {
+    int choice = 0;
+    bool homogeneous = true, variableCoefficient = false, inverse = false;
+    int order = 2, dimension = 2, terms = 20;
+
+    // the calling thread's settings
+    static GeneratorSettings current(int choice) {
+        GeneratorSettings s;
+        s.choice = choice;
+        s.homogeneous = FirstOrderLinearEquation::isHomogeneous;
+        s.variableCoefficient = FirstOrderLinearEquation::hasVariableCoefficient;
+        s.inverse = InverseGenerator::enabled;
+        s.order = HigherOrderEquation::order;
+        s.dimension = SystemOfEquations::dimension;
+        s.terms = FrobeniusEquation::terms;
+        return s;
+    }
+    void apply() const {
+        FirstOrderLinearEquation::isHomogeneous = homogeneous;
+        FirstOrderLinearEquation::hasVariableCoefficient = variableCoefficient;
+        InverseGenerator::enabled = inverse;
+        HigherOrderEquation::order = order;
+        SystemOfEquations::dimension = dimension;
+        FrobeniusEquation::terms = terms;
+    }
+    bool operator==(const GeneratorSettings& o) const {
+        return choice == o.choice && homogeneous == o.homogeneous && variableCoefficient == o.variableCoefficient &&
+            inverse == o.inverse && order == o.order && dimension == o.dimension && terms == o.terms;
+    }
+};
+
+// A generated equation with its key and the text the display window opens with
+struct PreparedEquation {
+    std::shared_ptr<Equation> equation;
+    GeneratorSettings settings;
+    unsigned seed = 0;      // the equation is generateEquation(settings.choice) after Random::Scope(seed)
+    EquationKey key;
+    std::string text;
+    ExprProgram slope;  // empty when the equation has no slope field
+};
+
+//class Equation Generator
+class EquationGenerator {
+public:
+    // generateEquation
+    static std::shared_ptr<Equation> generateEquation(int choice) {
+        // equations keep no nodes, they build their expressions again when asked, so the
+        // thread's arena only holds scratch from earlier equations by now
+        ExprArena::shared().release();
+        if (choice == 1) {
+            return std::make_shared<FirstOrderLinearEquation>();
+        }
+        else if (choice == 2) {
+            return std::make_shared<CauchyEulerEquation>();
+        }
+        else if (choice == 3) {
+            return std::make_shared<HigherOrderEquation>();
+        }
+        else if (choice == 4) {
+            return std::make_shared<PartialEquation>();
+        }
+        else if (choice == 5) {
+            return std::make_shared<SystemOfEquations>();
+        }
+        else if (choice == 6) {
+            return std::make_shared<SeparableEquation>();
+        }
+        else if (choice == 7) {
+            return std::make_shared<ExactEquation>();
+        }
+        else if (choice == 8) {
+            return std::make_shared<LaplaceTransformEquation>();
+        }
+        else if (choice == 9) {
+            return std::make_shared<FrobeniusEquation>();
+        }
+        else {
+            std::cout << "Invalid choice. Returning nullptr.\n";
+            return nullptr;
+        }
+    }
+    // prepare, one equation from the seed with its key, text and slope program, on whichever thread calls it.
+    // Its solution, canonical form and steps wait until the display window asks for them
+    static PreparedEquation prepare(const GeneratorSettings& settings, unsigned seed) {
+        PROFILE_ZONE("EquationGenerator::prepare");
+        settings.apply();
+        Random::Scope random(seed);
+        return finish(settings, seed, generateEquation(settings.choice));
+    }
+    // prepareBatch, the equations prepare() makes from seed, seed + 1, ... seed + count - 1.
+    // Higher-Order equations are made together so their characteristic roots share one batch
+    static std::vector<PreparedEquation> prepareBatch(const GeneratorSettings& settings, unsigned seed, size_t count) {
+        PROFILE_ZONE("EquationGenerator::prepareBatch");
+        std::vector<PreparedEquation> batch;
+        if (settings.choice != 3) {
+            for (size_t i = 0; i < count; i++) batch.push_back(prepare(settings, seed + (unsigned)i));
+            return batch;
+        }
+        settings.apply();
+        ExprArena::shared().release();
+        std::vector<std::shared_ptr<HigherOrderEquation>> equations = HigherOrderEquation::generateBatch(seed, count);
+        for (size_t i = 0; i < count; i++) batch.push_back(finish(settings, seed + (unsigned)i, equations[i]));
+        return batch;
+    }
+    // finish, the key, text and slope program of an equation made from settings and seed
+    static PreparedEquation finish(const GeneratorSettings& settings, unsigned seed, const std::shared_ptr<Equation>& equation) {
+        PreparedEquation p;
+        p.settings = settings;
+        p.seed = seed;
+        p.equation = equation;
+        if (!p.equation) {
+            return p;
+        }
+        ExprArena& arena = ExprArena::shared();
+        p.key = p.equation->key();
+        p.text = p.equation->toString();
+        const Expr* f = p.equation->slope(arena);
+        if (f && !ExprProgram::compile(f, { p.equation->independentVariable(), "y" }, p.slope)) {
+            p.slope = ExprProgram();
+        }
+        return p;
+    }
+
+    static DedupIndex history; // keys of the equations generated so far
+};
+
+
+// generator settings are per thread: the prefetch thread makes equations from its own copy
+thread_local bool FirstOrderLinearEquation::isHomogeneous = true;  // default value
+thread_local bool FirstOrderLinearEquation::hasVariableCoefficient = false;  // default value
+thread_local int HigherOrderEquation::order = 2;  // default value
+thread_local int SystemOfEquations::dimension = 2;  // default value
+thread_local int FrobeniusEquation::terms = 20;  // default value
+DedupIndex EquationGenerator::history;
+
+// App Namespace for imgui implementation
+namespace App {
+
+    //Declarations
+    static std::string name = "9th Grade Algebra expert";
+
+    static bool show_demo_window = false;
+    static bool equation_selection_window = true;
+    static bool equation_display_window = false;
+    static bool first_order_helper_window = false;
+
+    static int equation_choice = 2;
+    static int last_equation_choice = 0;
+
+    // smart pointer to selected equation
+    static std::shared_ptr<Equation> current_equation = std::make_shared<FirstOrderLinearEquation>();
+
+    // compiled slope of the displayed equation, rebuilt when the equation changes
+    static ExprProgram slope_program;
+    static std::shared_ptr<Equation> slope_program_owner;
+
+    // residual checker for the displayed equation, prepared when the equation changes
+    static AnswerGrader answer_grader;
+    static std::shared_ptr<Equation> answer_grader_owner;
+
+    // body of the selection window, redrawn only when its settings or the mouse over it change
+    static RetainedDrawList selection_window_cache;
+
+    // display strings of the current equation, built when the equation changes
+    static std::string equation_text, solution_text, canonical_text;
+    static std::shared_ptr<Equation> equation_text_owner;
+
+    // equations for the selected type made ahead on a background thread, restarted when the settings change
+    // eight deep, so a Higher-Order batch fills the root finder's lanes
+    static Prefetcher<PreparedEquation, GeneratorSettings, PolynomialRoots::Lanes> prefetcher(EquationGenerator::prepareBatch);
+    static GeneratorSettings prefetch_settings;
+    static bool prefetch_started = false;
+    // Generate was clicked and the thread hasn't made the equation yet; duplicates skipped so far
+    static bool equation_pending = false;
+    static int pending_attempts = 0;
+    // wait for the thread instead of showing a placeholder, so every run draws the same frames
+    static bool wait_for_equations = false;
+
+    // every equation handed out this session, and whether its window is open
+    static EquationHistory session_history;
+    static bool history_window = false;
+
+    // restarts the prefetcher when the type or any generator setting has changed
+    void UpdatePrefetch() {
+        GeneratorSettings settings = GeneratorSettings::current(equation_choice);
+        if (!prefetch_started || !(settings == prefetch_settings)) {
+            prefetch_started = true;
+            prefetch_settings = settings;
+            prefetcher.restart(settings, (unsigned)Random::next());
+        }
+    }
+    // next prefetched equation that (up to a common factor) wasn't handed out before, false while
+    // the thread is still making it. attempts counts the duplicates across calls
+    bool TakeUniqueEquation(PreparedEquation& prepared, int& attempts) {
+        for (; attempts < 16; attempts++) {
+            if (!prefetcher.take(prepared, wait_for_equations)) {
+                return false;
+            }
+            if (!prepared.equation || EquationGenerator::history.insert(prepared.key)) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    // shows a prepared equation in the display window, its text and slope program already made
+    void ShowPreparedEquation(PreparedEquation& prepared) {
+        current_equation = prepared.equation; // Update current equation
+        equation_text = std::move(prepared.text);
+        solution_text.clear();
+        canonical_text.clear();
+        equation_text_owner = current_equation;
+        slope_program = std::move(prepared.slope);
+        slope_program_owner = current_equation;
+        equation_display_window = true;
+    }
+
+    // history row of an equation: its settings, seed and key coefficients
+    EquationHistory::Row HistoryRow(const GeneratorSettings& settings, unsigned seed, const EquationKey& key) {
+        EquationHistory::Row row;
+        row.coefficients = EquationHistory::packCoefficients(key.coeffs);
+        row.seed = seed;
+        row.terms = (uint16_t)settings.terms;
+        row.type = (uint8_t)settings.choice;
+        row.flags = (uint8_t)((settings.homogeneous ? EquationHistory::Homogeneous : 0) |
+            (settings.variableCoefficient ? EquationHistory::VariableCoefficient : 0) | (settings.inverse ? EquationHistory::Inverse : 0));
+        row.order = (uint8_t)settings.order;
+        row.dimension = (uint8_t)settings.dimension;
+        row.coefficientCount = (uint8_t)std::min<size_t>(key.coeffs.size(), 255);
+        return row;
+    }
+    GeneratorSettings HistorySettings(const EquationHistory::Row& row) {
+        GeneratorSettings settings;
+        settings.choice = row.type;
+        settings.homogeneous = (row.flags & EquationHistory::Homogeneous) != 0;
+        settings.variableCoefficient = (row.flags & EquationHistory::VariableCoefficient) != 0;
+        settings.inverse = (row.flags & EquationHistory::Inverse) != 0;
+        settings.order = row.order;
+        settings.dimension = row.dimension;
+        settings.terms = row.terms;
+        return settings;
+    }
+
+    // shows the equation Generate asked for once the thread has made it
+    void UpdatePendingEquation() {
+        if (!equation_pending) {
+            return;
+        }
+        PreparedEquation prepared;
+        if (!TakeUniqueEquation(prepared, pending_attempts)) {
+            return;
+        }
+        equation_pending = false;
+        if (prepared.equation) {
+            session_history.add(HistoryRow(prepared.settings, prepared.seed, prepared.key));
+        }
+        ShowPreparedEquation(prepared);
+    }
+
+    // the equation settings and seed make, on the UI thread, whose own settings are put back after
+    std::shared_ptr<Equation> GenerateWith(const GeneratorSettings& settings, unsigned seed) {
+        GeneratorSettings saved = GeneratorSettings::current(equation_choice);
+        settings.apply();
+        std::shared_ptr<Equation> equation;
+        {
+            Random::Scope random(seed);
+            equation = EquationGenerator::generateEquation(settings.choice);
+        }
+        saved.apply();
+        return equation;
+    }
+
+    // text of a history row: the equation without the heading line toString starts with
+    std::string DescribeHistoryRow(const EquationHistory::Row& row) {
+        std::shared_ptr<Equation> equation = GenerateWith(HistorySettings(row), row.seed);
+        if (!equation) {
+            return "";
+        }
+        std::string text = equation->toString();
+        size_t heading = text.find(":\n");
+        if (heading != std::string::npos) text.erase(0, heading + 2);
+        std::replace(text.begin(), text.end(), '\n', ' ');
+        return text;
+    }
+
+    void FillHistory(int rows) {
+        // at most a few hundred distinct equations, generating is what takes the time
+        std::vector<EquationHistory::Row> made;
+        GeneratorSettings settings = GeneratorSettings::current(equation_choice);
+        for (int i = 0; i < rows && i < 512; i++) {
+            settings.choice = i % 9 + 1;
+            unsigned seed = (unsigned)Random::next();
+            std::shared_ptr<Equation> equation = GenerateWith(settings, seed);
+            if (equation) made.push_back(HistoryRow(settings, seed, equation->key()));
+        }
+        for (int i = 0; i < rows && !made.empty(); i++) {
+            session_history.add(made[i % made.size()]);
+        }
+    }
+
+    // mutator for FirstOrderParametersWindow
+    void setFirstOrderHelperBool(bool val) {
+        first_order_helper_window = val;
+    }
+    // Renders First Order Linear Equation Helper Popup
+    void RenderFirstOrderParametersWindow() {
+        TRACK_ALLOCATIONS("RenderFirstOrderParametersWindow");
+        PROFILE_ZONE("RenderFirstOrderParametersWindow");
+        if (first_order_helper_window && std::dynamic_pointer_cast<FirstOrderLinearEquation>(current_equation)) {
+            ImGui::OpenPopup("First Order Linear");
+        }
+
+        if (ImGui::BeginPopupModal("First Order Linear", &first_order_helper_window, ImGuiWindowFlags_AlwaysAutoResize)) {
+            ImGui::Text("Configure Equation Parameters");
+            ImGui::Separator();
+
+            FirstOrderLinearEquation* eq = dynamic_cast<FirstOrderLinearEquation*>(current_equation.get());
+            if (eq) {
+                // Ask if the equation is homogeneous
+                ImGui::Checkbox("Homogeneous?", &eq->isHomogeneous);
+
+                // Ask if the equation has variable coefficient
+                ImGui::Checkbox("Variable coefficient?", &eq->hasVariableCoefficient);
+
+                // Confirm Button Logic
+                if (ImGui::Button("Confirm")) {
+                    // a new equation for the new options rather than changing this one in place:
+                    // the text, slope field and grader cached for the old one are keyed on its
+                    // pointer. It comes from the prefetch thread, restarted with the new options,
+                    // like Generate's, so it's deduplicated and gets a history row
+                    UpdatePrefetch();
+                    equation_pending = true;
+                    pending_attempts = 0;
+                    equation_display_window = true;
+                    UpdatePendingEquation();
+                    // Close the helper window
+                    ImGui::CloseCurrentPopup();
+                    first_order_helper_window = false;
+                }
+            }
+
+            ImGui::EndPopup();
+        }
+    }
+
+    // Renders Main Equation Generation Window
+    void RenderEquationSelectionWindow() {
+        TRACK_ALLOCATIONS("RenderEquationSelectionWindow");
+        PROFILE_ZONE("RenderEquationSelectionWindow");
+        if (equation_selection_window) {
+            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(800.0f, 600.0f), ImGuiCond_Always);
+
+            ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.9f, 0.95f, 1.0f, 1.0f));
+
+            ImGui::Begin("Generate Equation", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBringToFrontOnFocus);
+            // everything the body below draws from
+            const int settings[] = { equation_choice, HigherOrderEquation::order, SystemOfEquations::dimension, FrobeniusEquation::terms, InverseGenerator::enabled, history_window };
+            if (!selection_window_cache.replay(settings, sizeof(settings))) {
+                selection_window_cache.record();
+                // Dropdown of buttons to select the type of equation to generate
+                float windowWidth = ImGui::GetContentRegionAvail().x;
+                float textWidth = TextLayoutCache::shared().size("Select Equation Type:").x;
+
+                ImGui::SetCursorPosX((windowWidth - textWidth) * 0.5f);
+                ImGui::Text("Select Equation Type:");
+
+                /*ImGui::Text("test: %d, %d", equation_choice, last_equation_choice);
+                FirstOrderLinearEquation* eq = dynamic_cast<FirstOrderLinearEquation*>(current_equation.get());
+                if (eq) {
+                    // Text command reflecting instance data
+                    ImGui::Text("test: %s, %s",
+                        eq->isHomogeneous ? "true" : "false",
+                        eq->hasVariableCoefficient ? "true" : "false");
+                } testing */
+
+                ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 10);
+                // creating radio buttons
+                const char* labels[] = { "First-Order Linear", "Cauchy-Euler", "Higher-Order", "Partial ", "System of Equations", "Seperable", "Exact", "Laplace Transform", "Frobenius Series"};
+                for (int i = 0; i < 9; i++) {
+                    textWidth = TextLayoutCache::shared().size(labels[i]).x;
+                    ImGui::SetCursorPosX((windowWidth - textWidth) * 0.5f - 20.0f);
+                    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 2);
+                    ImGui::RadioButton(labels[i], &equation_choice, i + 1);
+                    selection_window_cache.item();
+                }
+                ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 20);
+
+                // order slider for Higher-Order equations
+                if (equation_choice == 3) {
+                    ImGui::SetCursorPosX((windowWidth - 200) * 0.5f);
+                    ImGui::SetNextItemWidth(200);
+                    ImGui::SliderInt("Order", &HigherOrderEquation::order, 2, 12);
+                    selection_window_cache.item();
+                    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 10);
+                }
+
+                // dimension slider for Systems of Equations
+                if (equation_choice == 5) {
+                    ImGui::SetCursorPosX((windowWidth - 200) * 0.5f);
+                    ImGui::SetNextItemWidth(200);
+                    ImGui::SliderInt("Dimension", &SystemOfEquations::dimension, 2, LinearSystem::MaxDimension);
+                    selection_window_cache.item();
+                    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 10);
+                }
+
+                // series length for Frobenius equations
+                if (equation_choice == 9) {
+                    ImGui::SetCursorPosX((windowWidth - 200) * 0.5f);
+                    ImGui::SetNextItemWidth(200);
+                    ImGui::SliderInt("Series terms", &FrobeniusEquation::terms, 5, 400);
+                    selection_window_cache.item();
+                    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 10);
+                }
+
+                // inverse construction for the types with a root structure
+                if (equation_choice == 2 || equation_choice == 3 || equation_choice == 5) {
+                    textWidth = TextLayoutCache::shared().size("Nice answers").x + ImGui::GetFrameHeight();
+                    ImGui::SetCursorPosX((windowWidth - textWidth) * 0.5f);
+                    ImGui::Checkbox("Nice answers", &InverseGenerator::enabled);
+                    selection_window_cache.item();
+                    ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 10);
+                }
+
+                ImGui::SetCursorPosX((windowWidth - 200) * 0.5f);
+                if (ImGui::Button("Generate Equation", ImVec2(200, 50)) && !equation_display_window) {
+                    TRACK_ALLOCATIONS("TakeUniqueEquation");
+                    PROFILE_ZONE("TakeUniqueEquation");
+                    UpdatePrefetch();
+                    equation_pending = true;
+                    pending_attempts = 0;
+                    equation_display_window = true;
+                    UpdatePendingEquation();
+                }
+                selection_window_cache.item();
+
+                textWidth = TextLayoutCache::shared().size("Show history").x + ImGui::GetFrameHeight();
+                ImGui::SetCursorPosX((windowWidth - textWidth) * 0.5f);
+                ImGui::SetCursorPosY(ImGui::GetCursorPosY() + 10);
+                ImGui::Checkbox("Show history", &history_window);
+                selection_window_cache.item();
+                selection_window_cache.commit();
+            }
+
+            if (equation_choice==1 && last_equation_choice!=equation_choice) {
+                first_order_helper_window = true; // Open the helper window
+            }
+            last_equation_choice = equation_choice; // Update the last selection
+            UpdatePrefetch();
+
+            ImGui::End();
+            ImGui::PopStyleColor();
+
+        }
+    }
+
+    // Renders the direction field of y' = f(t, y) on [-3, 3] x [-3, 3]
+    void RenderSlopeField() {
+        TRACK_ALLOCATIONS("RenderSlopeField");
+        PROFILE_ZONE("RenderSlopeField");
+        if (slope_program_owner != current_equation) {
+            slope_program_owner = current_equation;
+            PROFILE_ZONE("ExprProgram::compile");
+            const Expr* f = current_equation->slope(ExprArena::shared());
+            if (!f || !ExprProgram::compile(f, { current_equation->independentVariable(), "y" }, slope_program)) {
+                slope_program = ExprProgram();
+            }
+        }
+        if (slope_program.empty() || !ImGui::CollapsingHeader("Slope Field")) {
+            return;
+        }
+
+        // cell centers, an even grid never lands on the axes where ln and 1/x blow up
+        const int cells = 20;
+        const float size = 300.0f;
+        const double range = 3.0;
+        static std::vector<double> ts(cells * cells), ys(cells * cells), slopes(cells * cells);
+        for (int i = 0; i < cells; i++) {
+            for (int j = 0; j < cells; j++) {
+                ts[i * cells + j] = -range + (j + 0.5) * 2.0 * range / cells;
+                ys[i * cells + j] = range - (i + 0.5) * 2.0 * range / cells;
+            }
+        }
+        const double* inputs[] = { ts.data(), ys.data() };
+        slope_program.evalBatch(inputs, cells * cells, slopes.data());
+
+        ImDrawList* draw = ImGui::GetWindowDrawList();
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        float cell = size / cells;
+        draw->AddRectFilled(origin, ImVec2(origin.x + size, origin.y + size), IM_COL32(255, 255, 255, 255));
+        draw->AddLine(ImVec2(origin.x + size * 0.5f, origin.y), ImVec2(origin.x + size * 0.5f, origin.y + size), IM_COL32(180, 180, 180, 255));
+        draw->AddLine(ImVec2(origin.x, origin.y + size * 0.5f), ImVec2(origin.x + size, origin.y + size * 0.5f), IM_COL32(180, 180, 180, 255));
+        for (int k = 0; k < cells * cells; k++) {
+            double m = slopes[k];
+            if (!std::isfinite(m)) continue;
+            // unit direction (1, m), screen y points down
+            float len = (float)std::sqrt(1.0 + m * m);
+            float dx = 0.35f * cell / len, dy = -0.35f * cell * (float)m / len;
+            float cx = origin.x + (k % cells + 0.5f) * cell, cy = origin.y + (k / cells + 0.5f) * cell;
+            draw->AddLine(ImVec2(cx - dx, cy - dy), ImVec2(cx + dx, cy + dy), IM_COL32(40, 70, 160, 255), 1.5f);
+        }
+        ImGui::Dummy(ImVec2(size, size));
+    }
+
+    // Parses a typed equation and compares its canonical form with the generated one
+    void RenderEquationCheck() {
+        TRACK_ALLOCATIONS("RenderEquationCheck");
+        PROFILE_ZONE("RenderEquationCheck");
+        if (!ImGui::CollapsingHeader("Check Equation")) {
+            return;
+        }
+        static char input[512] = "";
+        ImGui::InputText("##check", input, sizeof(input));
+        if (input[0] == '\0') {
+            return;
+        }
+
+        // parsed and compared again only when the text or the equation changes
+        static std::string checked_input, read_as, parse_error;
+        static std::shared_ptr<Equation> checked_owner;
+        static bool matches = false;
+        if (checked_owner != current_equation || checked_input != input) {
+            checked_owner = current_equation;
+            checked_input = input;
+            ExprArena& arena = ExprArena::shared();
+            ExprParser::Error error;
+            const Expr* parsed;
+            {
+                PROFILE_ZONE("ExprParser::parse");
+                parsed = ExprParser::parse(input, arena, &error);
+            }
+            if (!parsed) {
+                parse_error = error.message + " at position " + std::to_string(error.position);
+            }
+            else {
+                parse_error.clear();
+                read_as = "Read as: " + ExprFormat::format(parsed);
+                // canonical forms are interned, equivalent equations share a pointer
+                PROFILE_ZONE("Simplifier::simplify");
+                matches = Simplifier::simplify(parsed, arena) == Simplifier::simplify(current_equation->toExpr(arena), arena);
+            }
+        }
+        if (!parse_error.empty()) {
+            ImGui::TextColored(ImVec4(0.8f, 0.2f, 0.2f, 1.0f), "%s", parse_error.c_str());
+            return;
+        }
+        ImGui::TextUnformatted(read_as.c_str());
+        if (matches) {
+            ImGui::TextColored(ImVec4(0.2f, 0.6f, 0.2f, 1.0f), "Matches the generated equation");
+        }
+        else {
+            ImGui::Text("Differs from the generated equation");
+        }
+    }
+
+    // Grades a typed solution y = f(x) by substituting it into the equation
+    void RenderSolutionCheck() {
+        TRACK_ALLOCATIONS("RenderSolutionCheck");
+        PROFILE_ZONE("RenderSolutionCheck");
+        ExprArena& arena = ExprArena::shared();
+        if (answer_grader_owner != current_equation) {
+            PROFILE_ZONE("AnswerGrader::prepare");
+            answer_grader_owner = current_equation;
+            answer_grader.prepare(current_equation->toExpr(arena), current_equation->independentVariable(), arena);
+        }
+        if (!answer_grader.ready() || !ImGui::CollapsingHeader("Check Solution")) {
+            return;
+        }
+        static char input[512] = "";
+        ImGui::InputText("##solution", input, sizeof(input));
+        if (input[0] == '\0') {
+            return;
+        }
+
+        // graded again only when the text or the equation changes
+        static GradeResult result;
+        static std::string graded_input;
+        static std::shared_ptr<Equation> graded_owner;
+        if (graded_owner != current_equation || graded_input != input) {
+            graded_owner = current_equation;
+            graded_input = input;
+            PROFILE_ZONE("AnswerGrader::grade");
+            result = answer_grader.grade(input, arena);
+        }
+        if (result.verdict == Verdict::Correct) {
+            ImGui::TextColored(ImVec4(0.2f, 0.6f, 0.2f, 1.0f), "%s", result.message.c_str());
+        }
+        else {
+            ImGui::TextColored(ImVec4(0.8f, 0.2f, 0.2f, 1.0f), "%s", result.message.c_str());
+        }
+    }
+
+    // Worked solution of the displayed equation, derived the first time this is opened or exported
+    void RenderSolutionSteps() {
+        TRACK_ALLOCATIONS("RenderSolutionSteps");
+        PROFILE_ZONE("RenderSolutionSteps");
+        if (!ImGui::CollapsingHeader("Step-by-Step Solution")) {
+            return;
+        }
+        const std::vector<SolutionStep>* derived;
+        {
+            PROFILE_ZONE("Equation::steps");
+            derived = &current_equation->steps();
+        }
+        const std::vector<SolutionStep>& steps = *derived;
+        if (steps.empty()) {
+            ImGui::Text("No derivation for this equation type");
+            return;
+        }
+        for (size_t i = 0; i < steps.size(); i++) {
+            ImGui::TextColored(ImVec4(0.2f, 0.3f, 0.6f, 1.0f), "%d. %s", (int)i + 1, steps[i].title.c_str());
+            ImGui::Indent();
+            TextLayoutCache::shared().text(steps[i].detail);
+            ImGui::Unindent();
+        }
+
+        static std::string export_status;
+        static std::shared_ptr<Equation> export_owner;
+        if (export_owner != current_equation) {
+            export_owner = current_equation;
+            export_status.clear();
+        }
+        if (ImGui::Button("Export Steps")) {
+            bool ok = StepExport::append("solutions.txt", current_equation->toString(), steps);
+            export_status = ok ? "Appended to solutions.txt" : "Couldn't open solutions.txt";
+        }
+        if (!export_status.empty()) {
+            ImGui::SameLine();
+            ImGui::Text("%s", export_status.c_str());
+        }
+    }
+
+    // Renders Equation Output
+    void RenderEquationDisplayWindow() {
+        TRACK_ALLOCATIONS("RenderEquationDisplayWindow");
+        PROFILE_ZONE("RenderEquationDisplayWindow");
+        if (equation_display_window) {
+            UpdatePendingEquation();
+            ImGui::OpenPopup("Equation Display");
+            ImGui::BeginPopupModal("Equation Display", &equation_display_window, ImGuiWindowFlags_AlwaysAutoResize);
+
+            // Display the generated equation
+            if (equation_pending) {
+                ImGui::Text("Generating equation...");
+            }
+            else if (current_equation) {
+                if (equation_text_owner != current_equation) {
+                    equation_text_owner = current_equation;
+                    equation_text = current_equation->toString();
+                    solution_text.clear();
+                    canonical_text.clear();
+                }
+                TextLayoutCache::shared().text(equation_text);
+
+                // Solution structure, collapsed by default and worked out when first expanded
+                if (ImGui::CollapsingHeader("Solution Form")) {
+                    if (solution_text.empty()) {
+                        PROFILE_ZONE("Equation::solutionForm");
+                        solution_text = current_equation->solutionForm();
+                    }
+                    if (solution_text.empty()) {
+                        ImGui::Text("No solution form for this equation type");
+                    }
+                    else {
+                        TextLayoutCache::shared().text(solution_text);
+                    }
+                }
+                RenderSolutionSteps();
+
+                // scaled and reordered form that equivalent equations share
+                if (ImGui::CollapsingHeader("Canonical Form")) {
+                    if (canonical_text.empty()) {
+                        PROFILE_ZONE("Simplifier::simplify");
+                        ExprArena& arena = ExprArena::shared();
+                        canonical_text = ExprFormat::format(Simplifier::simplify(current_equation->toExpr(arena), arena));
+                    }
+                    TextLayoutCache::shared().text(canonical_text);
+                }
+                RenderEquationCheck();
+                RenderSolutionCheck();
+                RenderSlopeField();
+            }
+            else {
+                ImGui::Text("No equation generated!");
+            }
+            // Close Button for the display window
+            if (ImGui::Button("Close")) {
+                equation_display_window = false;
+                equation_pending = false;
+            }
+
+            ImGui::EndPopup();
+        }
+    }
+
+    // Renders the session history, only the rows in view are made into text
+    void RenderHistoryWindow() {
+        TRACK_ALLOCATIONS("RenderHistoryWindow");
+        PROFILE_ZONE("RenderHistoryWindow");
+        if (!history_window) {
+            return;
+        }
+        ImGui::SetNextWindowPos(ImVec2(500.0f, 40.0f), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(290.0f, 440.0f), ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("History", &history_window)) {
+            ImGui::End();
+            return;
+        }
+        ImGui::Text("%u equations", (unsigned)session_history.size());
+
+        const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+            ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable | ImGuiTableFlags_SizingFixedFit;
+        if (ImGui::BeginTable("history", 4, flags)) {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("#", ImGuiTableColumnFlags_DefaultSort, 0.0f, EquationHistory::ByTime);
+            ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, 78.0f, EquationHistory::ByType);
+            ImGui::TableSetupColumn("Coefficients", ImGuiTableColumnFlags_WidthFixed, 78.0f, EquationHistory::ByCoefficients);
+            ImGui::TableSetupColumn("Equation", ImGuiTableColumnFlags_NoSort | ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+
+            ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs();
+            if (specs && specs->SpecsDirty) {
+                PROFILE_ZONE("EquationHistory::sort");
+                if (specs->SpecsCount > 0) {
+                    session_history.sort((EquationHistory::SortKey)specs->Specs[0].ColumnUserID,
+                        specs->Specs[0].SortDirection == ImGuiSortDirection_Descending);
+                }
+                specs->SpecsDirty = false;
+            }
+
+            static const char* types[] = { "", "First-Order", "Cauchy-Euler", "Higher-Order", "Partial", "System",
+                "Seperable", "Exact", "Laplace", "Frobenius" };
+            ImGuiListClipper clipper;
+            clipper.Begin((int)session_history.size());
+            while (clipper.Step()) {
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                    const EquationHistory::Row& row = session_history.row(i);
+                    uint32_t index = session_history.index(i);
+                    ImGui::TableNextRow();
+                    ImGui::PushID((int)index);
+
+                    ImGui::TableNextColumn();
+                    char label[16];
+                    std::snprintf(label, sizeof(label), "%u", index + 1);
+                    // reopens the equation, made again from its settings and seed
+                    if (ImGui::Selectable(label, false, ImGuiSelectableFlags_SpanAllColumns) && !equation_display_window) {
+                        GeneratorSettings saved = GeneratorSettings::current(equation_choice);
+                        PreparedEquation prepared = EquationGenerator::prepare(HistorySettings(row), row.seed);
+                        saved.apply();
+                        ShowPreparedEquation(prepared);
+                    }
+                    bool hovered = ImGui::IsItemHovered();
+
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(row.type < IM_ARRAYSIZE(types) ? types[row.type] : "");
+
+                    ImGui::TableNextColumn();
+                    char coefficients[64];
+                    int length = 0;
+                    int shown = std::min((int)row.coefficientCount, (int)EquationHistory::PackedCoefficients);
+                    for (int k = 0; k < shown; k++) {
+                        length += std::snprintf(coefficients + length, sizeof(coefficients) - length, k ? ", %lld" : "%lld",
+                            EquationHistory::coefficient(row, k));
+                    }
+                    if (row.coefficientCount > shown) std::snprintf(coefficients + length, sizeof(coefficients) - length, ", ...");
+                    ImGui::TextUnformatted(shown ? coefficients : "");
+
+                    ImGui::TableNextColumn();
+                    const std::string& text = session_history.text(index, DescribeHistoryRow);
+                    ImGui::TextUnformatted(text.c_str());
+                    // the column is narrow in the default layout
+                    if (hovered) ImGui::SetTooltip("%s", text.c_str());
+                    ImGui::PopID();
+                }
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+    // Render the Welcome Window
+    void RenderWelcomeWindow() {
+        TRACK_ALLOCATIONS("RenderWelcomeWindow");
+        PROFILE_ZONE("RenderWelcomeWindow");
+        static int counter = 0;
+        if (show_demo_window) {
+            ImGui::ShowDemoWindow(&show_demo_window);
+        }
+
+        ImGui::SetNextWindowPos(ImVec2(9, 490));
+        ImGui::SetNextWindowSize(ImVec2(290.0f, 60.0f), ImGuiCond_Always);
+        ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(1.0f, 1.0f, 0.7f, 1.0f));
+
+        ImGui::Begin("Welcome");
+        ImGui::Text("Welcome, %s", name.c_str());
+        //ImGui::Checkbox("Demo Window", &show_demo_window);
+
+        ImGui::End();
+        ImGui::PopStyleColor();
+    }
+
+
+    // Main Render Function for UI
+    void RenderUI() {
+        PROFILE_ZONE("RenderUI");
+        RenderFirstOrderParametersWindow(); // Render the first order parameters equation's helper popup
+        RenderEquationSelectionWindow();    // Render the main application window
+        RenderEquationDisplayWindow();      // Render generated equation
+        RenderHistoryWindow();              // Render the session history
+        RenderWelcomeWindow();              // Render the welcome window
+    }
+
+    void Shutdown() {
+        prefetcher.stop();
+    }
+
+    void WaitForEquations(bool wait) {
+        wait_for_equations = wait;
+    }
+
+    bool EquationPending() {
+        return equation_pending;
+    }
+}
+
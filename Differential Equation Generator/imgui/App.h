@@ -1,22 +1,37 @@
-﻿#pragma once
-
-namespace App {
-
-    // mutator for FirstOrderParametersWindow
-    void setFirstOrderHelperBool(bool val);
-    // Renders First Order Linear Equation Helper Popup
-    void RenderFirstOrderParametersWindow();
-
-    // Renders Main Equation Generation Window
-    void RenderEquationSelectionWindow();
-
-    // Renders Equation Output
-    void RenderEquationDisplayWindow();
-
-    // Render the Welcome Window
-    void RenderWelcomeWindow();
-
-
-    // Main Render Function for UI
-    void RenderUI();
+#pragma once
+
+namespace App {
+
+    // mutator for FirstOrderParametersWindow
+    void setFirstOrderHelperBool(bool val);
+    // Renders First Order Linear Equation Helper Popup
+    void RenderFirstOrderParametersWindow();
+
+    // Renders Main Equation Generation Window
+    void RenderEquationSelectionWindow();
+
+    // Renders Equation Output
+    void RenderEquationDisplayWindow();
+
+    // Renders the session history
+    void RenderHistoryWindow();
+
+    // Render the Welcome Window
+    void RenderWelcomeWindow();
+
+
+    // Main Render Function for UI
+    void RenderUI();
+
+    // Stops the background equation generator, call before exit
+    void Shutdown();
+
+    // Makes Generate Equation wait for the background generator instead of showing a
+    // placeholder until it catches up, so a replayed session draws the same frames
+    void WaitForEquations(bool wait);
+    // Generate Equation was clicked and its equation isn't made yet; frames keep coming until it is
+    bool EquationPending();
+
+    // Adds rows to the session history, to try the history window on a long session
+    void FillHistory(int rows);
 }
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "Bytecode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+
+    struct Compiler {
+        const std::vector<std::string>& vars;
+        std::vector<Instr>& code;
+        std::vector<double>& constants;
+        // nodes are hash-consed, so shared subexpressions hit this map and are computed once
+        std::unordered_map<const Expr*, int> done;
+        std::unordered_map<double, int> constantIndex;
+        int next = 0;
+        bool ok = true;
+
+        Compiler(const std::vector<std::string>& v, std::vector<Instr>& c, std::vector<double>& k)
+            : vars(v), code(c), constants(k) {}
+
+        int emit(OpCode op, int a = 0, int b = 0, int imm = 0) {
+            if (next >= ExprProgram::MaxRegisters) {
+                ok = false;
+                return 0;
+            }
+            Instr in;
+            in.op = op;
+            in.dst = (unsigned char)next;
+            in.a = (unsigned char)a;
+            in.b = (unsigned char)b;
+            in.imm = imm;
+            code.push_back(in);
+            return next++;
+        }
+
+        int constant(double v) {
+            auto it = constantIndex.find(v);
+            int index;
+            if (it != constantIndex.end()) {
+                index = it->second;
+            }
+            else {
+                index = (int)constants.size();
+                constants.push_back(v);
+                constantIndex[v] = index;
+            }
+            return emit(OpCode::Const, 0, 0, index);
+        }
+
+        int compile(const Expr* e) {
+            if (!ok) return 0;
+            auto it = done.find(e);
+            if (it != done.end()) return it->second;
+
+            int r = 0;
+            switch (e->op) {
+            case ExprOp::Const:
+                r = constant(e->value);
+                break;
+            case ExprOp::Var: {
+                auto v = std::find(vars.begin(), vars.end(), e->name);
+                if (v == vars.end()) { ok = false; return 0; }
+                r = emit(OpCode::Var, 0, 0, int(v - vars.begin()));
+                break;
+            }
+            case ExprOp::Add:
+                // a + -b becomes a - b
+                r = compile(e->args[0]);
+                for (size_t i = 1; i < e->args.size() && ok; i++) {
+                    const Expr* t = e->args[i];
+                    if (t->op == ExprOp::Neg) r = emit(OpCode::Sub, r, compile(t->args[0]));
+                    else r = emit(OpCode::Add, r, compile(t));
+                }
+                break;
+            case ExprOp::Mul:
+                r = compile(e->args[0]);
+                for (size_t i = 1; i < e->args.size() && ok; i++) r = emit(OpCode::Mul, r, compile(e->args[i]));
+                break;
+            case ExprOp::Div: {
+                int a = compile(e->args[0]);
+                r = emit(OpCode::Div, a, compile(e->args[1]));
+                break;
+            }
+            case ExprOp::Pow: {
+                const Expr* ex = e->args[1];
+                int a = compile(e->args[0]);
+                if (ex->isConst() && ex->value == std::floor(ex->value) && std::fabs(ex->value) <= 64) {
+                    r = emit(OpCode::PowInt, a, 0, int(ex->value));
+                }
+                else {
+                    r = emit(OpCode::Pow, a, compile(ex));
+                }
+                break;
+            }
+            case ExprOp::Neg:
+                r = emit(OpCode::Neg, compile(e->args[0]));
+                break;
+            case ExprOp::Func: {
+                OpCode op;
+                if (e->name == "sin") op = OpCode::Sin;
+                else if (e->name == "cos") op = OpCode::Cos;
+                else if (e->name == "exp") op = OpCode::Exp;
+                else if (e->name == "ln") op = OpCode::Ln;
+                else { ok = false; return 0; }
+                r = emit(op, compile(e->args[0]));
+                break;
+            }
+            default:
+                ok = false;
+                return 0;
+            }
+            done[e] = r;
+            return r;
+        }
+    };
+
+    inline double powInt(double a, int n) {
+        double r = 1.0;
+        for (int i = n < 0 ? -n : n; i > 0; i--) r *= a;
+        return n < 0 ? 1.0 / r : r;
+    }
+}
+
+bool ExprProgram::compile(const Expr* e, const std::vector<std::string>& vars, ExprProgram& out) {
+    out = ExprProgram();
+    Compiler c(vars, out.code, out.constants);
+    out.result = c.compile(e);
+    if (!c.ok) {
+        out = ExprProgram();
+        return false;
+    }
+    out.numVars = (int)vars.size();
+    out.numRegisters = c.next;
+    out.registerFile.resize(out.numRegisters * Lanes);
+    out.pointInputs.resize(out.numVars);
+    return true;
+}
+
+double ExprProgram::eval(const double* vars) const {
+    for (int i = 0; i < numVars; i++) pointInputs[i] = vars + i;
+    double out;
+    evalBatch(pointInputs.data(), 1, &out);
+    return out;
+}
+
+void ExprProgram::evalBatch(const double* const* inputs, int count, double* out) const {
+    // one row of Lanes values per register
+    double* R = registerFile.data();
+
+    for (int base = 0; base < count; base += Lanes) {
+        const int n = std::min(Lanes, count - base);
+        for (const Instr& in : code) {
+            double* d = R + in.dst * Lanes;
+            const double* a = R + in.a * Lanes;
+            const double* b = R + in.b * Lanes;
+            // fixed-trip loops over the block so the compiler can vectorize each case
+            switch (in.op) {
+            case OpCode::Const: { double v = constants[in.imm]; for (int l = 0; l < Lanes; l++) d[l] = v; break; }
+            case OpCode::Var: { const double* src = inputs[in.imm] + base; for (int l = 0; l < n; l++) d[l] = src[l]; break; }
+            case OpCode::Add: for (int l = 0; l < Lanes; l++) d[l] = a[l] + b[l]; break;
+            case OpCode::Sub: for (int l = 0; l < Lanes; l++) d[l] = a[l] - b[l]; break;
+            case OpCode::Mul: for (int l = 0; l < Lanes; l++) d[l] = a[l] * b[l]; break;
+            case OpCode::Div: for (int l = 0; l < Lanes; l++) d[l] = a[l] / b[l]; break;
+            case OpCode::Neg: for (int l = 0; l < Lanes; l++) d[l] = -a[l]; break;
+            case OpCode::PowInt: for (int l = 0; l < Lanes; l++) d[l] = powInt(a[l], in.imm); break;
+            case OpCode::Pow: for (int l = 0; l < n; l++) d[l] = std::pow(a[l], b[l]); break;
+            case OpCode::Sin: for (int l = 0; l < n; l++) d[l] = std::sin(a[l]); break;
+            case OpCode::Cos: for (int l = 0; l < n; l++) d[l] = std::cos(a[l]); break;
+            case OpCode::Exp: for (int l = 0; l < n; l++) d[l] = std::exp(a[l]); break;
+            case OpCode::Ln: for (int l = 0; l < n; l++) d[l] = std::log(a[l]); break;
+            }
+        }
+        const double* r = R + result * Lanes;
+        for (int l = 0; l < n; l++) out[base + l] = r[l];
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Expr.h"
+
+#include <string>
+#include <vector>
+
+// Register machine opcodes for compiled expressions
+enum class OpCode : unsigned char {
+    Const,  // r[dst] = constants[imm]
+    Var,    // r[dst] = input imm
+    Add,    // r[dst] = r[a] + r[b]
+    Sub,    // r[dst] = r[a] - r[b]
+    Mul,    // r[dst] = r[a] * r[b]
+    Div,    // r[dst] = r[a] / r[b]
+    Neg,    // r[dst] = -r[a]
+    PowInt, // r[dst] = r[a] ^ imm
+    Pow,    // r[dst] = r[a] ^ r[b]
+    Sin,
+    Cos,
+    Exp,
+    Ln
+};
+
+struct Instr {
+    OpCode op;
+    unsigned char dst, a, b;
+    int imm;
+};
+
+// Expression compiled to register bytecode. The interpreter runs every
+// instruction over a block of Lanes points, so the dispatch is paid once per block
+class ExprProgram {
+public:
+    static const int Lanes = 16;
+    static const int MaxRegisters = 256;
+
+    // compiles e with inputs named by vars, false when e has a node the VM can't evaluate
+    // (derivatives, equations, unknown functions) or needs too many registers
+    static bool compile(const Expr* e, const std::vector<std::string>& vars, ExprProgram& out);
+
+    // single point, vars in the order given to compile
+    double eval(const double* vars) const;
+    // out[i] = f(inputs[0][i], inputs[1][i], ...) for i < count
+    void evalBatch(const double* const* inputs, int count, double* out) const;
+    // eval() and evalBatch() work in registers the program keeps, so they allocate nothing
+    // but also can't run on one program from two threads at once
+
+    bool empty() const { return code.empty(); }
+    size_t size() const { return code.size(); }
+    int registers() const { return numRegisters; }
+
+    // compiled form, for interpreters over other number types
+    const std::vector<Instr>& instructions() const { return code; }
+    const std::vector<double>& constantPool() const { return constants; }
+    int inputs() const { return numVars; }
+    int resultRegister() const { return result; }
+
+private:
+    std::vector<Instr> code;
+    std::vector<double> constants;
+    int numVars = 0;
+    int numRegisters = 0;
+    int result = 0;
+    // scratch for evaluation, sized by compile()
+    mutable std::vector<double> registerFile;  // numRegisters rows of Lanes values
+    mutable std::vector<const double*> pointInputs;
+};
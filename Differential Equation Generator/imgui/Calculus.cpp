@@ -0,0 +1,587 @@
+#include "Calculus.h"
+#include "Parser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace {
+
+    long long gcd(long long a, long long b) {
+        if (a < 0) a = -a;
+        if (b < 0) b = -b;
+        while (b != 0) {
+            long long t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    bool isInteger(const Expr* e) {
+        return e->isConst() && e->value == std::floor(e->value) && std::fabs(e->value) < 1e15;
+    }
+
+    // splits e into (num/den) * body; body is nullptr when e is a plain number
+    void coefficient(const Expr* e, long long& num, long long& den, const Expr*& body, ExprArena& arena) {
+        num = 1;
+        den = 1;
+        body = e;
+        if (isInteger(e)) {
+            num = (long long)e->value;
+            body = nullptr;
+        }
+        else if (e->op == ExprOp::Neg) {
+            coefficient(e->args[0], num, den, body, arena);
+            num = -num;
+        }
+        else if (e->op == ExprOp::Div && isInteger(e->args[1]) && e->args[1]->value != 0.0) {
+            coefficient(e->args[0], num, den, body, arena);
+            den *= (long long)e->args[1]->value;
+        }
+        else if (e->op == ExprOp::Mul) {
+            // every integer and integer fraction factor goes into the coefficient
+            std::vector<const Expr*> rest;
+            for (const Expr* f : e->args) {
+                if (isInteger(f)) {
+                    num *= (long long)f->value;
+                }
+                else if (f->op == ExprOp::Div && isInteger(f->args[0]) && isInteger(f->args[1]) && f->args[1]->value != 0.0) {
+                    num *= (long long)f->args[0]->value;
+                    den *= (long long)f->args[1]->value;
+                }
+                else {
+                    rest.push_back(f);
+                }
+            }
+            body = rest.empty() ? nullptr : arena.mul(rest);
+        }
+        if (den < 0) {
+            num = -num;
+            den = -den;
+        }
+    }
+
+    // (num/den) * body in the shape ExactForm::termsToExpr uses: "(1/3)x^3", "-(5/2)y"
+    const Expr* withCoefficient(long long num, long long den, const Expr* body, ExprArena& arena) {
+        if (den < 0) {
+            num = -num;
+            den = -den;
+        }
+        long long g = gcd(num, den);
+        if (g > 1) {
+            num /= g;
+            den /= g;
+        }
+        if (num == 0) return arena.constant(0.0);
+        if (body == nullptr && den == 1) return arena.constant(double(num));
+        long long magnitude = num < 0 ? -num : num;
+        const Expr* c = den == 1 ? arena.constant(double(magnitude)) : arena.div(arena.constant(double(magnitude)), arena.constant(double(den)));
+        const Expr* term = body == nullptr ? c : arena.mul({ c, body });
+        return num < 0 ? arena.neg(term) : term;
+    }
+
+    // order of var-dependent factors before the table lookup, patterns are written in it
+    int factorRank(const Expr* e) {
+        if (e->op == ExprOp::Var) return 0;
+        if (e->op == ExprOp::Pow) return 1;
+        if (e->op == ExprOp::Func) {
+            if (e->name == "exp") return 2;
+            if (e->name == "sin") return 3;
+            if (e->name == "cos") return 4;
+            if (e->name == "ln") return 5;
+        }
+        return 6;
+    }
+
+    enum class RuleCondition { None, NotMinusOne, MinusOne };
+
+    struct RuleText {
+        const char* pattern;
+        const char* result;
+        RuleCondition condition;
+    };
+
+    // x is the variable of integration, k matches anything free of x, n matches a number
+    const RuleText IntegralRules[] = {
+        { "x", "x^2/2", RuleCondition::None },
+        { "x^n", "x^(n+1)/(n+1)", RuleCondition::NotMinusOne },
+        { "x^n", "ln(x)", RuleCondition::MinusOne },
+        { "e^x", "e^x", RuleCondition::None },
+        { "e^(k*x)", "e^(k*x)/k", RuleCondition::None },
+        { "sin(x)", "-cos(x)", RuleCondition::None },
+        { "sin(k*x)", "-cos(k*x)/k", RuleCondition::None },
+        { "cos(x)", "sin(x)", RuleCondition::None },
+        { "cos(k*x)", "sin(k*x)/k", RuleCondition::None },
+        { "tan(x)", "-ln(cos(x))", RuleCondition::None },
+        { "ln(x)", "x*ln(x) - x", RuleCondition::None },
+        { "ln(k*x)", "x*ln(k*x) - x", RuleCondition::None },
+        { "x*e^x", "(x - 1)*e^x", RuleCondition::None },
+        { "x*e^(k*x)", "(x/k - 1/k^2)*e^(k*x)", RuleCondition::None },
+        { "x*sin(x)", "sin(x) - x*cos(x)", RuleCondition::None },
+        { "x*cos(x)", "cos(x) + x*sin(x)", RuleCondition::None },
+        { "x*ln(x)", "x^2*ln(x)/2 - x^2/4", RuleCondition::None },
+        { "x^n*ln(x)", "x^(n+1)*ln(x)/(n+1) - x^(n+1)/(n+1)^2", RuleCondition::NotMinusOne },
+        { "x^n*ln(x)", "ln(x)^2/2", RuleCondition::MinusOne },
+        { "e^x*sin(x)", "e^x*(sin(x) - cos(x))/2", RuleCondition::None },
+        { "e^x*cos(x)", "e^x*(sin(x) + cos(x))/2", RuleCondition::None },
+    };
+
+    // Rule patterns in a discrimination tree: a trie over the preorder symbols of the
+    // pattern, with wildcard edges that skip a whole subterm. A lookup walks the
+    // integrand once and only reaches the rules whose shape fits
+    class IntegralTable {
+    public:
+        struct Match {
+            const Expr* result = nullptr; // template over x, k, n
+            const Expr* k = nullptr;
+            const Expr* n = nullptr;
+        };
+
+        static IntegralTable& instance() {
+            static IntegralTable table;
+            return table;
+        }
+
+        bool lookup(const Expr* e, const std::string& var, Match& out) const {
+            std::vector<const Expr*> order;
+            std::vector<int> skip;
+            flatten(e, order, skip);
+            Match m;
+            return walk(0, 0, order, skip, var, m, out);
+        }
+
+    private:
+        struct Node {
+            std::map<std::string, int> edges;
+            std::vector<std::pair<char, int>> wildcards;
+            std::vector<int> rules;
+        };
+        struct Rule {
+            const Expr* result;
+            RuleCondition condition;
+        };
+
+        ExprArena patterns;
+        std::vector<Node> nodes;
+        std::vector<Rule> rules;
+
+        IntegralTable() : nodes(1) {
+            for (const RuleText& r : IntegralRules) {
+                const Expr* pattern = ExprParser::parse(r.pattern, patterns);
+                Rule rule;
+                rule.result = ExprParser::parse(r.result, patterns);
+                rule.condition = r.condition;
+                rules.push_back(rule);
+                insert(pattern, (int)rules.size() - 1);
+            }
+        }
+
+        static std::string symbol(const Expr* e) {
+            std::string s(1, char('A' + int(e->op)));
+            s += e->name;
+            s += '/' + std::to_string(e->args.size());
+            if (e->isConst()) s += '=' + ExprFormat::number(e->value);
+            return s;
+        }
+
+        static char wildcard(const Expr* e) {
+            if (e->op != ExprOp::Var || e->name.size() != 1) return 0;
+            char c = e->name[0];
+            return c == 'x' || c == 'k' || c == 'n' ? c : 0;
+        }
+
+        // preorder nodes, skip[i] is the index just past the subterm rooted at i
+        static void flatten(const Expr* e, std::vector<const Expr*>& order, std::vector<int>& skip) {
+            size_t at = order.size();
+            order.push_back(e);
+            skip.push_back(0);
+            for (const Expr* a : e->args) flatten(a, order, skip);
+            skip[at] = (int)order.size();
+        }
+
+        void insert(const Expr* pattern, int rule) {
+            std::vector<const Expr*> order;
+            std::vector<int> skip;
+            flatten(pattern, order, skip);
+            int at = 0;
+            for (const Expr* p : order) {
+                char w = wildcard(p);
+                int next = -1;
+                if (w) {
+                    for (auto& edge : nodes[at].wildcards) {
+                        if (edge.first == w) next = edge.second;
+                    }
+                    if (next < 0) {
+                        next = (int)nodes.size();
+                        nodes[at].wildcards.push_back(std::make_pair(w, next));
+                        nodes.emplace_back();
+                    }
+                }
+                else {
+                    std::string s = symbol(p);
+                    auto it = nodes[at].edges.find(s);
+                    if (it != nodes[at].edges.end()) {
+                        next = it->second;
+                    }
+                    else {
+                        next = (int)nodes.size();
+                        nodes[at].edges[s] = next;
+                        nodes.emplace_back();
+                    }
+                }
+                at = next;
+            }
+            nodes[at].rules.push_back(rule);
+        }
+
+        bool walk(int at, size_t pos, const std::vector<const Expr*>& order, const std::vector<int>& skip,
+            const std::string& var, Match& m, Match& out) const {
+            const Node& node = nodes[at];
+            if (pos == order.size()) {
+                for (int r : node.rules) {
+                    const Rule& rule = rules[r];
+                    bool minusOne = m.n != nullptr && m.n->isConst(-1.0);
+                    if (rule.condition == RuleCondition::NotMinusOne && minusOne) continue;
+                    if (rule.condition == RuleCondition::MinusOne && !minusOne) continue;
+                    out = m;
+                    out.result = rule.result;
+                    return true;
+                }
+                return false;
+            }
+            const Expr* e = order[pos];
+            auto it = node.edges.find(symbol(e));
+            if (it != node.edges.end() && walk(it->second, pos + 1, order, skip, var, m, out)) return true;
+            for (auto& edge : node.wildcards) {
+                size_t next = (size_t)skip[pos];
+                if (edge.first == 'x') {
+                    if (e->op == ExprOp::Var && e->name == var && walk(edge.second, next, order, skip, var, m, out)) return true;
+                    continue;
+                }
+                const Expr*& slot = edge.first == 'k' ? m.k : m.n;
+                if (edge.first == 'k' && Calculus::dependsOn(e, var)) continue;
+                if (edge.first == 'n' && !e->isConst()) continue;
+                if (slot != nullptr && slot != e) continue;
+                const Expr* saved = slot;
+                slot = e;
+                if (walk(edge.second, next, order, skip, var, m, out)) return true;
+                slot = saved;
+            }
+            return false;
+        }
+    };
+
+    // rebuilds a rule result with x, k and n filled in, folding the numbers it produces
+    const Expr* instantiate(const Expr* t, const std::string& var, const IntegralTable::Match& m, ExprArena& arena) {
+        switch (t->op) {
+        case ExprOp::Const:
+            return arena.constant(t->value);
+        case ExprOp::Var:
+            if (t->name == "x") return arena.var(var);
+            if (t->name == "k") return m.k;
+            if (t->name == "n") return m.n;
+            return arena.var(t->name);
+        case ExprOp::Add: {
+            std::vector<const Expr*> terms;
+            double sum = 0.0;
+            for (const Expr* a : t->args) {
+                const Expr* v = instantiate(a, var, m, arena);
+                if (v->isConst()) sum += v->value;
+                else terms.push_back(v);
+            }
+            terms.push_back(arena.constant(sum));
+            return arena.add(terms);
+        }
+        case ExprOp::Mul: {
+            std::vector<const Expr*> factors;
+            for (const Expr* a : t->args) factors.push_back(instantiate(a, var, m, arena));
+            // one coefficient in front, "-x^3/9" becomes "-(1/9)x^3"
+            return Calculus::scale(arena.mul(factors), 1, 1, arena);
+        }
+        case ExprOp::Div: {
+            const Expr* num = instantiate(t->args[0], var, m, arena);
+            const Expr* den = instantiate(t->args[1], var, m, arena);
+            if (isInteger(den) && den->value != 0.0) return Calculus::scale(num, 1, (long long)den->value, arena);
+            if (den->isConst() && den->value != 0.0) return arena.mul({ arena.constant(1.0 / den->value), num });
+            return arena.div(num, den);
+        }
+        case ExprOp::Pow: {
+            const Expr* base = instantiate(t->args[0], var, m, arena);
+            const Expr* ex = instantiate(t->args[1], var, m, arena);
+            if (base->isConst() && ex->isConst()) return arena.constant(std::pow(base->value, ex->value));
+            return arena.pow(base, ex);
+        }
+        case ExprOp::Neg:
+            return Calculus::scale(instantiate(t->args[0], var, m, arena), -1, 1, arena);
+        case ExprOp::Func:
+            return arena.func(t->name, instantiate(t->args[0], var, m, arena));
+        default:
+            return t;
+        }
+    }
+
+    // 1/e with powers and products inverted factor by factor
+    const Expr* reciprocal(const Expr* e, ExprArena& arena) {
+        if (e->op == ExprOp::Pow && e->args[1]->isConst()) return arena.pow(e->args[0], arena.constant(-e->args[1]->value));
+        if (e->op == ExprOp::Mul) {
+            std::vector<const Expr*> factors;
+            for (const Expr* f : e->args) factors.push_back(reciprocal(f, arena));
+            return arena.mul(factors);
+        }
+        // 1/3 stays a fraction instead of 0.333
+        if (isInteger(e) && e->value != 0.0) return arena.div(arena.constant(1.0), e);
+        if (e->isConst()) return arena.constant(1.0 / e->value);
+        return arena.pow(e, -1);
+    }
+
+    // c * e for a factor c free of the variable, with one coefficient in front
+    const Expr* times(const Expr* c, const Expr* e, ExprArena& arena) {
+        long long num, den;
+        const Expr* body;
+        coefficient(c, num, den, body, arena);
+        if (body == nullptr || e->op == ExprOp::Add) {
+            const Expr* scaled = Calculus::scale(e, num, den, arena);
+            return body == nullptr ? scaled : arena.mul({ body, scaled });
+        }
+        long long n, d;
+        const Expr* rest;
+        coefficient(e, n, d, rest, arena);
+        if (rest == nullptr) return withCoefficient(num * n, den * d, body, arena);
+        // powers before functions, integrated factors first: "(7/2)x^2*y*e^y"
+        std::vector<const Expr*> factors;
+        for (const Expr* part : { rest, body }) {
+            if (part->op == ExprOp::Mul) factors.insert(factors.end(), part->args.begin(), part->args.end());
+            else factors.push_back(part);
+        }
+        std::stable_sort(factors.begin(), factors.end(), [](const Expr* a, const Expr* b) {
+            return (a->op == ExprOp::Func) < (b->op == ExprOp::Func);
+        });
+        return withCoefficient(num * n, den * d, arena.mul(factors), arena);
+    }
+
+    const Expr* differentiate(const Expr* e, const Expr* x, ExprArena& arena);
+    const Expr* antidifferentiate(const Expr* e, const Expr* x, ExprArena& arena);
+
+    const Expr* derivativeOf(const Expr* e, const Expr* x, ExprArena& arena) {
+        if (e->derivativeVar == x) return e->derivative;
+        const Expr* d = differentiate(e, x, arena);
+        e->derivative = d;
+        e->derivativeVar = x;
+        return d;
+    }
+
+    const Expr* integralOf(const Expr* e, const Expr* x, ExprArena& arena) {
+        if (e->antiderivativeVar == x) return e->antiderivative;
+        const Expr* i = antidifferentiate(e, x, arena);
+        e->antiderivative = i;
+        e->antiderivativeVar = x;
+        return i;
+    }
+
+    const Expr* differentiate(const Expr* e, const Expr* x, ExprArena& arena) {
+        const Expr* zero = arena.constant(0.0);
+        switch (e->op) {
+        case ExprOp::Const:
+            return zero;
+        case ExprOp::Var:
+            return arena.constant(e == x ? 1.0 : 0.0);
+        case ExprOp::Add: {
+            std::vector<const Expr*> terms;
+            for (const Expr* a : e->args) {
+                const Expr* d = derivativeOf(a, x, arena);
+                if (d == nullptr) return nullptr;
+                terms.push_back(d);
+            }
+            return arena.add(terms);
+        }
+        case ExprOp::Mul: {
+            // product rule, factors free of x contribute nothing of their own
+            std::vector<const Expr*> terms;
+            for (size_t i = 0; i < e->args.size(); i++) {
+                const Expr* d = derivativeOf(e->args[i], x, arena);
+                if (d == nullptr) return nullptr;
+                if (d->isConst(0.0)) continue;
+                std::vector<const Expr*> factors = e->args;
+                factors[i] = d;
+                terms.push_back(arena.mul(factors));
+            }
+            return arena.add(terms);
+        }
+        case ExprOp::Div: {
+            const Expr* a = e->args[0];
+            const Expr* b = e->args[1];
+            const Expr* da = derivativeOf(a, x, arena);
+            const Expr* db = derivativeOf(b, x, arena);
+            if (da == nullptr || db == nullptr) return nullptr;
+            if (db->isConst(0.0)) return da->isConst(0.0) ? zero : arena.div(da, b);
+            // (a'b - ab') / b^2
+            const Expr* num = arena.add({ arena.mul({ da, b }), arena.mul({ arena.constant(-1.0), a, db }) });
+            return arena.div(num, arena.pow(b, 2));
+        }
+        case ExprOp::Pow: {
+            const Expr* b = e->args[0];
+            const Expr* g = e->args[1];
+            const Expr* db = derivativeOf(b, x, arena);
+            const Expr* dg = derivativeOf(g, x, arena);
+            if (db == nullptr || dg == nullptr) return nullptr;
+            if (g->isConst()) {
+                if (db->isConst(0.0)) return zero;
+                // n b^(n-1) b'
+                return arena.mul({ g, arena.pow(b, arena.constant(g->value - 1.0)), db });
+            }
+            if (db->isConst(0.0)) {
+                return dg->isConst(0.0) ? zero : arena.mul({ e, arena.func("ln", b), dg });
+            }
+            // b^g (g' ln b + g b'/b)
+            return arena.mul({ e, arena.add({ arena.mul({ dg, arena.func("ln", b) }), arena.div(arena.mul({ g, db }), b) }) });
+        }
+        case ExprOp::Neg: {
+            const Expr* d = derivativeOf(e->args[0], x, arena);
+            return d == nullptr ? nullptr : Calculus::scale(d, -1, 1, arena);
+        }
+        case ExprOp::Func: {
+            const Expr* u = e->args[0];
+            const Expr* du = derivativeOf(u, x, arena);
+            if (du == nullptr) return nullptr;
+            if (du->isConst(0.0)) return zero;
+            const std::string& f = e->name;
+            if (f == "sin") return arena.mul({ arena.func("cos", u), du });
+            if (f == "cos") return arena.mul({ arena.constant(-1.0), arena.func("sin", u), du });
+            if (f == "tan") return arena.mul({ arena.pow(arena.func("cos", u), -2), du });
+            if (f == "exp") return arena.mul({ e, du });
+            if (f == "ln" || f == "log") return arena.div(du, u);
+            if (f == "sqrt") return arena.div(du, arena.mul({ arena.constant(2.0), e }));
+            if (f == "sinh") return arena.mul({ arena.func("cosh", u), du });
+            if (f == "cosh") return arena.mul({ arena.func("sinh", u), du });
+            // an unknown function y(x)
+            if (u == x) return arena.deriv(e, x->name, 1, DerivStyle::Prime);
+            return nullptr;
+        }
+        case ExprOp::Deriv:
+            if (e->name == x->name) return arena.deriv(e->args[0], e->name, e->order + 1, e->style);
+            return nullptr;
+        default:
+            return nullptr;
+        }
+    }
+
+    const Expr* antidifferentiate(const Expr* e, const Expr* x, ExprArena& arena) {
+        const std::string& var = x->name;
+        if (e->op != ExprOp::Add && !Calculus::dependsOn(e, var)) return times(e, x, arena);
+
+        switch (e->op) {
+        case ExprOp::Add: {
+            // term by term, so constant sums come out expanded: "9x*e^y + 7x"
+            std::vector<const Expr*> terms;
+            for (const Expr* a : e->args) {
+                const Expr* i = integralOf(a, x, arena);
+                if (i == nullptr) return nullptr;
+                terms.push_back(i);
+            }
+            return arena.add(terms);
+        }
+        case ExprOp::Neg: {
+            const Expr* i = integralOf(e->args[0], x, arena);
+            return i == nullptr ? nullptr : Calculus::scale(i, -1, 1, arena);
+        }
+        case ExprOp::Div: {
+            const Expr* a = e->args[0];
+            const Expr* b = e->args[1];
+            if (Calculus::dependsOn(b, var)) return integralOf(arena.mul({ a, reciprocal(b, arena) }), x, arena);
+            const Expr* i = integralOf(a, x, arena);
+            if (i == nullptr) return nullptr;
+            return isInteger(b) && b->value != 0.0 ? Calculus::scale(i, 1, (long long)b->value, arena) : arena.div(i, b);
+        }
+        case ExprOp::Mul: {
+            std::vector<const Expr*> constant, varying;
+            for (const Expr* f : e->args) (Calculus::dependsOn(f, var) ? varying : constant).push_back(f);
+            if (!constant.empty()) {
+                const Expr* i = integralOf(arena.mul(varying), x, arena);
+                return i == nullptr ? nullptr : times(arena.mul(constant), i, arena);
+            }
+            std::stable_sort(varying.begin(), varying.end(), [](const Expr* a, const Expr* b) { return factorRank(a) < factorRank(b); });
+            const Expr* kernel = arena.mul(varying);
+            if (kernel != e) return integralOf(kernel, x, arena);
+            break;
+        }
+        default:
+            break;
+        }
+
+        IntegralTable::Match m;
+        if (!IntegralTable::instance().lookup(e, var, m)) return nullptr;
+        return instantiate(m.result, var, m, arena);
+    }
+
+    // like terms share a key: the body's factors in a fixed order
+    std::vector<const Expr*> termKey(const Expr* body) {
+        std::vector<const Expr*> key;
+        if (body == nullptr) return key;
+        if (body->op == ExprOp::Mul) key = body->args;
+        else key.push_back(body);
+        std::sort(key.begin(), key.end());
+        return key;
+    }
+}
+
+const Expr* Calculus::derivative(const Expr* e, const std::string& var, ExprArena& arena) {
+    return derivativeOf(e, arena.var(var), arena);
+}
+
+const Expr* Calculus::integral(const Expr* e, const std::string& var, ExprArena& arena) {
+    return integralOf(e, arena.var(var), arena);
+}
+
+bool Calculus::dependsOn(const Expr* e, const std::string& var) {
+    if (e->op == ExprOp::Var || e->op == ExprOp::Differential) return e->name == var;
+    if (e->op == ExprOp::Deriv && e->name == var) return true;
+    for (const Expr* a : e->args) {
+        if (dependsOn(a, var)) return true;
+    }
+    return false;
+}
+
+const Expr* Calculus::scale(const Expr* e, long long num, long long den, ExprArena& arena) {
+    if (e->op == ExprOp::Add) {
+        std::vector<const Expr*> terms;
+        for (const Expr* t : e->args) terms.push_back(scale(t, num, den, arena));
+        return arena.add(terms);
+    }
+    if (e->isConst() && !isInteger(e)) return arena.constant(e->value * double(num) / double(den));
+    long long n, d;
+    const Expr* body;
+    coefficient(e, n, d, body, arena);
+    return withCoefficient(n * num, d * den, body, arena);
+}
+
+const Expr* Calculus::collect(const Expr* e, ExprArena& arena) {
+    struct Group {
+        long long num, den;
+        const Expr* body;
+    };
+    std::vector<Group> groups;
+    std::map<std::vector<const Expr*>, size_t> index;
+    const std::vector<const Expr*>& terms = e->op == ExprOp::Add ? e->args : std::vector<const Expr*>(1, e);
+    for (const Expr* t : terms) {
+        Group g;
+        coefficient(t, g.num, g.den, g.body, arena);
+        std::vector<const Expr*> key = termKey(g.body);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            index[key] = groups.size();
+            groups.push_back(g);
+            continue;
+        }
+        // a/b + c/d over the least common denominator
+        Group& s = groups[it->second];
+        long long l = s.den / gcd(s.den, g.den) * g.den;
+        s.num = s.num * (l / s.den) + g.num * (l / g.den);
+        s.den = l;
+    }
+    std::vector<const Expr*> sum;
+    for (const Group& g : groups) {
+        if (g.num != 0) sum.push_back(withCoefficient(g.num, g.den, g.body, arena));
+    }
+    return arena.add(sum);
+}
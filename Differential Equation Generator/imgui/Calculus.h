@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Expr.h"
+
+#include <string>
+
+// Symbolic derivatives and table antiderivatives of elementary expressions.
+// Results are memoized on the input nodes, so a subexpression shared by many
+// equations is differentiated or integrated once per variable
+class Calculus {
+public:
+    // d/dvar of e; other variables are held constant. nullptr for equations and differentials
+    static const Expr* derivative(const Expr* e, const std::string& var, ExprArena& arena);
+    // antiderivative without the constant: linearity, constant factors, then the rule table.
+    // nullptr when no rule matches
+    static const Expr* integral(const Expr* e, const std::string& var, ExprArena& arena);
+
+    // true when var occurs in e
+    static bool dependsOn(const Expr* e, const std::string& var);
+    // e times num/den, folded into the coefficients of its terms ("(5/3)e^(3x)")
+    static const Expr* scale(const Expr* e, long long num, long long den, ExprArena& arena);
+    // adds up terms that differ only in their rational coefficient and drops the ones that cancel
+    static const Expr* collect(const Expr* e, ExprArena& arena);
+};
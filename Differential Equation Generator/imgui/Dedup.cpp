@@ -0,0 +1,37 @@
+#include "Dedup.h"
+
+namespace {
+
+    long long gcd(long long a, long long b) {
+        while (b != 0) {
+            long long t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+}
+
+size_t EquationKeyHash::operator()(const EquationKey& key) const {
+    size_t h = size_t(key.family) * 0x9e3779b97f4a7c15ULL;
+    for (long long c : key.coeffs) {
+        h ^= size_t(c) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+void CoefficientKey::normalize(std::vector<long long>& coeffs, size_t from) {
+    long long g = 0;
+    long long first = 0;
+    for (size_t i = from; i < coeffs.size(); i++) {
+        long long c = coeffs[i] < 0 ? -coeffs[i] : coeffs[i];
+        if (first == 0) first = coeffs[i];
+        g = gcd(c, g);
+        // a gcd of 1 can't be reduced further, only the sign is left to fix
+        if (g == 1) break;
+    }
+    if (g == 0) return;
+    if (first < 0) g = -g;
+    if (g == 1) return;
+    for (size_t i = from; i < coeffs.size(); i++) coeffs[i] /= g;
+}
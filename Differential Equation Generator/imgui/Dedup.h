@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_set>
+#include <vector>
+
+// Identity of a generated equation: its family (the generator choice) and coefficient vector
+struct EquationKey {
+    int family = 0;
+    std::vector<long long> coeffs;
+
+    bool operator==(const EquationKey& other) const {
+        return family == other.family && coeffs == other.coeffs;
+    }
+};
+
+struct EquationKeyHash {
+    size_t operator()(const EquationKey& key) const;
+};
+
+// gcd normalization for coefficient vectors of scale-invariant equations (... = 0, or both sides of a ratio)
+class CoefficientKey {
+public:
+    // divides coeffs[from..] by their gcd and makes the first non-zero one positive, so scalar
+    // multiples share a key; entries before from are structure tags and stay as they are
+    static void normalize(std::vector<long long>& coeffs, size_t from = 0);
+};
+
+// Keys generated so far, used to skip repeats
+class DedupIndex {
+public:
+    // true if key wasn't in the index yet
+    bool insert(const EquationKey& key) { return keys.insert(key).second; }
+    bool contains(const EquationKey& key) const { return keys.count(key) != 0; }
+    size_t size() const { return keys.size(); }
+    void clear() { keys.clear(); }
+
+private:
+    std::unordered_set<EquationKey, EquationKeyHash> keys;
+};
@@ -0,0 +1,341 @@
+#include "Exactness.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace {
+
+    long long gcd(long long a, long long b) {
+        if (a < 0) a = -a;
+        if (b < 0) b = -b;
+        while (b != 0) { long long t = a % b; a = b; b = t; }
+        return a;
+    }
+
+    ExactTerm makeTerm(long long num, long long den, int px, int py, TermFactor fx, TermFactor fy) {
+        if (den < 0) { num = -num; den = -den; }
+        long long g = gcd(num, den);
+        if (g > 1) { num /= g; den /= g; }
+        ExactTerm t = { num, den, px, py, fx, fy };
+        return t;
+    }
+
+    // exchanges the roles of x and y so every rule only has to be written for x
+    ExactTerm swapXY(const ExactTerm& t) {
+        ExactTerm s = { t.num, t.den, t.py, t.px, t.fy, t.fx };
+        return s;
+    }
+
+    // d/dx of a single term
+    void diffX(const ExactTerm& t, std::vector<ExactTerm>& out) {
+        if (t.px != 0) {
+            out.push_back(makeTerm(t.num * t.px, t.den, t.px - 1, t.py, t.fx, t.fy));
+        }
+        if (t.fx == TermFactor::Exp) {
+            out.push_back(t);
+        }
+        if (t.fx == TermFactor::Ln) {
+            out.push_back(makeTerm(t.num, t.den, t.px - 1, t.py, TermFactor::One, t.fy));
+        }
+    }
+
+    // antiderivative in x of a single term, false if it is not in the table
+    bool integrateX(const ExactTerm& t, std::vector<ExactTerm>& out) {
+        if (t.fx == TermFactor::One) {
+            if (t.px == -1) {
+                out.push_back(makeTerm(t.num, t.den, 0, t.py, TermFactor::Ln, t.fy));
+            }
+            else {
+                out.push_back(makeTerm(t.num, t.den * (t.px + 1), t.px + 1, t.py, TermFactor::One, t.fy));
+            }
+            return true;
+        }
+        if (t.fx == TermFactor::Exp && t.px == 0) {
+            out.push_back(t);
+            return true;
+        }
+        if (t.fx == TermFactor::Ln && t.px >= 0) {
+            // x^a ln(x) -> x^(a+1) ln(x) / (a+1) - x^(a+1) / (a+1)^2
+            long long k = t.px + 1;
+            out.push_back(makeTerm(t.num, t.den * k, t.px + 1, t.py, TermFactor::Ln, t.fy));
+            out.push_back(makeTerm(-t.num, t.den * k * k, t.px + 1, t.py, TermFactor::One, t.fy));
+            return true;
+        }
+        return false;
+    }
+
+    void diffY(const ExactTerm& t, std::vector<ExactTerm>& out) {
+        std::vector<ExactTerm> tmp;
+        diffX(swapXY(t), tmp);
+        for (const ExactTerm& s : tmp) out.push_back(swapXY(s));
+    }
+
+    bool integrateY(const ExactTerm& t, std::vector<ExactTerm>& out) {
+        std::vector<ExactTerm> tmp;
+        if (!integrateX(swapXY(t), tmp)) return false;
+        for (const ExactTerm& s : tmp) out.push_back(swapXY(s));
+        return true;
+    }
+
+    // merges like terms and drops zeros
+    std::vector<ExactTerm> combine(const std::vector<ExactTerm>& terms) {
+        typedef std::tuple<int, int, int, int> Key;
+        std::map<Key, std::pair<long long, long long>> sums;
+        std::vector<Key> order;
+        for (const ExactTerm& t : terms) {
+            Key k(t.px, t.py, int(t.fx), int(t.fy));
+            auto it = sums.find(k);
+            if (it == sums.end()) {
+                sums[k] = std::make_pair(t.num, t.den);
+                order.push_back(k);
+            }
+            else {
+                long long num = it->second.first * t.den + t.num * it->second.second;
+                long long den = it->second.second * t.den;
+                long long g = gcd(num, den);
+                if (g > 1) { num /= g; den /= g; }
+                it->second = std::make_pair(num, den);
+            }
+        }
+        std::vector<ExactTerm> out;
+        for (const Key& k : order) {
+            const std::pair<long long, long long>& c = sums[k];
+            if (c.first == 0) continue;
+            out.push_back(makeTerm(c.first, c.second, std::get<0>(k), std::get<1>(k),
+                TermFactor(std::get<2>(k)), TermFactor(std::get<3>(k))));
+        }
+        return out;
+    }
+
+    // random coefficient 1..9
+    long long coeff() { return Random::next() % 9 + 1; }
+}
+
+ExactForm ExactForm::random() {
+    // candidate potential terms, at least one of them mixes x and y
+    std::vector<ExactTerm> F;
+    int mixedCount = Random::next() % 2 + 1;
+    for (int i = 0; i < mixedCount; i++) {
+        switch (Random::next() % 5) {
+        case 0: F.push_back(makeTerm(coeff(), 1, Random::next() % 3 + 1, Random::next() % 3 + 1, TermFactor::One, TermFactor::One)); break;
+        case 1: F.push_back(makeTerm(coeff(), 1, 0, Random::next() % 2 + 1, TermFactor::Exp, TermFactor::One)); break;
+        case 2: F.push_back(makeTerm(coeff(), 1, Random::next() % 2 + 1, 0, TermFactor::One, TermFactor::Exp)); break;
+        case 3: F.push_back(makeTerm(coeff(), 1, 0, Random::next() % 2 + 1, TermFactor::Ln, TermFactor::One)); break;
+        default: F.push_back(makeTerm(coeff(), 1, Random::next() % 2 + 1, 0, TermFactor::One, TermFactor::Ln)); break;
+        }
+    }
+    // optional single variable terms
+    if (Random::next() % 2) F.push_back(makeTerm(coeff(), 1, Random::next() % 3 + 1, 0, TermFactor::One, TermFactor::One));
+    if (Random::next() % 2) F.push_back(makeTerm(coeff(), 1, 0, Random::next() % 3 + 1, TermFactor::One, TermFactor::One));
+
+    std::vector<ExactTerm> M, N;
+    for (const ExactTerm& t : F) {
+        diffX(t, M);
+        diffY(t, N);
+    }
+
+    ExactForm form;
+    form.M = combine(M);
+    form.N = combine(N);
+    return form;
+}
+
+ExactForm ExactForm::candidate() {
+    ExactForm form = random();
+    // a function of x alone or a mixed term for M; exchanging x and y makes one for N
+    auto extra = [](bool forM) {
+        int i = Random::next() % 3, j = Random::next() % 2 + 1;
+        ExactTerm t;
+        switch (Random::next() % 4) {
+        case 0: t = makeTerm(coeff(), 1, 0, 0, TermFactor::Exp, TermFactor::One); break;
+        case 1: t = makeTerm(coeff(), 1, i, 0, TermFactor::Ln, TermFactor::One); break;
+        case 2: t = makeTerm(coeff(), 1, -j, 0, TermFactor::One, TermFactor::One); break;
+        default: t = makeTerm(Random::next() % 3 + 1, 1, i, j, TermFactor::One, TermFactor::One); break;
+        }
+        return forM ? t : swapXY(t);
+    };
+    std::vector<ExactTerm> M = form.M, N = form.N;
+    M.push_back(extra(true));
+    N.push_back(extra(false));
+    form.M = combine(M);
+    form.N = combine(N);
+    return form;
+}
+
+ExactForm ExactForm::randomExact(int batch) {
+    std::vector<ExactForm> forms;
+    forms.reserve(batch);
+    for (int i = 0; i < batch; i++) forms.push_back(candidate());
+    std::vector<char> exact;
+    ExactnessVerifier::verifyBatch(forms, exact);
+    for (int i = 0; i < batch; i++) {
+        std::vector<ExactTerm> F;
+        if (exact[i] && forms[i].potentialTerms(F)) return forms[i];
+    }
+    return random();
+}
+
+size_t ExactForm::appendKey(std::vector<long long>& key) const {
+    // terms in a fixed order, so sums written in another order get the same key
+    auto layout = [](const ExactTerm& a, const ExactTerm& b) {
+        return std::make_tuple(a.px, a.py, int(a.fx), int(a.fy)) < std::make_tuple(b.px, b.py, int(b.fx), int(b.fy));
+    };
+    std::vector<ExactTerm> sorted[] = { M, N };
+    for (std::vector<ExactTerm>& side : sorted) std::sort(side.begin(), side.end(), layout);
+
+    key.push_back((long long)M.size());
+    key.push_back((long long)N.size());
+    long long den = 1;
+    for (const std::vector<ExactTerm>& side : sorted) {
+        for (const ExactTerm& t : side) {
+            key.push_back(t.px);
+            key.push_back(t.py);
+            key.push_back((long long)t.fx);
+            key.push_back((long long)t.fy);
+            den = den / gcd(den, t.den) * t.den;
+        }
+    }
+    size_t from = key.size();
+    for (const std::vector<ExactTerm>& side : sorted) {
+        for (const ExactTerm& t : side) key.push_back(t.num * (den / t.den));
+    }
+    return from;
+}
+
+const Expr* ExactForm::termsToExpr(ExprArena& arena, const std::vector<ExactTerm>& terms) {
+    const Expr* x = arena.var("x");
+    const Expr* y = arena.var("y");
+    std::vector<const Expr*> sum;
+    for (const ExactTerm& t : terms) {
+        long long num = t.num < 0 ? -t.num : t.num;
+        std::vector<const Expr*> factors;
+        // a fractional coefficient stays as num/den instead of a decimal
+        factors.push_back(t.den == 1 ? arena.constant(double(num)) : arena.div(arena.constant(double(num)), arena.constant(double(t.den))));
+        if (t.px != 0) factors.push_back(arena.pow(x, t.px));
+        if (t.py != 0) factors.push_back(arena.pow(y, t.py));
+        if (t.fx == TermFactor::Exp) factors.push_back(arena.func("exp", x));
+        if (t.fy == TermFactor::Exp) factors.push_back(arena.func("exp", y));
+        if (t.fx == TermFactor::Ln) factors.push_back(arena.func("ln", x));
+        if (t.fy == TermFactor::Ln) factors.push_back(arena.func("ln", y));
+        const Expr* term = arena.mul(factors);
+        sum.push_back(t.num < 0 ? arena.neg(term) : term);
+    }
+    return arena.add(sum);
+}
+
+bool ExactForm::potentialTerms(std::vector<ExactTerm>& F) const {
+    // F = integral of M dx + integral of (N - d/dy integral of M dx) dy
+    F.clear();
+    for (const ExactTerm& t : M) {
+        if (!integrateX(t, F)) return false;
+    }
+    F = combine(F);
+
+    std::vector<ExactTerm> rest = N;
+    for (const ExactTerm& t : F) {
+        std::vector<ExactTerm> d;
+        diffY(t, d);
+        for (ExactTerm& s : d) s.num = -s.num;
+        rest.insert(rest.end(), d.begin(), d.end());
+    }
+    rest = combine(rest);
+
+    for (const ExactTerm& t : rest) {
+        // anything left must be a function of y alone
+        if (t.px != 0 || t.fx != TermFactor::One) return false;
+        if (!integrateY(t, F)) return false;
+    }
+    F = combine(F);
+    return true;
+}
+
+std::string ExactForm::potential() const {
+    std::vector<ExactTerm> F;
+    if (!potentialTerms(F)) return "";
+    return ExprFormat::format(termsToExpr(ExprArena::shared(), F)) + " = C";
+}
+
+void ExactnessVerifier::verifyBatch(const std::vector<ExactForm>& forms, std::vector<char>& exact, int samples) {
+    // powers -MaxPower..MaxPower come from tables made once per sample point
+    const int MaxPower = 8;
+    struct Lane {
+        double coeff;
+        int px, py;
+        TermFactor fx, fy;
+        uint32_t form;
+        bool m; // a term of M, else of N
+    };
+    std::vector<Lane> lanes;
+    bool tabled = true;
+    for (size_t i = 0; i < forms.size(); i++) {
+        for (int side = 0; side < 2; side++) {
+            for (const ExactTerm& t : side == 0 ? forms[i].M : forms[i].N) {
+                lanes.push_back({ double(t.num) / double(t.den), t.px, t.py, t.fx, t.fy, (uint32_t)i, side == 0 });
+                tabled = tabled && std::abs(t.px) <= MaxPower && std::abs(t.py) <= MaxPower;
+            }
+        }
+    }
+    exact.assign(forms.size(), 1);
+    std::vector<double> difference(forms.size()), scale(forms.size());
+    // [seeded][power + MaxPower] and [seeded][factor], for x and for y
+    Dual powX[2][2 * MaxPower + 1], powY[2][2 * MaxPower + 1], facX[2][3], facY[2][3];
+    for (int s = 0; s < samples; s++) {
+        // sample inside (0.5, 2.0) so ln() is defined and powers stay well scaled
+        double x = 0.5 + 1.5 * (Random::next() / (Random::Max + 1.0));
+        double y = 0.5 + 1.5 * (Random::next() / (Random::Max + 1.0));
+        for (int seeded = 0; seeded < 2; seeded++) {
+            Dual dx(x, seeded), dy(y, seeded);
+            for (int p = -MaxPower; p <= MaxPower; p++) {
+                powX[seeded][p + MaxPower] = ipow(dx, p);
+                powY[seeded][p + MaxPower] = ipow(dy, p);
+            }
+            facX[seeded][int(TermFactor::One)] = facY[seeded][int(TermFactor::One)] = Dual(1.0);
+            facX[seeded][int(TermFactor::Exp)] = exp(dx);
+            facY[seeded][int(TermFactor::Exp)] = exp(dy);
+            facX[seeded][int(TermFactor::Ln)] = log(dx);
+            facY[seeded][int(TermFactor::Ln)] = log(dy);
+        }
+        std::fill(difference.begin(), difference.end(), 0.0);
+        std::fill(scale.begin(), scale.end(), 0.0);
+        for (const Lane& lane : lanes) {
+            // dM/dy seeds y, dN/dx seeds x
+            int sx = lane.m ? 0 : 1, sy = lane.m ? 1 : 0;
+            double d;
+            if (tabled) {
+                d = (Dual(lane.coeff) * powX[sx][lane.px + MaxPower] * facX[sx][int(lane.fx)] *
+                    powY[sy][lane.py + MaxPower] * facY[sy][int(lane.fy)]).der;
+            }
+            else {
+                ExactTerm t = { 1, 1, lane.px, lane.py, lane.fx, lane.fy };
+                d = lane.coeff * t.eval(Dual(x, sx), Dual(y, sy)).der;
+            }
+            if (!lane.m) d = -d;
+            difference[lane.form] += d;
+            scale[lane.form] += std::fabs(d);
+        }
+        for (size_t i = 0; i < forms.size(); i++) {
+            if (!(std::fabs(difference[i]) <= 1e-9 * (1.0 + scale[i]))) exact[i] = 0;
+        }
+    }
+}
+
+bool ExactnessVerifier::verify(const ExactForm& form, const ExprProgram& M, const ExprProgram& N,
+    const ExprProgram& Fx, const ExprProgram& Fy, int samples) {
+    for (int s = 0; s < samples; s++) {
+        // sample inside (0.5, 2.0) so ln() is defined and powers stay well scaled
+        double point[] = { 0.5 + 1.5 * (Random::next() / (Random::Max + 1.0)), 0.5 + 1.5 * (Random::next() / (Random::Max + 1.0)) };
+        double m = ExactForm::evalTerms(form.M, point[0], point[1]);
+        double n = ExactForm::evalTerms(form.N, point[0], point[1]);
+        const double pairs[][2] = { { m, M.eval(point) }, { n, N.eval(point) }, { m, Fx.eval(point) }, { n, Fy.eval(point) } };
+        for (const double* pair : pairs) {
+            double scale = 1.0 + std::fabs(pair[0]) + std::fabs(pair[1]);
+            if (!(std::fabs(pair[0] - pair[1]) <= 1e-9 * scale)) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Bytecode.h"
+#include "Expr.h"
+
+#include <string>
+#include <vector>
+#include <cmath>
+
+// Dual number for forward-mode automatic differentiation
+struct Dual {
+    double val; // value
+    double der; // derivative part
+
+    Dual(double v = 0.0, double d = 0.0) : val(v), der(d) {}
+};
+
+inline Dual operator+(Dual a, Dual b) { return Dual(a.val + b.val, a.der + b.der); }
+inline Dual operator-(Dual a, Dual b) { return Dual(a.val - b.val, a.der - b.der); }
+inline Dual operator*(Dual a, Dual b) { return Dual(a.val * b.val, a.der * b.val + a.val * b.der); }
+inline Dual exp(Dual a) { double e = std::exp(a.val); return Dual(e, e * a.der); }
+inline Dual log(Dual a) { return Dual(std::log(a.val), a.der / a.val); }
+
+// integer power by repeated multiplication, exponents here are small
+inline double ipow(double a, int n) {
+    double r = 1.0;
+    for (int i = n < 0 ? -n : n; i > 0; i--) r *= a;
+    return n < 0 ? 1.0 / r : r;
+}
+inline Dual ipow(Dual a, int n) {
+    if (n == 0) return Dual(1.0);
+    double p = ipow(a.val, n - 1);
+    return Dual(p * a.val, n * p * a.der);
+}
+
+// Factor depending on a single variable: 1, e^v or ln(v)
+enum class TermFactor { One, Exp, Ln };
+
+// single term of M or N: (num/den) * x^px * y^py * fx(x) * fy(y)
+struct ExactTerm {
+    long long num, den;
+    int px, py;
+    TermFactor fx, fy;
+
+    // evaluate at (x, y), works for double and Dual
+    template<class T>
+    T eval(T x, T y) const {
+        using std::exp;
+        using std::log;
+        T r = T(double(num) / double(den)) * ipow(x, px) * ipow(y, py);
+        if (fx == TermFactor::Exp) r = r * exp(x);
+        if (fx == TermFactor::Ln) r = r * log(x);
+        if (fy == TermFactor::Exp) r = r * exp(y);
+        if (fy == TermFactor::Ln) r = r * log(y);
+        return r;
+    }
+};
+
+// Differential form M(x,y) dx + N(x,y) dy = 0
+class ExactForm {
+public:
+    std::vector<ExactTerm> M, N;
+
+    static const int CandidateBatch = 32;
+
+    // evaluate a sum of terms
+    template<class T>
+    static T evalTerms(const std::vector<ExactTerm>& terms, T x, T y) {
+        T sum(0.0);
+        for (const ExactTerm& t : terms) sum = sum + t.eval(x, y);
+        return sum;
+    }
+
+    // Builds M = dF/dx and N = dF/dy from a random potential F
+    static ExactForm random();
+    // random() plus one more term for M and one for N, drawn independently: a function of
+    // x alone, of y alone, or a mixed x^i y^j that is only exact when the two match
+    static ExactForm candidate();
+    // first exact form of a batch of candidate() draws checked together, random() if none is
+    static ExactForm randomExact(int batch = CandidateBatch);
+
+    // Potential F(x,y) with dF/dx = M and dF/dy = N, false if it can't be integrated
+    bool potentialTerms(std::vector<ExactTerm>& F) const;
+    // potentialTerms() as "F = C", empty if it can't be integrated
+    std::string potential() const;
+    // Appends the term layout of M and N, then their coefficients over a common
+    // denominator; returns the index of the first coefficient
+    size_t appendKey(std::vector<long long>& key) const;
+    // Sum of terms as an expression, used for M, N and the potential
+    static const Expr* termsToExpr(ExprArena& arena, const std::vector<ExactTerm>& terms);
+};
+
+// Checks exactness at random sample points. verifyBatch() tests dM/dy == dN/dx of term lists
+// with dual numbers; verify() checks what is shown for an exact equation against its form:
+// the shown M and N, and the shown potential F through dF/dx == M and dF/dy == N, which
+// also makes the form exact. The programs are compiled over (x, y)
+class ExactnessVerifier {
+public:
+    // exact[i] is set to 1 if forms[i] passed every sample. The terms of all forms are laid
+    // out in one flat array, so each sample point is a single pass over every candidate
+    static void verifyBatch(const std::vector<ExactForm>& forms, std::vector<char>& exact, int samples = 4);
+    static bool verify(const ExactForm& form, const ExprProgram& M, const ExprProgram& N,
+        const ExprProgram& Fx, const ExprProgram& Fy, int samples = 4);
+};
@@ -0,0 +1,318 @@
+#include "Expr.h"
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+namespace {
+
+    void mix(size_t& h, size_t v) {
+        h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+
+    size_t hashNode(const Expr& e) {
+        size_t h = std::hash<int>()(int(e.op));
+        mix(h, std::hash<double>()(e.value));
+        mix(h, std::hash<std::string>()(e.name));
+        mix(h, std::hash<int>()(e.order * 4 + int(e.style)));
+        for (const Expr* a : e.args) mix(h, std::hash<const void*>()(a));
+        return h;
+    }
+
+    Expr node(ExprOp op) {
+        Expr e;
+        e.op = op;
+        return e;
+    }
+}
+
+bool ExprArena::NodeEqual::operator()(const Expr* a, const Expr* b) const {
+    // children are interned already, so comparing their pointers is enough
+    return a->op == b->op && a->value == b->value && a->order == b->order && a->style == b->style &&
+        a->name == b->name && a->args == b->args;
+}
+
+const Expr* ExprArena::intern(Expr& e) {
+    e.hash = hashNode(e);
+    auto it = table.find(&e);
+    if (it != table.end()) return *it;
+    nodes.push_back(std::move(e));
+    const Expr* p = &nodes.back();
+    table.insert(p);
+    return p;
+}
+
+void ExprArena::clear() {
+    table.clear();
+    nodes.clear();
+    generationCount++;
+}
+
+void ExprArena::release() {
+    if (nodes.size() > ScratchNodes) clear();
+}
+
+ExprArena& ExprArena::shared() {
+    static thread_local ExprArena arena;
+    return arena;
+}
+
+const Expr* ExprArena::constant(double v) {
+    Expr e = node(ExprOp::Const);
+    e.value = v == 0.0 ? 0.0 : v; // no -0
+    return intern(e);
+}
+
+const Expr* ExprArena::var(const std::string& name) {
+    Expr e = node(ExprOp::Var);
+    e.name = name;
+    return intern(e);
+}
+
+const Expr* ExprArena::add(std::vector<const Expr*> terms) {
+    Expr e = node(ExprOp::Add);
+    for (const Expr* t : terms) {
+        if (t->op == ExprOp::Add) e.args.insert(e.args.end(), t->args.begin(), t->args.end());
+        else if (!t->isConst(0.0)) e.args.push_back(t);
+    }
+    if (e.args.empty()) return constant(0.0);
+    if (e.args.size() == 1) return e.args[0];
+    return intern(e);
+}
+
+const Expr* ExprArena::mul(std::vector<const Expr*> factors) {
+    Expr e = node(ExprOp::Mul);
+    double coeff = 1.0;
+    e.args.reserve(factors.size() + 1);
+    for (const Expr* f : factors) {
+        // a nested product contributes its factors, anything else is one factor
+        const Expr* const* parts = f->op == ExprOp::Mul ? f->args.data() : &f;
+        size_t count = f->op == ExprOp::Mul ? f->args.size() : 1;
+        for (size_t i = 0; i < count; i++) {
+            if (parts[i]->isConst()) coeff *= parts[i]->value;
+            else e.args.push_back(parts[i]);
+        }
+    }
+    if (coeff == 0.0 || e.args.empty()) return constant(coeff);
+    if (coeff != 1.0) e.args.insert(e.args.begin(), constant(coeff));
+    if (e.args.size() == 1) return e.args[0];
+    return intern(e);
+}
+
+const Expr* ExprArena::div(const Expr* num, const Expr* den) {
+    Expr e = node(ExprOp::Div);
+    e.args = { num, den };
+    return intern(e);
+}
+
+const Expr* ExprArena::pow(const Expr* base, const Expr* exponent) {
+    if (exponent->isConst(1.0)) return base;
+    Expr e = node(ExprOp::Pow);
+    e.args = { base, exponent };
+    return intern(e);
+}
+
+const Expr* ExprArena::pow(const Expr* base, int exponent) {
+    return pow(base, constant(exponent));
+}
+
+const Expr* ExprArena::neg(const Expr* a) {
+    if (a->isConst()) return constant(-a->value);
+    Expr e = node(ExprOp::Neg);
+    e.args = { a };
+    return intern(e);
+}
+
+const Expr* ExprArena::func(const std::string& name, const Expr* arg) {
+    Expr e = node(ExprOp::Func);
+    e.name = name;
+    e.args = { arg };
+    return intern(e);
+}
+
+const Expr* ExprArena::deriv(const Expr* of, const std::string& wrt, int order, DerivStyle style) {
+    Expr e = node(ExprOp::Deriv);
+    e.name = wrt;
+    e.order = order;
+    e.style = style;
+    e.args = { of };
+    return intern(e);
+}
+
+const Expr* ExprArena::differential(const std::string& var) {
+    Expr e = node(ExprOp::Differential);
+    e.name = var;
+    return intern(e);
+}
+
+const Expr* ExprArena::equation(const Expr* lhs, const Expr* rhs) {
+    Expr e = node(ExprOp::Equation);
+    e.args = { lhs, rhs };
+    return intern(e);
+}
+
+const Expr* ExprArena::system(std::vector<const Expr*> equations) {
+    Expr e = node(ExprOp::System);
+    e.args = std::move(equations);
+    return intern(e);
+}
+
+namespace {
+
+    std::string format(const Expr* e);
+
+    bool isAtom(const Expr* e) {
+        return e->op == ExprOp::Var || e->op == ExprOp::Func || e->op == ExprOp::Differential ||
+            (e->op == ExprOp::Const && e->value >= 0.0);
+    }
+
+    std::string parens(const Expr* e, bool wrap) {
+        return wrap ? "(" + format(e) + ")" : format(e);
+    }
+
+    // a term without its sign; negative is set when the caller has to print " - "
+    std::string unsignedTerm(const Expr* e, bool& negative) {
+        negative = false;
+        if (e->op == ExprOp::Const && e->value < 0.0) {
+            negative = true;
+            return ExprFormat::number(-e->value);
+        }
+        if (e->op == ExprOp::Neg) {
+            negative = true;
+            return parens(e->args[0], e->args[0]->op == ExprOp::Add);
+        }
+        if (e->op == ExprOp::Mul && e->args[0]->isConst() && e->args[0]->value < 0.0) {
+            negative = true;
+            // format a temporary copy of the product with the coefficient made positive
+            Expr coeff = *e->args[0];
+            coeff.value = -coeff.value;
+            Expr positive = *e;
+            positive.args[0] = &coeff;
+            return format(&positive);
+        }
+        return format(e);
+    }
+
+    std::string formatMul(const Expr* e) {
+        std::string out;
+        std::vector<const Expr*> denom;
+        const Expr* previous = nullptr;
+
+        for (size_t i = 0; i < e->args.size(); i++) {
+            const Expr* f = e->args[i];
+            if (i == 0 && f->isConst()) {
+                // the coefficient is written in front, 1 is implied
+                if (f->value != 1.0) out = ExprFormat::number(f->value);
+                continue;
+            }
+            if (i == 0 && f->op == ExprOp::Div && f->args[0]->isConst() && f->args[1]->isConst()) {
+                // fractional coefficient, "(1/3)x^2"
+                out = "(" + format(f) + ")";
+                continue;
+            }
+            if (f->op == ExprOp::Pow && f->args[1]->isConst() && f->args[1]->value < 0.0) {
+                denom.push_back(f);
+                continue;
+            }
+            // "3x*dy/dx", "3xy": factors after the coefficient are joined by "*" except between plain variables
+            if (previous != nullptr && !(previous->op == ExprOp::Var && f->op == ExprOp::Var)) out += "*";
+            out += parens(f, f->op == ExprOp::Add || f->op == ExprOp::Neg || f->op == ExprOp::Div);
+            previous = f;
+        }
+
+        if (out.empty()) out = "1";
+        if (!denom.empty()) {
+            std::string d;
+            for (const Expr* f : denom) {
+                if (!d.empty()) d += "*";
+                std::string base = parens(f->args[0], !isAtom(f->args[0]));
+                double k = -f->args[1]->value;
+                d += k == 1.0 ? base : base + "^" + ExprFormat::number(k);
+            }
+            out += "/" + (denom.size() > 1 ? "(" + d + ")" : d);
+        }
+        return out;
+    }
+
+    std::string formatDeriv(const Expr* e) {
+        const Expr* of = e->args[0];
+        std::string k = std::to_string(e->order);
+        if (e->style == DerivStyle::Prime) {
+            // y'(t), y''(t)
+            std::string name = of->op == ExprOp::Func ? of->name : format(of);
+            std::string primes = e->order <= 3 ? std::string(e->order, '\'') : "^(" + k + ")";
+            return name + primes + (of->op == ExprOp::Func ? "(" + format(of->args[0]) + ")" : "");
+        }
+        std::string d = e->style == DerivStyle::Partial ? "∂" : "d";
+        std::string y = parens(of, !isAtom(of));
+        if (e->order == 1) return d + y + "/" + d + e->name;
+        return d + "^" + k + y + "/" + d + e->name + "^" + k;
+    }
+
+    std::string format(const Expr* e) {
+        switch (e->op) {
+        case ExprOp::Const:
+            return ExprFormat::number(e->value);
+        case ExprOp::Var:
+            return e->name;
+        case ExprOp::Add: {
+            std::string s;
+            for (size_t i = 0; i < e->args.size(); i++) {
+                bool negative;
+                std::string t = unsignedTerm(e->args[i], negative);
+                if (i == 0) s += (negative ? "-" : "") + t;
+                else s += (negative ? " - " : " + ") + t;
+            }
+            return s;
+        }
+        case ExprOp::Mul:
+            if (e->args[0]->isConst() && e->args[0]->value < 0.0) {
+                bool negative;
+                return "-" + unsignedTerm(e, negative);
+            }
+            return formatMul(e);
+        case ExprOp::Div: {
+            const Expr* den = e->args[1];
+            bool wrapDen = !(isAtom(den) || den->op == ExprOp::Deriv);
+            return parens(e->args[0], e->args[0]->op == ExprOp::Add) + "/" + parens(den, wrapDen);
+        }
+        case ExprOp::Pow: {
+            const Expr* ex = e->args[1];
+            bool simpleExp = ex->op == ExprOp::Var || (ex->isConst() && ex->value >= 0.0 && ex->value == std::floor(ex->value));
+            return parens(e->args[0], !isAtom(e->args[0])) + "^" + parens(ex, !simpleExp);
+        }
+        case ExprOp::Neg:
+            // same reading as a negative term in a sum, "-(2/3)x^3" or "-(x + 1)"
+            return "-" + parens(e->args[0], e->args[0]->op == ExprOp::Add);
+        case ExprOp::Func:
+            if (e->name == "exp") {
+                const Expr* a = e->args[0];
+                return "e^" + parens(a, a->op != ExprOp::Var);
+            }
+            return e->name + "(" + format(e->args[0]) + ")";
+        case ExprOp::Deriv:
+            return formatDeriv(e);
+        case ExprOp::Differential:
+            return "d" + e->name;
+        case ExprOp::Equation:
+            return format(e->args[0]) + " = " + format(e->args[1]);
+        case ExprOp::System: {
+            std::string s;
+            for (size_t i = 0; i < e->args.size(); i++) s += (i ? ",\n" : "") + format(e->args[i]);
+            return s;
+        }
+        }
+        return "";
+    }
+}
+
+std::string ExprFormat::format(const Expr* e) {
+    return ::format(e);
+}
+
+std::string ExprFormat::number(double v) {
+    if (v == std::floor(v) && std::fabs(v) < 1e15) return std::to_string((long long)v);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%g", v);
+    return buf;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Node kinds of the symbolic equation IR
+enum class ExprOp {
+    Const,        // value
+    Var,          // name
+    Add,          // args[0] + args[1] + ...
+    Mul,          // args[0] * args[1] * ..., numeric coefficient first
+    Div,          // args[0] / args[1]
+    Pow,          // args[0] ^ args[1]
+    Neg,          // -args[0]
+    Func,         // name(args[0]): sin, cos, ln, exp, or an unknown like y(t)
+    Deriv,        // order-th derivative of args[0] with respect to name
+    Differential, // d(name)
+    Equation,     // args[0] = args[1]
+    System        // list of equations
+};
+
+// How a derivative is written
+enum class DerivStyle { Leibniz, Partial, Prime };
+
+// Immutable, hash-consed expression node. Nodes are only created through
+// ExprArena, so structurally equal expressions are the same pointer
+struct Expr {
+    ExprOp op;
+    double value = 0.0;
+    std::string name;
+    int order = 0;
+    DerivStyle style = DerivStyle::Leibniz;
+    std::vector<const Expr*> args;
+    size_t hash = 0;
+    // canonical form found by Simplifier, filled in on first use
+    mutable const Expr* simplified = nullptr;
+    // last derivative and antiderivative Calculus took of this node, with the variable node they
+    // were taken in; a set variable with a null result records that no rule applied
+    mutable const Expr* derivative = nullptr;
+    mutable const Expr* derivativeVar = nullptr;
+    mutable const Expr* antiderivative = nullptr;
+    mutable const Expr* antiderivativeVar = nullptr;
+
+    bool isConst() const { return op == ExprOp::Const; }
+    bool isConst(double v) const { return op == ExprOp::Const && value == v; }
+};
+
+// Owns and interns expression nodes
+class ExprArena {
+public:
+    const Expr* constant(double v);
+    const Expr* var(const std::string& name);
+    // flattens nested sums, returns the single term or 0 when there is nothing to add
+    const Expr* add(std::vector<const Expr*> terms);
+    // flattens nested products and folds numeric factors into one leading coefficient
+    const Expr* mul(std::vector<const Expr*> factors);
+    const Expr* div(const Expr* num, const Expr* den);
+    const Expr* pow(const Expr* base, const Expr* exponent);
+    const Expr* pow(const Expr* base, int exponent);
+    const Expr* neg(const Expr* e);
+    const Expr* func(const std::string& name, const Expr* arg);
+    const Expr* deriv(const Expr* of, const std::string& wrt, int order = 1, DerivStyle style = DerivStyle::Leibniz);
+    const Expr* differential(const std::string& var);
+    const Expr* equation(const Expr* lhs, const Expr* rhs);
+    const Expr* system(std::vector<const Expr*> equations);
+
+    // nodes release() lets an arena grow to
+    static const size_t ScratchNodes = 1 << 16;
+
+    // number of distinct nodes
+    size_t size() const { return nodes.size(); }
+    // drops every node, pointers handed out before are invalid afterwards
+    void clear();
+    // counts clear() calls, so a cache keyed on nodes can tell that its keys are gone
+    unsigned generation() const { return generationCount; }
+    // clear() once the arena holds more than ScratchNodes. For the points between two
+    // equations, where nothing made from the arena is held on to
+    void release();
+
+    // arena shared by the equation generators, one per thread so the prefetch thread has its own
+    static ExprArena& shared();
+
+private:
+    struct NodeHash {
+        size_t operator()(const Expr* e) const { return e->hash; }
+    };
+    struct NodeEqual {
+        bool operator()(const Expr* a, const Expr* b) const;
+    };
+
+    const Expr* intern(Expr& e);
+
+    std::deque<Expr> nodes;
+    std::unordered_set<const Expr*, NodeHash, NodeEqual> table;
+    unsigned generationCount = 0;
+};
+
+// Formats expressions in the notation the generators display
+class ExprFormat {
+public:
+    static std::string format(const Expr* e);
+    // integers print without decimals
+    static std::string number(double v);
+};
@@ -0,0 +1,109 @@
+#include "FrameScheduler.h"
+
+#include "imgui_internal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // a press and release queued together trickle through on consecutive frames, and a
+    // held key or button repeats; poll at this interval while either is pending
+    const double RepeatInterval = 1.0 / 60.0;
+
+    // word at a time with a multiply and shift per word, fast enough to run every frame
+    uint64_t mix(uint64_t h, const void* bytes, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(bytes);
+        size_t words = size / 8;
+        for (size_t i = 0; i < words; i++) {
+            uint64_t w;
+            std::memcpy(&w, p + i * 8, 8);
+            h = (h ^ w) * 0x9E3779B97F4A7C15ULL;
+            h ^= h >> 29;
+        }
+        for (size_t i = words * 8; i < size; i++) h = (h ^ p[i]) * 0x100000001B3ULL;
+        return h;
+    }
+
+    // how long until the cursor of the focused text field blinks, negative when none is
+    double nextBlink(const ImGuiContext& g) {
+        const ImGuiInputTextState& state = g.InputTextState;
+        if (!g.IO.ConfigInputTextCursorBlink || state.ID == 0 || state.ID != g.ActiveId) return -1.0;
+        // visible while CursorAnim <= 0 and for 0.8 of every 1.2 seconds after that
+        if (state.CursorAnim <= 0.0f) return -state.CursorAnim + 0.001;
+        float phase = std::fmod(state.CursorAnim, 1.20f);
+        return (phase < 0.80f ? 0.80f - phase : 1.20f - phase) + 0.001;
+    }
+
+    bool inputHeld(const ImGuiContext& g) {
+        for (int button = 0; button < ImGuiMouseButton_COUNT; button++) {
+            if (g.IO.MouseDown[button]) return true;
+        }
+        for (int key = ImGuiKey_NamedKey_BEGIN; key < ImGuiKey_NamedKey_END; key++) {
+            if (ImGui::IsKeyDown((ImGuiKey)key)) return true;
+        }
+        return false;
+    }
+}
+
+double FrameScheduler::clock() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t FrameScheduler::checksum(const ImDrawData* data) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    if (!data || !data->Valid) return h;
+    h = mix(h, &data->DisplaySize, sizeof(data->DisplaySize));
+    for (int i = 0; i < data->CmdListsCount; i++) {
+        const ImDrawList* list = data->CmdLists[i];
+        h = mix(h, list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert));
+        h = mix(h, list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        for (const ImDrawCmd& cmd : list->CmdBuffer) {
+            h = mix(h, &cmd.ClipRect, sizeof(cmd.ClipRect));
+            h = mix(h, &cmd.TextureId, sizeof(cmd.TextureId));
+            unsigned int range[3] = { cmd.VtxOffset, cmd.IdxOffset, cmd.ElemCount };
+            h = mix(h, range, sizeof(range));
+        }
+    }
+    return h;
+}
+
+bool FrameScheduler::shouldRender(double now) {
+    bool render = woken || settle > 0 || (deadline >= 0.0 && now >= deadline);
+    if (!render) skipped++;
+    return render;
+}
+
+void FrameScheduler::frameRendered(double now) {
+    rendered++;
+    woken = false;
+    deadline = -1.0;
+    uint64_t sum = checksum(ImGui::GetDrawData());
+    if (sum != lastChecksum) {
+        lastChecksum = sum;
+        settle = SettleFrames;
+    }
+    else if (settle > 0) {
+        settle--;
+    }
+
+    const ImGuiContext& g = *ImGui::GetCurrentContext();
+    // input ImGui hasn't consumed yet needs frames of its own
+    if (g.InputEventsQueue.Size > 0) woken = true;
+    auto at = [&](double delay) {
+        if (delay >= 0.0) deadline = deadline < 0.0 ? now + delay : std::min(deadline, now + delay);
+    };
+    if (inputHeld(g)) at(RepeatInterval);
+    at(nextBlink(g));
+    if (g.HoveredId != 0 && g.HoveredIdTimer < g.Style.HoverDelayNormal) {
+        at(g.Style.HoverDelayNormal - g.HoveredIdTimer + 0.001);
+    }
+}
+
+double FrameScheduler::idleTimeout(double now) const {
+    if (woken || settle > 0) return 0.0;
+    if (deadline < 0.0) return -1.0;
+    return std::max(0.0, deadline - now);
+}
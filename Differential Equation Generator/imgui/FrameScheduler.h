@@ -0,0 +1,41 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <cstdint>
+
+// Decides whether the main loop needs another NewFrame/Render/Present. A frame is drawn
+// when input arrived, when the last frame's draw data differed from the one before, or
+// when ImGui has something timed coming up (a blinking text cursor, a hover delay, a held
+// key repeating); otherwise the loop can sleep until the next input or idleTimeout().
+// Times are in seconds on any monotonic clock, so the headless harness can simulate one
+class FrameScheduler {
+public:
+    // frames drawn after the draw data stops changing. ImGui settles popups and auto-sized
+    // windows over a couple of frames without any new input
+    static const int SettleFrames = 3;
+
+    // input, resize or any other change from outside ImGui; the next frame is drawn
+    void wake() { woken = true; }
+    // true when this iteration should run a frame
+    bool shouldRender(double now);
+    // after ImGui::Render(), looks at the new draw data and ImGui state for pending work
+    void frameRendered(double now);
+    // seconds the loop may wait for input before the next timed frame, negative for no limit
+    double idleTimeout(double now) const;
+
+    long long renderedFrames() const { return rendered; }
+    long long skippedFrames() const { return skipped; }
+
+    // steady_clock seconds, for loops that run in real time
+    static double clock();
+    // 64-bit hash of the vertices, indices and commands, equal for identical frames
+    static uint64_t checksum(const ImDrawData* data);
+
+private:
+    bool woken = true;
+    int settle = SettleFrames;
+    double deadline = -1.0;     // next timed frame, negative for none
+    uint64_t lastChecksum = 0;
+    long long rendered = 0, skipped = 0;
+};
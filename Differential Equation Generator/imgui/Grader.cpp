@@ -0,0 +1,660 @@
+#include "Grader.h"
+#include "Parser.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+    // Unevaluated sum hi + lo, about 32 significant digits. Used to re-check points where
+    // the double residual is too close to the tolerance to trust
+    struct DoubleDouble {
+        double hi, lo;
+        DoubleDouble(double h = 0.0, double l = 0.0) : hi(h), lo(l) {}
+    };
+
+    inline DoubleDouble quickTwoSum(double a, double b) {
+        double s = a + b;
+        return DoubleDouble(s, b - (s - a));
+    }
+
+    inline DoubleDouble twoSum(double a, double b) {
+        double s = a + b;
+        double bb = s - a;
+        return DoubleDouble(s, (a - (s - bb)) + (b - bb));
+    }
+
+    inline DoubleDouble operator+(DoubleDouble a, DoubleDouble b) {
+        DoubleDouble s = twoSum(a.hi, b.hi);
+        DoubleDouble t = twoSum(a.lo, b.lo);
+        s = quickTwoSum(s.hi, s.lo + t.hi);
+        return quickTwoSum(s.hi, s.lo + t.lo);
+    }
+    inline DoubleDouble operator-(DoubleDouble a) { return DoubleDouble(-a.hi, -a.lo); }
+    inline DoubleDouble operator-(DoubleDouble a, DoubleDouble b) { return a + (-b); }
+    inline DoubleDouble operator*(DoubleDouble a, DoubleDouble b) {
+        double p = a.hi * b.hi;
+        double e = std::fma(a.hi, b.hi, -p);
+        return quickTwoSum(p, e + (a.hi * b.lo + a.lo * b.hi));
+    }
+    inline DoubleDouble operator/(DoubleDouble a, DoubleDouble b) {
+        double q1 = a.hi / b.hi;
+        DoubleDouble r = a - b * DoubleDouble(q1);
+        double q2 = r.hi / b.hi;
+        r = r - b * DoubleDouble(q2);
+        double q3 = r.hi / b.hi;
+        return quickTwoSum(q1, q2) + DoubleDouble(q3);
+    }
+    inline DoubleDouble& operator+=(DoubleDouble& a, DoubleDouble b) { return a = a + b; }
+    inline DoubleDouble& operator-=(DoubleDouble& a, DoubleDouble b) { return a = a - b; }
+
+    const DoubleDouble Ln2(6.931471805599452862e-01, 2.319046813846299558e-17);
+    const DoubleDouble HalfPi(1.570796326794896558e+00, 6.123233995736766036e-17);
+
+    inline double toDouble(double v) { return v; }
+    inline double toDouble(DoubleDouble v) { return v.hi + v.lo; }
+
+    inline double jexp(double v) { return std::exp(v); }
+    inline double jlog(double v) { return std::log(v); }
+    inline double jsin(double v) { return std::sin(v); }
+    inline double jcos(double v) { return std::cos(v); }
+
+    DoubleDouble jexp(DoubleDouble a) {
+        if (!std::isfinite(a.hi) || a.hi > 709.0 || a.hi < -745.0) return DoubleDouble(std::exp(a.hi));
+        // e^a = 2^k * (e^(r/1024))^1024 with |r| <= ln2/2, the series runs on e^x - 1 to keep its digits
+        double k = std::nearbyint(a.hi / Ln2.hi);
+        DoubleDouble r = a - Ln2 * DoubleDouble(k);
+        r = DoubleDouble(r.hi / 1024.0, r.lo / 1024.0);
+        DoubleDouble s = r, term = r;
+        for (int i = 2; i < 14; i++) {
+            term = term * r / DoubleDouble(double(i));
+            s += term;
+            if (std::fabs(term.hi) < 1e-36) break;
+        }
+        for (int i = 0; i < 10; i++) s = s * DoubleDouble(2.0) + s * s;
+        s += DoubleDouble(1.0);
+        return DoubleDouble(std::ldexp(s.hi, int(k)), std::ldexp(s.lo, int(k)));
+    }
+
+    DoubleDouble jlog(DoubleDouble a) {
+        if (!(a.hi > 0.0) || !std::isfinite(a.hi)) return DoubleDouble(std::log(a.hi));
+        // one Newton step on e^y = a doubles the digits of the double log
+        DoubleDouble y(std::log(a.hi));
+        return y + a * jexp(-y) - DoubleDouble(1.0);
+    }
+
+    void sinCos(DoubleDouble a, DoubleDouble& sinOut, DoubleDouble& cosOut) {
+        if (!std::isfinite(a.hi)) {
+            sinOut = cosOut = DoubleDouble(std::sin(a.hi));
+            return;
+        }
+        double k = std::nearbyint(a.hi / HalfPi.hi);
+        DoubleDouble r = a - HalfPi * DoubleDouble(k);
+        DoubleDouble r2 = r * r;
+        DoubleDouble s = r, c(1.0), st = r, ct(1.0);
+        for (int i = 1; i < 20; i++) {
+            st = -st * r2 / DoubleDouble(double((2 * i) * (2 * i + 1)));
+            ct = -ct * r2 / DoubleDouble(double((2 * i - 1) * (2 * i)));
+            s += st;
+            c += ct;
+            if (std::fabs(st.hi) < 1e-36 && std::fabs(ct.hi) < 1e-36) break;
+        }
+        int quadrant = int(std::fmod(k, 4.0));
+        if (quadrant < 0) quadrant += 4;
+        switch (quadrant) {
+        case 0: sinOut = s; cosOut = c; break;
+        case 1: sinOut = c; cosOut = -s; break;
+        case 2: sinOut = -s; cosOut = -c; break;
+        default: sinOut = -c; cosOut = s; break;
+        }
+    }
+    inline DoubleDouble jsin(DoubleDouble a) { DoubleDouble s, c; sinCos(a, s, c); return s; }
+    inline DoubleDouble jcos(DoubleDouble a) { DoubleDouble s, c; sinCos(a, s, c); return c; }
+
+    // Taylor-mode interpreter for ExprProgram: every register holds the coefficients
+    // c_0..c_K of a truncated series, for Lanes points at a time. Register r, coefficient k,
+    // lane l lives at R[(r * (K + 1) + k) * Lanes + l]
+    template<class T>
+    class JetMachine {
+    public:
+        static const int L = ExprProgram::Lanes;
+
+        // inputs[i] holds count x (K + 1) coefficients, point-major; so does out
+        static void run(const ExprProgram& p, const T* const* inputs, int count, int K, T* out) {
+            const int width = K + 1;
+            // three scratch jets after the program's registers
+            const int scratch = p.registers();
+            std::vector<T> regs((scratch + 3) * width * L);
+            const std::vector<Instr>& code = p.instructions();
+            const std::vector<double>& constants = p.constantPool();
+
+            for (int base = 0; base < count; base += L) {
+                const int n = std::min(L, count - base);
+                for (const Instr& in : code) {
+                    T* d = jet(regs, in.dst, width);
+                    const T* a = jet(regs, in.a, width);
+                    const T* b = jet(regs, in.b, width);
+                    switch (in.op) {
+                    case OpCode::Const:
+                        fill(d, K, T(constants[in.imm]));
+                        break;
+                    case OpCode::Var: {
+                        const T* src = inputs[in.imm] + base * width;
+                        for (int k = 0; k <= K; k++) {
+                            for (int l = 0; l < n; l++) d[k * L + l] = src[l * width + k];
+                        }
+                        break;
+                    }
+                    case OpCode::Add: for (int i = 0; i < width * L; i++) d[i] = a[i] + b[i]; break;
+                    case OpCode::Sub: for (int i = 0; i < width * L; i++) d[i] = a[i] - b[i]; break;
+                    case OpCode::Neg: for (int i = 0; i < width * L; i++) d[i] = -a[i]; break;
+                    case OpCode::Mul: mul(d, a, b, K); break;
+                    case OpCode::Div: div(d, a, b, K); break;
+                    case OpCode::PowInt: powInt(d, a, in.imm, K, jet(regs, scratch, width)); break;
+                    case OpCode::Pow: {
+                        // a^b = e^(b ln a)
+                        T* s0 = jet(regs, scratch, width);
+                        T* s1 = jet(regs, scratch + 1, width);
+                        log(s0, a, K);
+                        mul(s1, b, s0, K);
+                        exp(d, s1, K);
+                        break;
+                    }
+                    case OpCode::Sin: sinCos(d, jet(regs, scratch, width), a, K); break;
+                    case OpCode::Cos: sinCos(jet(regs, scratch, width), d, a, K); break;
+                    case OpCode::Exp: exp(d, a, K); break;
+                    case OpCode::Ln: log(d, a, K); break;
+                    }
+                }
+                const T* r = jet(regs, p.resultRegister(), width);
+                for (int l = 0; l < n; l++) {
+                    for (int k = 0; k <= K; k++) out[(base + l) * width + k] = r[k * L + l];
+                }
+            }
+        }
+
+    private:
+        static T* jet(std::vector<T>& regs, int r, int width) { return regs.data() + r * width * L; }
+
+        static void fill(T* d, int K, T c0) {
+            for (int l = 0; l < L; l++) d[l] = c0;
+            for (int i = L; i < (K + 1) * L; i++) d[i] = T(0.0);
+        }
+
+        static void copy(T* d, const T* a, int K) {
+            std::copy(a, a + (K + 1) * L, d);
+        }
+
+        // c_k = sum of a_j b_(k-j)
+        static void mul(T* d, const T* a, const T* b, int K) {
+            for (int k = 0; k <= K; k++) {
+                T* dk = d + k * L;
+                for (int l = 0; l < L; l++) dk[l] = T(0.0);
+                for (int j = 0; j <= k; j++) {
+                    const T* aj = a + j * L;
+                    const T* bk = b + (k - j) * L;
+                    for (int l = 0; l < L; l++) dk[l] += aj[l] * bk[l];
+                }
+            }
+        }
+
+        // c_k = (a_k - sum over j >= 1 of b_j c_(k-j)) / b_0
+        static void div(T* d, const T* a, const T* b, int K) {
+            for (int k = 0; k <= K; k++) {
+                T* dk = d + k * L;
+                for (int l = 0; l < L; l++) dk[l] = a[k * L + l];
+                for (int j = 1; j <= k; j++) {
+                    for (int l = 0; l < L; l++) dk[l] -= b[j * L + l] * d[(k - j) * L + l];
+                }
+                for (int l = 0; l < L; l++) dk[l] = dk[l] / b[l];
+            }
+        }
+
+        // c_k = (1/k) sum over j >= 1 of j a_j c_(k-j)
+        static void exp(T* d, const T* a, int K) {
+            for (int l = 0; l < L; l++) d[l] = jexp(a[l]);
+            for (int k = 1; k <= K; k++) {
+                T* dk = d + k * L;
+                for (int l = 0; l < L; l++) dk[l] = T(0.0);
+                for (int j = 1; j <= k; j++) {
+                    for (int l = 0; l < L; l++) dk[l] += T(double(j)) * a[j * L + l] * d[(k - j) * L + l];
+                }
+                for (int l = 0; l < L; l++) dk[l] = dk[l] / T(double(k));
+            }
+        }
+
+        // c_k = (a_k - (1/k) sum over 1 <= j < k of j c_j a_(k-j)) / a_0
+        static void log(T* d, const T* a, int K) {
+            for (int l = 0; l < L; l++) d[l] = jlog(a[l]);
+            for (int k = 1; k <= K; k++) {
+                T* dk = d + k * L;
+                for (int l = 0; l < L; l++) dk[l] = T(0.0);
+                for (int j = 1; j < k; j++) {
+                    for (int l = 0; l < L; l++) dk[l] += T(double(j)) * d[j * L + l] * a[(k - j) * L + l];
+                }
+                for (int l = 0; l < L; l++) dk[l] = (a[k * L + l] - dk[l] / T(double(k))) / a[l];
+            }
+        }
+
+        static void sinCos(T* s, T* c, const T* a, int K) {
+            for (int l = 0; l < L; l++) {
+                s[l] = jsin(a[l]);
+                c[l] = jcos(a[l]);
+            }
+            for (int k = 1; k <= K; k++) {
+                T* sk = s + k * L;
+                T* ck = c + k * L;
+                for (int l = 0; l < L; l++) sk[l] = ck[l] = T(0.0);
+                for (int j = 1; j <= k; j++) {
+                    for (int l = 0; l < L; l++) {
+                        T ja = T(double(j)) * a[j * L + l];
+                        sk[l] += ja * c[(k - j) * L + l];
+                        ck[l] -= ja * s[(k - j) * L + l];
+                    }
+                }
+                for (int l = 0; l < L; l++) {
+                    sk[l] = sk[l] / T(double(k));
+                    ck[l] = ck[l] / T(double(k));
+                }
+            }
+        }
+
+        // binary powering, scratch has room for three jets
+        static void powInt(T* d, const T* a, int n, int K, T* scratch) {
+            const int stride = (K + 1) * L;
+            T* acc = scratch;
+            T* b = scratch + stride;
+            T* tmp = scratch + 2 * stride;
+            fill(acc, K, T(1.0));
+            copy(b, a, K);
+            for (int e = n < 0 ? -n : n; e > 0; e >>= 1) {
+                if (e & 1) {
+                    mul(tmp, acc, b, K);
+                    copy(acc, tmp, K);
+                }
+                if (e > 1) {
+                    mul(tmp, b, b, K);
+                    copy(b, tmp, K);
+                }
+            }
+            if (n >= 0) {
+                copy(d, acc, K);
+                return;
+            }
+            fill(b, K, T(1.0));
+            div(d, b, acc, K);
+        }
+    };
+
+    std::string derivativeName(int k) {
+        return "#" + std::to_string(k);
+    }
+
+    // Rewrites the equation side into an expression over indep and #0..#K standing for
+    // y, y', ..., y^(K). Differential forms M dx + N dy become M + N y'
+    struct ResidualBuilder {
+        ExprArena& arena;
+        const std::string& indep;
+        int order = 0;
+        bool ok = true;
+
+        ResidualBuilder(ExprArena& a, const std::string& x) : arena(a), indep(x) {}
+
+        bool isUnknown(const Expr* e) const {
+            if (e->op == ExprOp::Var) return e->name == "y";
+            return e->op == ExprOp::Func && e->name == "y" && e->args[0]->op == ExprOp::Var && e->args[0]->name == indep;
+        }
+
+        const Expr* derivative(int k) {
+            order = std::max(order, k);
+            return arena.var(derivativeName(k));
+        }
+
+        const Expr* build(const Expr* e) {
+            if (!ok) return e;
+            switch (e->op) {
+            case ExprOp::Const:
+                return e;
+            case ExprOp::Var:
+                if (e->name == indep) return e;
+                if (e->name == "y") return derivative(0);
+                ok = false;
+                return e;
+            case ExprOp::Deriv:
+                if (e->style == DerivStyle::Partial || e->name != indep || !isUnknown(e->args[0])) {
+                    ok = false;
+                    return e;
+                }
+                return derivative(e->order);
+            case ExprOp::Differential:
+                if (e->name == indep) return arena.constant(1.0);
+                if (e->name == "y") return derivative(1);
+                ok = false;
+                return e;
+            case ExprOp::Func:
+                if (isUnknown(e)) return derivative(0);
+                return arena.func(e->name, build(e->args[0]));
+            case ExprOp::Add:
+            case ExprOp::Mul: {
+                std::vector<const Expr*> args;
+                for (const Expr* a : e->args) args.push_back(build(a));
+                return e->op == ExprOp::Add ? arena.add(args) : arena.mul(args);
+            }
+            case ExprOp::Div: {
+                const Expr* num = build(e->args[0]);
+                return arena.div(num, build(e->args[1]));
+            }
+            case ExprOp::Pow: {
+                const Expr* base = build(e->args[0]);
+                return arena.pow(base, build(e->args[1]));
+            }
+            case ExprOp::Neg:
+                return arena.neg(build(e->args[0]));
+            default:
+                ok = false;
+                return e;
+            }
+        }
+    };
+
+    // Maps the functions ExprParser accepts onto the ones the VM has, and collects the
+    // free names of a submitted answer
+    struct AnswerLowering {
+        ExprArena& arena;
+        const std::string& indep;
+        std::vector<std::string> constants;
+        bool implicit = false;
+        bool ok = true;
+
+        AnswerLowering(ExprArena& a, const std::string& x) : arena(a), indep(x) {}
+
+        const Expr* lower(const Expr* e) {
+            if (!ok) return e;
+            switch (e->op) {
+            case ExprOp::Const:
+                return e;
+            case ExprOp::Var:
+                if (e->name == "y" || e->name[0] == '#') implicit = true;
+                else if (e->name != indep && std::find(constants.begin(), constants.end(), e->name) == constants.end()) {
+                    constants.push_back(e->name);
+                }
+                return e;
+            case ExprOp::Func: {
+                const Expr* arg = lower(e->args[0]);
+                if (e->name == "y") implicit = true;
+                if (e->name == "sqrt") return arena.pow(arg, arena.constant(0.5));
+                if (e->name == "tan") return arena.div(arena.func("sin", arg), arena.func("cos", arg));
+                if (e->name == "log") return arena.func("ln", arg);
+                if (e->name == "sinh" || e->name == "cosh") {
+                    const Expr* up = arena.func("exp", arg);
+                    const Expr* down = arena.func("exp", arena.neg(arg));
+                    return arena.mul({ arena.constant(0.5), arena.add({ up, e->name == "sinh" ? arena.neg(down) : down }) });
+                }
+                return arena.func(e->name, arg);
+            }
+            case ExprOp::Add:
+            case ExprOp::Mul: {
+                std::vector<const Expr*> args;
+                for (const Expr* a : e->args) args.push_back(lower(a));
+                return e->op == ExprOp::Add ? arena.add(args) : arena.mul(args);
+            }
+            case ExprOp::Div: {
+                const Expr* num = lower(e->args[0]);
+                return arena.div(num, lower(e->args[1]));
+            }
+            case ExprOp::Pow: {
+                const Expr* base = lower(e->args[0]);
+                return arena.pow(base, lower(e->args[1]));
+            }
+            case ExprOp::Neg:
+                return arena.neg(lower(e->args[0]));
+            default:
+                ok = false;
+                return e;
+            }
+        }
+    };
+
+    void splitTerms(const Expr* side, std::vector<const Expr*>& out) {
+        if (side->op == ExprOp::Add) out.insert(out.end(), side->args.begin(), side->args.end());
+        else out.push_back(side);
+    }
+
+    double uniform(double lo, double hi) {
+        return lo + (hi - lo) * (double)Random::next() / Random::Max;
+    }
+}
+
+bool AnswerGrader::prepare(const Expr* equation, const std::string& x, ExprArena& arena, const GradeOptions& opts) {
+    terms.clear();
+    graded.clear();
+    options = opts;
+    indep = x;
+    order = 0;
+    if (equation->op != ExprOp::Equation) return false;
+
+    ResidualBuilder builder(arena, indep);
+    const Expr* lhs = builder.build(equation->args[0]);
+    const Expr* rhs = builder.build(equation->args[1]);
+    if (!builder.ok || builder.order == 0 || builder.order > MaxOrder) return false;
+    order = builder.order;
+
+    std::vector<const Expr*> parts;
+    splitTerms(lhs, parts);
+    size_t lhsCount = parts.size();
+    splitTerms(rhs, parts);
+    std::vector<std::string> vars(1, indep);
+    for (int k = 0; k <= order; k++) vars.push_back(derivativeName(k));
+    terms.resize(parts.size());
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (!ExprProgram::compile(parts[i], vars, terms[i])) {
+            terms.clear();
+            return false;
+        }
+    }
+    rhsFrom = lhsCount;
+
+    // from the grader's own seed, not the thread's sequence, which the generators use
+    Random::Scope scope(options.seed);
+    xs.resize(options.samples);
+    constantValues.resize(options.samples * MaxConstants);
+    for (double& v : xs) v = uniform(options.lo, options.hi);
+    for (double& v : constantValues) v = uniform(0.5, 1.5);
+    return true;
+}
+
+GradeResult AnswerGrader::grade(const std::string& submission, ExprArena& arena) {
+    GradeResult result;
+    if (!ready()) {
+        result.message = "This equation can't be graded";
+        return result;
+    }
+    ExprParser::Error error;
+    const Expr* parsed = ExprParser::parse(submission, arena, &error);
+    if (!parsed) {
+        result.verdict = Verdict::ParseError;
+        result.message = error.message + " at position " + std::to_string(error.position);
+        return result;
+    }
+    // y = f, y(x) = f, or f
+    const Expr* f = parsed;
+    if (parsed->op == ExprOp::Equation) {
+        const Expr* lhs = parsed->args[0];
+        bool isY = (lhs->op == ExprOp::Var && lhs->name == "y") || (lhs->op == ExprOp::Func && lhs->name == "y");
+        if (!isY) {
+            result.verdict = Verdict::ParseError;
+            result.message = "Expected y = ...";
+            return result;
+        }
+        f = parsed->args[1];
+    }
+    else if (parsed->op == ExprOp::System) {
+        result.verdict = Verdict::ParseError;
+        result.message = "Expected a single answer";
+        return result;
+    }
+
+    // a cleared arena can hand out a graded node's address again
+    if (gradedGeneration != arena.generation()) {
+        graded.clear();
+        gradedGeneration = arena.generation();
+    }
+    auto it = graded.find(f);
+    if (it != graded.end()) return it->second;
+    result = gradeExpr(f, arena);
+    graded[f] = result;
+    return result;
+}
+
+void AnswerGrader::gradeBatch(const std::vector<std::string>& submissions, std::vector<GradeResult>& out, int threads) const {
+    out.assign(submissions.size(), GradeResult());
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    threads = std::max(1, std::min(threads, (int)submissions.size()));
+    // contiguous slices, so copies of one answer next to each other still hit a thread's cache
+    auto work = [&](int t) {
+        AnswerGrader local(*this);
+        local.graded.clear();
+        ExprArena arena;
+        local.gradedGeneration = arena.generation();
+        size_t begin = submissions.size() * t / threads, end = submissions.size() * (t + 1) / threads;
+        for (size_t i = begin; i < end; i++) out[i] = local.grade(submissions[i], arena);
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) workers.emplace_back(work, t);
+    work(0);
+    for (std::thread& worker : workers) worker.join();
+}
+
+GradeResult AnswerGrader::gradeExpr(const Expr* answer, ExprArena& arena) {
+    GradeResult result;
+    AnswerLowering lowering(arena, indep);
+    const Expr* f = lowering.lower(answer);
+    if (lowering.implicit) {
+        result.message = "Only explicit answers y = f(" + indep + ") can be graded";
+        return result;
+    }
+    ExprProgram program;
+    std::vector<std::string> vars(1, indep);
+    vars.insert(vars.end(), lowering.constants.begin(), lowering.constants.end());
+    if (!lowering.ok || lowering.constants.size() > (size_t)MaxConstants || !ExprProgram::compile(f, vars, program)) {
+        result.message = "The answer uses something the grader can't evaluate";
+        return result;
+    }
+
+    const int S = options.samples;
+    const int K = order;
+    const int width = K + 1;
+    const int numTerms = (int)terms.size();
+
+    // seed jets: x + h along the independent variable, constants don't move
+    std::vector<std::vector<double>> seeds(vars.size(), std::vector<double>(S * width, 0.0));
+    for (int p = 0; p < S; p++) {
+        seeds[0][p * width] = xs[p];
+        if (K > 0) seeds[0][p * width + 1] = 1.0;
+        for (size_t c = 1; c < vars.size(); c++) seeds[c][p * width] = constantValues[p * MaxConstants + c - 1];
+    }
+    std::vector<const double*> seedPtrs;
+    for (auto& s : seeds) seedPtrs.push_back(s.data());
+    std::vector<double> jets(S * width);
+    JetMachine<double>::run(program, seedPtrs.data(), S, K, jets.data());
+
+    // term inputs: x, y, y', ..., one array of S values each; y^(k) = k! c_k
+    std::vector<std::vector<double>> columns(width + 1, std::vector<double>(S));
+    columns[0] = xs;
+    for (int p = 0; p < S; p++) {
+        double factorial = 1.0;
+        for (int k = 0; k <= K; k++) {
+            if (k > 0) factorial *= k;
+            columns[k + 1][p] = jets[p * width + k] * factorial;
+        }
+    }
+    std::vector<const double*> columnPtrs;
+    for (auto& c : columns) columnPtrs.push_back(c.data());
+    std::vector<double> residual(S, 0.0), scale(S, 0.0), values(S);
+    for (int t = 0; t < numTerms; t++) {
+        terms[t].evalBatch(columnPtrs.data(), S, values.data());
+        double sign = t < (int)rhsFrom ? 1.0 : -1.0;
+        for (int p = 0; p < S; p++) {
+            residual[p] += sign * values[p];
+            scale[p] += std::fabs(values[p]);
+        }
+    }
+
+    std::vector<int> recheck;
+    bool failed = false;
+    for (int p = 0; p < S; p++) {
+        if (!std::isfinite(residual[p]) || !std::isfinite(scale[p])) continue;
+        result.points++;
+        double r = std::fabs(residual[p]);
+        if (r <= options.tolerance * scale[p]) {
+            result.maxResidual = std::max(result.maxResidual, scale[p] > 0.0 ? r / scale[p] : 0.0);
+        }
+        else if (r <= options.fallbackBand * scale[p]) {
+            recheck.push_back(p);
+        }
+        else {
+            failed = true;
+            result.maxResidual = std::max(result.maxResidual, r / scale[p]);
+        }
+    }
+
+    // cancellation inside the answer can leave a correct residual just above the
+    // tolerance in double, so those points are redone in double-double
+    if (!failed && !recheck.empty()) {
+        const int R = (int)recheck.size();
+        std::vector<std::vector<DoubleDouble>> seedsDD(vars.size(), std::vector<DoubleDouble>(R * width));
+        for (size_t v = 0; v < vars.size(); v++) {
+            for (int i = 0; i < R; i++) {
+                for (int k = 0; k < width; k++) seedsDD[v][i * width + k] = DoubleDouble(seeds[v][recheck[i] * width + k]);
+            }
+        }
+        std::vector<const DoubleDouble*> seedPtrsDD;
+        for (auto& s : seedsDD) seedPtrsDD.push_back(s.data());
+        std::vector<DoubleDouble> jetsDD(R * width);
+        JetMachine<DoubleDouble>::run(program, seedPtrsDD.data(), R, K, jetsDD.data());
+
+        std::vector<std::vector<DoubleDouble>> columnsDD(width + 1, std::vector<DoubleDouble>(R));
+        for (int i = 0; i < R; i++) {
+            columnsDD[0][i] = DoubleDouble(xs[recheck[i]]);
+            double factorial = 1.0;
+            for (int k = 0; k <= K; k++) {
+                if (k > 0) factorial *= k;
+                columnsDD[k + 1][i] = jetsDD[i * width + k] * DoubleDouble(factorial);
+            }
+        }
+        std::vector<const DoubleDouble*> columnPtrsDD;
+        for (auto& c : columnsDD) columnPtrsDD.push_back(c.data());
+        std::vector<DoubleDouble> residualDD(R), valuesDD(R);
+        std::vector<double> scaleDD(R, 0.0);
+        for (int t = 0; t < numTerms; t++) {
+            JetMachine<DoubleDouble>::run(terms[t], columnPtrsDD.data(), R, 0, valuesDD.data());
+            for (int i = 0; i < R; i++) {
+                if (t < (int)rhsFrom) residualDD[i] += valuesDD[i];
+                else residualDD[i] -= valuesDD[i];
+                scaleDD[i] += std::fabs(toDouble(valuesDD[i]));
+            }
+        }
+        for (int i = 0; i < R; i++) {
+            double r = std::fabs(toDouble(residualDD[i]));
+            result.maxResidual = std::max(result.maxResidual, r / scaleDD[i]);
+            if (!(r <= options.tolerance * scaleDD[i])) failed = true;
+        }
+        result.fallbacks = R;
+    }
+
+    if (failed) {
+        result.verdict = Verdict::Incorrect;
+        result.message = "The answer doesn't satisfy the equation";
+    }
+    else if (result.points < options.minPoints) {
+        result.verdict = Verdict::Undefined;
+        result.message = "The answer isn't defined at enough sample points";
+    }
+    else {
+        result.verdict = Verdict::Correct;
+        result.message = "The answer satisfies the equation";
+    }
+    return result;
+}
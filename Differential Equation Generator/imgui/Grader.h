@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Bytecode.h"
+#include "Expr.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class Verdict {
+    Correct,     // the residual vanishes at every sample point
+    Incorrect,
+    Undefined,   // the answer isn't finite at enough sample points
+    Unsupported, // implicit answers, or an equation that isn't an ODE in y
+    ParseError
+};
+
+struct GradeResult {
+    Verdict verdict = Verdict::Unsupported;
+    double maxResidual = 0.0; // largest relative residual over the points used
+    int points = 0;           // sample points where the answer was finite
+    int fallbacks = 0;        // points re-checked in double-double precision
+    std::string message;
+};
+
+struct GradeOptions {
+    double tolerance = 1e-9;   // |residual| <= tolerance * sum of |terms|
+    double fallbackBand = 1e-3; // relative residuals between tolerance and this are re-checked
+    int samples = 16;
+    int minPoints = 6;
+    double lo = 0.5, hi = 2.5; // sample interval, positive so ln(x) and Cauchy-Euler answers stay defined
+    unsigned seed = 1;         // of the sample points and constant values, so a grade never changes
+};
+
+// Checks submitted solutions y = f(x) of a generated ODE by substituting them into the
+// residual at random sample points. Derivatives of f come from Taylor-mode evaluation of
+// its bytecode, so no symbolic differentiation is needed. Free names other than the
+// independent variable (C, C1, A, ...) are arbitrary constants and get random values
+class AnswerGrader {
+public:
+    static const int MaxOrder = 8;
+    static const int MaxConstants = 8;
+
+    // builds the residual of equation in the unknown y(indep), false when it isn't an ODE
+    // in y (partial equations, systems) or its order is above MaxOrder
+    bool prepare(const Expr* equation, const std::string& indep, ExprArena& arena, const GradeOptions& options = GradeOptions());
+
+    // submission is "y = f", "y(x) = f" or just f
+    // identical answers (after parsing, so spacing doesn't matter) are graded once
+    GradeResult grade(const std::string& submission, ExprArena& arena);
+    // grades a class's submissions, split over threads (<= 0 uses one per hardware thread).
+    // The term programs keep scratch registers, so every thread works on its own copy of
+    // the grader and its own arena; out[i] is what grade(submissions[i]) would return
+    void gradeBatch(const std::vector<std::string>& submissions, std::vector<GradeResult>& out, int threads = 0) const;
+
+    bool ready() const { return !terms.empty(); }
+
+private:
+    GradeResult gradeExpr(const Expr* f, ExprArena& arena);
+
+    GradeOptions options;
+    std::string indep;
+    int order = 0;
+    // lhs terms, then rhs terms from rhsFrom on, over inputs (indep, y, y', ..., y^(order))
+    std::vector<ExprProgram> terms;
+    size_t rhsFrom = 0;
+    // sample points and constant values, samples x MaxConstants
+    std::vector<double> xs, constantValues;
+    std::unordered_map<const Expr*, GradeResult> graded;
+    unsigned gradedGeneration = 0; // of the arena the keys of graded came from
+};
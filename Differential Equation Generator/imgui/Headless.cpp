@@ -0,0 +1,344 @@
+#include "Headless.h"
+#include "InputLog.h"
+#include "Profiler.h"
+
+#include "imgui_internal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+long long HeadlessHost::allocations = 0;
+long long HeadlessHost::bytes = 0;
+
+namespace {
+
+    void* countingAlloc(size_t size, void*) {
+        HeadlessHost::allocations++;
+        HeadlessHost::bytes += (long long)size;
+        return std::malloc(size);
+    }
+
+    void countingFree(void* ptr, void*) {
+        std::free(ptr);
+    }
+
+    // visible part of a widget label, "Generate##main" -> "Generate"
+    std::string visibleLabel(const char* label) {
+        const char* end = std::strstr(label, "##");
+        return end ? std::string(label, end) : std::string(label);
+    }
+
+    ImGuiKey keyByName(const std::string& name) {
+        for (int key = ImGuiKey_NamedKey_BEGIN; key < ImGuiKey_NamedKey_END; key++) {
+            if (name == ImGui::GetKeyName((ImGuiKey)key)) return (ImGuiKey)key;
+        }
+        return ImGuiKey_None;
+    }
+}
+
+// Test engine hooks are the only place ImGui reports item rectangles together with their
+// labels, which is what clicking by label needs. They exist when ImGui itself is compiled
+// with IMGUI_ENABLE_TEST_ENGINE; without it scripts can still click by position
+struct HeadlessHooks {
+    // labels are stored once per id, so a steady frame records without allocating
+    static void record(ImGuiContext* ctx, ImGuiID id, const char* label, const ImRect& bb) {
+        HeadlessHost* host = static_cast<HeadlessHost*>(ctx->TestEngine);
+        if (!host || !label) return;
+        if (host->labels.find(id) == host->labels.end()) host->labels[id] = visibleLabel(label);
+        host->building.push_back({ id, ImVec4(bb.Min.x, bb.Min.y, bb.Max.x, bb.Max.y) });
+    }
+};
+
+#ifdef IMGUI_ENABLE_TEST_ENGINE
+namespace {
+    ImGuiID lastItemId = 0;
+    ImRect lastItemRect;
+}
+
+void ImGuiTestEngineHook_ItemAdd(ImGuiContext*, ImGuiID id, const ImRect& bb, const ImGuiLastItemData*) {
+    lastItemId = id;
+    lastItemRect = bb;
+}
+
+void ImGuiTestEngineHook_ItemInfo(ImGuiContext* ctx, ImGuiID id, const char* label, ImGuiItemStatusFlags) {
+    if (id == lastItemId) HeadlessHooks::record(ctx, id, label, lastItemRect);
+}
+
+void ImGuiTestEngineHook_Log(ImGuiContext*, const char*, ...) {
+}
+
+const char* ImGuiTestEngine_FindItemDebugLabel(ImGuiContext*, ImGuiID) {
+    return nullptr;
+}
+#endif
+
+bool InputScript::parse(const std::string& text, std::vector<InputAction>& actions, std::string* error) {
+    std::istringstream lines(text);
+    std::string line;
+    int number = 0;
+    while (std::getline(lines, line)) {
+        number++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos && line.find('"') > hash) line.erase(hash);
+        std::istringstream in(line);
+        InputAction action;
+        std::string verb;
+        if (!(in >> action.frame)) {
+            // blank or comment-only lines
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            if (error) *error = "line " + std::to_string(number) + ": expected a frame number";
+            return false;
+        }
+        bool ok = (bool)(in >> verb);
+        if (verb == "move" || verb == "click") {
+            action.kind = verb == "move" ? InputAction::Kind::Move : InputAction::Kind::Click;
+            in >> std::ws;
+            if (action.kind == InputAction::Kind::Click && in.peek() == '"') {
+                ok = (bool)(in >> std::quoted(action.text));
+            }
+            else {
+                ok = (bool)(in >> action.x >> action.y);
+            }
+        }
+        else if (verb == "down" || verb == "up") {
+            action.kind = verb == "down" ? InputAction::Kind::Down : InputAction::Kind::Up;
+            if (!(in >> action.button)) action.button = 0;
+            ok = action.button >= 0 && action.button < ImGuiMouseButton_COUNT;
+        }
+        else if (verb == "wheel") {
+            action.kind = InputAction::Kind::Wheel;
+            ok = (bool)(in >> action.y);
+        }
+        else if (verb == "key") {
+            action.kind = InputAction::Kind::Key;
+            std::string name;
+            ok = (bool)(in >> name) && (action.button = keyByName(name)) != ImGuiKey_None;
+        }
+        else if (verb == "text") {
+            action.kind = InputAction::Kind::Text;
+            ok = (bool)(in >> std::quoted(action.text));
+        }
+        else {
+            ok = false;
+        }
+        if (!ok || action.frame < 0) {
+            if (error) *error = "line " + std::to_string(number) + ": can't read \"" + line + "\"";
+            return false;
+        }
+        actions.push_back(action);
+    }
+    std::stable_sort(actions.begin(), actions.end(), [](const InputAction& a, const InputAction& b) { return a.frame < b.frame; });
+    return true;
+}
+
+const char* InputScript::defaultScript() {
+    return
+        "# first-order popup, both parameters on\n"
+        "5 click \"First-Order Linear\"\n"
+        "10 click \"Homogeneous?\"\n"
+        "14 click \"Variable coefficient?\"\n"
+        "18 click \"Confirm\"\n"
+        "24 click \"Generate Equation\"\n"
+        "# each header opened and closed again, together they're taller than the display\n"
+        "30 click \"Step-by-Step Solution\"\n"
+        "36 click \"Step-by-Step Solution\"\n"
+        "42 click \"Slope Field\"\n"
+        "48 click \"Slope Field\"\n"
+        "60 click \"Close\"\n"
+        "# every other type, generated and closed\n"
+        "66 click \"Cauchy-Euler\"\n"
+        "70 click \"Generate Equation\"\n"
+        "80 click \"Close\"\n"
+        "86 click \"Higher-Order\"\n"
+        "90 click \"Generate Equation\"\n"
+        "100 click \"Close\"\n"
+        "106 click \"Partial \"\n"
+        "110 click \"Generate Equation\"\n"
+        "120 click \"Close\"\n"
+        "126 click \"System of Equations\"\n"
+        "130 click \"Generate Equation\"\n"
+        "140 click \"Close\"\n"
+        "146 click \"Seperable\"\n"
+        "150 click \"Generate Equation\"\n"
+        "160 click \"Close\"\n"
+        "166 click \"Exact\"\n"
+        "170 click \"Generate Equation\"\n"
+        "180 click \"Close\"\n"
+        "186 click \"Laplace Transform\"\n"
+        "190 click \"Generate Equation\"\n"
+        "200 click \"Close\"\n"
+        "206 click \"Frobenius Series\"\n"
+        "210 click \"Generate Equation\"\n"
+        "220 click \"Close\"\n";
+}
+
+HeadlessHost::HeadlessHost(float width, float height, const char* font, float fontSize) {
+    ImGui::SetAllocatorFunctions(countingAlloc, countingFree);
+    context = ImGui::CreateContext();
+    context->TestEngine = this;
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.LogFilename = nullptr;
+    io.DisplaySize = ImVec2(width, height);
+    io.DeltaTime = frameTime;
+    io.BackendPlatformName = "headless";
+    io.BackendRendererName = "null";
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+
+    // a missing file would trip ImGui's assert, check it first
+    FILE* file = font ? std::fopen(font, "rb") : nullptr;
+    if (file) {
+        std::fclose(file);
+        io.Fonts->AddFontFromFileTTF(font, fontSize);
+    }
+    else {
+        io.Fonts->AddFontDefault();
+    }
+    // the null renderer never samples the atlas, but ImGui wants it built and named
+    unsigned char* pixels;
+    int w, h;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &w, &h);
+    io.Fonts->SetTexID((ImTextureID)1);
+    ImGui::StyleColorsLight();
+    items.reserve(1024);
+    building.reserve(1024);
+}
+
+HeadlessHost::~HeadlessHost() {
+    ImGui::DestroyContext(context);
+}
+
+void HeadlessHost::apply(const InputAction& action) {
+    ImGuiIO& io = ImGui::GetIO();
+    switch (action.kind) {
+    case InputAction::Kind::Move:
+        io.AddMousePosEvent(action.x, action.y);
+        break;
+    case InputAction::Kind::Down:
+    case InputAction::Kind::Up:
+        io.AddMouseButtonEvent(action.button, action.kind == InputAction::Kind::Down);
+        break;
+    case InputAction::Kind::Click: {
+        ImVec2 at(action.x, action.y);
+        if (!action.text.empty() && !findItem(action.text, at)) {
+            missed.push_back(action.text);
+            break;
+        }
+        // ImGui trickles the queue, so the press and release land on consecutive frames
+        io.AddMousePosEvent(at.x, at.y);
+        io.AddMouseButtonEvent(0, true);
+        io.AddMouseButtonEvent(0, false);
+        break;
+    }
+    case InputAction::Kind::Wheel:
+        io.AddMouseWheelEvent(0.0f, action.y);
+        break;
+    case InputAction::Kind::Key:
+        io.AddKeyEvent((ImGuiKey)action.button, true);
+        io.AddKeyEvent((ImGuiKey)action.button, false);
+        break;
+    case InputAction::Kind::Text:
+        io.AddInputCharactersUTF8(action.text.c_str());
+        break;
+    }
+}
+
+bool HeadlessHost::poll() {
+    ImGui::SetCurrentContext(context);
+    bool any = false;
+    while (script && nextAction < script->size() && (*script)[nextAction].frame <= frameCount - scriptStart) {
+        apply((*script)[nextAction++]);
+        any = true;
+    }
+    return any;
+}
+
+bool HeadlessHost::labelsNeeded() const {
+    for (size_t i = nextAction; script && i < script->size() && (*script)[i].frame <= frameCount - scriptStart + 1; i++) {
+        if ((*script)[i].kind == InputAction::Kind::Click && !(*script)[i].text.empty()) return true;
+    }
+    return false;
+}
+
+FrameStats HeadlessHost::frame(const std::function<void()>& ui) {
+    poll();
+    // item hooks cost time and make retained windows submit their widgets, so they're only
+    // on for the frames whose items a click looks up
+    context->TestEngineHookItems = labelsNeeded();
+    ImGui::GetIO().DeltaTime = frameTime * (skippedFrames + 1);
+    skippedFrames = 0;
+    if (player) player->beginFrame();
+    if (recorder) recorder->beginFrame();
+
+    FrameStats stats;
+    long long allocationsBefore = allocations, bytesBefore = bytes;
+    building.clear();
+    auto start = std::chrono::steady_clock::now();
+    ImGui::NewFrame();
+    ui();
+    {
+        PROFILE_ZONE("ImGui::Render");
+        ImGui::Render();
+    }
+    auto end = std::chrono::steady_clock::now();
+    stats.cpuMs = std::chrono::duration<double, std::milli>(end - start).count();
+    if (recorder) recorder->endFrame(stats.cpuMs);
+    if (player) player->endFrame();
+    stats.allocations = allocations - allocationsBefore;
+    stats.bytes = bytes - bytesBefore;
+
+    ImDrawData* draw = ImGui::GetDrawData();
+    stats.vertices = draw->TotalVtxCount;
+    stats.indices = draw->TotalIdxCount;
+    stats.drawLists = draw->CmdListsCount;
+    items.swap(building);
+    frameCount++;
+    return stats;
+}
+
+void HeadlessHost::skip() {
+    skippedFrames++;
+    frameCount++;
+}
+
+void HeadlessHost::play(const std::vector<InputAction>& actions) {
+    // action frames count from here, so a host can replay a script twice
+    script = &actions;
+    scriptStart = frameCount;
+    nextAction = 0;
+}
+
+void HeadlessHost::replay(InputPlayer* player) {
+    this->player = player;
+    script = nullptr;
+}
+
+void HeadlessHost::record(InputRecorder* recorder) {
+    this->recorder = recorder;
+}
+
+std::vector<FrameStats> HeadlessHost::run(const std::function<void()>& ui, int count, const std::vector<InputAction>& actions) {
+    play(actions);
+    std::vector<FrameStats> stats;
+    stats.reserve(count > 0 ? count : 0);
+    for (int i = 0; i < count; i++) stats.push_back(frame(ui));
+    script = nullptr;
+    return stats;
+}
+
+bool HeadlessHost::findItem(const std::string& label, ImVec2& center) const {
+    // the last one wins, a window shares its title with the button that ends up on top of it
+    for (auto item = items.rbegin(); item != items.rend(); ++item) {
+        auto it = labels.find(item->first);
+        if (it == labels.end() || it->second != label) continue;
+        center = ImVec2((item->second.x + item->second.z) * 0.5f, (item->second.y + item->second.w) * 0.5f);
+        return true;
+    }
+    return false;
+}
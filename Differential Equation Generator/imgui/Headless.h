@@ -0,0 +1,103 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class InputPlayer;
+class InputRecorder;
+
+// One scripted input event, queued before frame `frame` starts
+struct InputAction {
+    enum class Kind { Move, Down, Up, Click, Wheel, Key, Text };
+
+    int frame = 0;
+    Kind kind = Kind::Move;
+    float x = 0.0f, y = 0.0f;   // position for Move/Down/Up/Click, scroll for Wheel
+    int button = 0;             // mouse button, or the ImGuiKey for Key
+    std::string text;           // label to click instead of a position, or characters for Text
+};
+
+// Scripts are one action per line, '#' starts a comment:
+//   <frame> move <x> <y>        <frame> click <x> <y>       <frame> click "<label>"
+//   <frame> down [button]       <frame> up [button]         <frame> wheel <dy>
+//   <frame> key <ImGuiKey name> <frame> text "<characters>"
+// Labels are matched against the visible part of widget labels seen the frame before
+class InputScript {
+public:
+    // false with a line number in error on the first line that doesn't parse
+    static bool parse(const std::string& text, std::vector<InputAction>& actions, std::string* error = nullptr);
+    // visits every equation type, generates one of each and closes the display again
+    static const char* defaultScript();
+};
+
+// Cost of one NewFrame/ui/Render cycle
+struct FrameStats {
+    double cpuMs = 0.0;
+    int vertices = 0, indices = 0, drawLists = 0;
+    long long allocations = 0;  // ImGui heap allocations
+    long long bytes = 0;
+};
+
+// ImGui context with no platform window and no renderer. Input comes from scripted
+// actions or a recorded log, draw data is produced by ImGui::Render() and only measured, never drawn
+class HeadlessHost {
+public:
+    // font is a TTF path, the default ImGui font when it's null or can't be opened
+    HeadlessHost(float width = 800.0f, float height = 600.0f, const char* font = nullptr, float fontSize = 16.0f);
+    ~HeadlessHost();
+    HeadlessHost(const HeadlessHost&) = delete;
+    HeadlessHost& operator=(const HeadlessHost&) = delete;
+
+    // queues the actions scheduled for the current frame, true when there were any
+    bool poll();
+    // poll(), then runs and times one frame
+    FrameStats frame(const std::function<void()>& ui);
+    // lets the current frame pass without running it; the next frame's DeltaTime covers it
+    void skip();
+    // plays actions sorted by frame from the next frame on; they must outlive the playback
+    void play(const std::vector<InputAction>& actions);
+    // replays a recorded log instead of a script from the next frame on, nullptr stops
+    void replay(InputPlayer* player);
+    // writes every frame from the next one on into the log, nullptr stops
+    void record(InputRecorder* recorder);
+    // play() and count frames
+    std::vector<FrameStats> run(const std::function<void()>& ui, int count, const std::vector<InputAction>& actions);
+
+    int frameIndex() const { return frameCount; }
+    // a click by label is due next frame, so the current one has to report its items
+    bool labelsNeeded() const;
+    // center of the last item with that visible label in the last frame, false when there was none
+    bool findItem(const std::string& label, ImVec2& center) const;
+    // labels of unresolved clicks so far
+    const std::vector<std::string>& missedLabels() const { return missed; }
+
+    // ImGui heap counters, running totals across the host's lifetime
+    static long long allocations;
+    static long long bytes;
+
+private:
+    ImGuiContext* context = nullptr;
+    int frameCount = 0;
+    int skippedFrames = 0;      // since the last frame that ran
+    float frameTime = 1.0f / 60.0f;
+    const std::vector<InputAction>* script = nullptr;
+    int scriptStart = 0;
+    size_t nextAction = 0;
+    std::vector<std::string> missed;
+    InputPlayer* player = nullptr;
+    InputRecorder* recorder = nullptr;
+
+    // id and rectangle of the labeled items of the last frame and of the one in progress,
+    // filled by the test engine hooks
+    std::vector<std::pair<ImGuiID, ImVec4>> items, building;
+    std::unordered_map<ImGuiID, std::string> labels;
+
+    void apply(const InputAction& action);
+
+    friend struct HeadlessHooks;
+};
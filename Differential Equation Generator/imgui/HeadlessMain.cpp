@@ -0,0 +1,291 @@
+// Headless frame harness: runs App::RenderUI without a window or GPU and reports what each
+// frame costs. Built on Linux, see the README; not part of the Visual Studio build
+#include "AllocationTracker.h"
+#include "App.h"
+#include "FrameScheduler.h"
+#include "Headless.h"
+#include "InputLog.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "SoftwareRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef ALLOCATION_TRACKING
+#error "the harness counts operator new through AllocationTracker, build it with -DALLOCATION_TRACKING"
+#endif
+
+namespace {
+    struct Options {
+        int frames = 240;
+        int warmup = 10;             // first frames create windows and aren't budgeted
+        unsigned seed = 1;
+        double budgetMs = 0.0;       // p95 frame time limit, 0 for none
+        long long maxAllocations = -1; // allocations per steady frame limit, -1 for none
+        bool perFrame = false;
+        bool idle = false;           // let FrameScheduler skip frames that would draw nothing new
+        bool realtime = false;       // pace frames at 60 Hz, so background work gets the time it would in the app
+        std::string png;             // last frame rendered on the CPU, none when empty
+        std::string trace;           // Chrome trace of the profiler zones, none when empty
+        std::string record;          // input log of the session, none when empty
+        std::string replay;          // input log played instead of the script
+        int rasterThreads = 0;
+        int history = 0;             // rows added to the session history before the first frame
+        std::string script;
+        std::string font = "imgui/DejaVuSans.ttf";
+    };
+
+    void usage() {
+        std::cout << "usage: headless [--frames N] [--warmup N] [--script file] [--font file] [--seed N] [--idle]\n"
+                     "                [--realtime] [--budget-ms X] [--max-allocs N] [--per-frame] [--png file] [--raster-threads N]\n"
+                     "                [--trace file] [--record file] [--replay file] [--history N]\n";
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--per-frame") options.perFrame = true;
+            else if (arg == "--idle") options.idle = true;
+            else if (arg == "--realtime") options.realtime = true;
+            else if (arg == "--frames" && hasValue) options.frames = std::atoi(argv[++i]);
+            else if (arg == "--warmup" && hasValue) options.warmup = std::atoi(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+            else if (arg == "--budget-ms" && hasValue) options.budgetMs = std::atof(argv[++i]);
+            else if (arg == "--max-allocs" && hasValue) options.maxAllocations = std::atoll(argv[++i]);
+            else if (arg == "--script" && hasValue) options.script = argv[++i];
+            else if (arg == "--font" && hasValue) options.font = argv[++i];
+            else if (arg == "--png" && hasValue) options.png = argv[++i];
+            else if (arg == "--trace" && hasValue) options.trace = argv[++i];
+            else if (arg == "--record" && hasValue) options.record = argv[++i];
+            else if (arg == "--replay" && hasValue) options.replay = argv[++i];
+            else if (arg == "--raster-threads" && hasValue) options.rasterThreads = std::atoi(argv[++i]);
+            else if (arg == "--history" && hasValue) options.history = std::atoi(argv[++i]);
+            else return false;
+        }
+        return options.frames > 0 && options.warmup >= 0;
+    }
+
+    double percentile(std::vector<double> values, double p) {
+        if (values.empty()) return 0.0;
+        size_t k = std::min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5));
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    std::string text = InputScript::defaultScript();
+    if (!options.script.empty()) {
+        std::ifstream file(options.script);
+        if (!file) {
+            std::cout << "Couldn't open " << options.script << "\n";
+            return 2;
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        text = buffer.str();
+    }
+    std::vector<InputAction> actions;
+    std::string error;
+    if (!InputScript::parse(text, actions, &error)) {
+        std::cout << error << "\n";
+        return 2;
+    }
+
+    InputPlayer player;
+    ImVec2 displaySize(800.0f, 600.0f);
+    if (!options.replay.empty()) {
+        if (!player.load(options.replay, &error)) {
+            std::cout << error << "\n";
+            return 2;
+        }
+        // the log decides everything the script and the options would
+        options.seed = player.seed();
+        options.frames = player.frameCount();
+        options.idle = false;
+        displaySize = player.displaySize();
+    }
+    InputRecorder recorder(options.seed);
+
+    std::srand(options.seed);
+    Random::seed(options.seed);
+    HeadlessHost host(displaySize.x, displaySize.y, options.font.c_str());
+    AllocationTracker::install();
+    App::FillHistory(options.history);
+    // a click shows its equation on the same frame in every run, however far ahead the thread is
+    App::WaitForEquations(true);
+    std::vector<FrameStats> frames;
+    std::vector<long long> newCalls;
+    std::vector<int> frameNumbers;
+    // per scope after the warmup, summed and largest
+    std::vector<AllocationTracker::Counts> scopeSum(AllocationTracker::MaxScopes), scopeMax(AllocationTracker::MaxScopes);
+    frames.reserve(options.frames);
+    newCalls.reserve(options.frames);
+    frameNumbers.reserve(options.frames);
+    FrameScheduler scheduler;
+    // frame by frame instead of run(), so operator new can be counted around each one
+    if (!options.replay.empty()) host.replay(&player);
+    else host.play(actions);
+    if (!options.record.empty()) host.record(&recorder);
+    auto firstFrame = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.frames; i++) {
+        // simulated clock at one display refresh per iteration
+        double now = i / 60.0;
+        if (options.realtime) std::this_thread::sleep_until(firstFrame + std::chrono::microseconds((long long)(now * 1e6)));
+        if (options.idle) {
+            if (host.poll() || host.labelsNeeded()) scheduler.wake();
+            if (!scheduler.shouldRender(now)) {
+                host.skip();
+                continue;
+            }
+        }
+        long long before = AllocationTracker::threadAllocations();
+        frames.push_back(host.frame(App::RenderUI));
+        // the tracker sees ImGui's allocator too, which FrameStats already counts; the
+        // prefetch thread's allocations aren't this frame's
+        newCalls.push_back(AllocationTracker::threadAllocations() - before - frames.back().allocations);
+        frameNumbers.push_back(i);
+        AllocationTracker::frame();
+        Profiler::frame();
+        if ((int)frames.size() > options.warmup) {
+            for (int s = 0; s < AllocationTracker::scopeCount(); s++) {
+                AllocationTracker::Counts last = AllocationTracker::lastFrame(s);
+                scopeSum[s].allocations += last.allocations;
+                scopeSum[s].bytes += last.bytes;
+                if (last.allocations > scopeMax[s].allocations) scopeMax[s] = last;
+            }
+        }
+        if (options.idle) scheduler.frameRendered(now);
+    }
+    App::Shutdown();
+
+    if (options.perFrame) {
+        std::cout << "frame,cpu_ms,vertices,indices,draw_lists,imgui_allocs,imgui_bytes,new_calls\n";
+        for (size_t i = 0; i < frames.size(); i++) {
+            const FrameStats& f = frames[i];
+            std::cout << frameNumbers[i] << "," << f.cpuMs << "," << f.vertices << "," << f.indices << "," << f.drawLists << ","
+                      << f.allocations << "," << f.bytes << "," << newCalls[i] << "\n";
+        }
+    }
+
+    // budgets apply to frames after the warmup
+    std::vector<double> times;
+    long long vertexMax = 0, indexMax = 0, allocationsMax = 0, newMax = 0;
+    double vertexSum = 0.0, allocationSum = 0.0, newSum = 0.0;
+    for (size_t i = std::min((size_t)options.warmup, frames.size()); i < frames.size(); i++) {
+        times.push_back(frames[i].cpuMs);
+        vertexSum += frames[i].vertices;
+        vertexMax = std::max(vertexMax, (long long)frames[i].vertices);
+        indexMax = std::max(indexMax, (long long)frames[i].indices);
+        allocationSum += frames[i].allocations;
+        allocationsMax = std::max(allocationsMax, frames[i].allocations);
+        newSum += newCalls[i];
+        newMax = std::max(newMax, newCalls[i]);
+    }
+    size_t n = std::max<size_t>(times.size(), 1);
+    double p95 = percentile(times, 0.95);
+    char line[256];
+    std::cout << "frames " << frames.size() << " (" << times.size() << " after warmup)\n";
+    if (options.idle) {
+        double total = 0.0;
+        for (const FrameStats& f : frames) total += f.cpuMs;
+        std::snprintf(line, sizeof(line), "idle        %lld of %d skipped, %.2f ms cpu in total\n", scheduler.skippedFrames(), options.frames, total);
+        std::cout << line;
+    }
+    std::snprintf(line, sizeof(line), "cpu ms      median %.4f  p95 %.4f  max %.4f\n", percentile(times, 0.5), p95, percentile(times, 1.0));
+    std::cout << line;
+    std::snprintf(line, sizeof(line), "vertices    mean %.0f  max %lld   indices max %lld\n", vertexSum / n, vertexMax, indexMax);
+    std::cout << line;
+    std::snprintf(line, sizeof(line), "imgui alloc mean %.2f  max %lld per frame\n", allocationSum / n, allocationsMax);
+    std::cout << line;
+    std::snprintf(line, sizeof(line), "new calls   mean %.2f  max %lld per frame\n", newSum / n, newMax);
+    std::cout << line;
+    for (int s = 0; s < AllocationTracker::scopeCount(); s++) {
+        if (scopeSum[s].allocations == 0) continue;
+        std::snprintf(line, sizeof(line), "  %-34s mean %.2f  max %lld per frame, %.0f bytes mean\n", AllocationTracker::scopeName(s),
+                      (double)scopeSum[s].allocations / n, scopeMax[s].allocations, (double)scopeSum[s].bytes / n);
+        std::cout << line;
+    }
+    std::snprintf(line, sizeof(line), "checksum    %016llx last frame\n", (unsigned long long)FrameScheduler::checksum(ImGui::GetDrawData()));
+    std::cout << line;
+    for (const std::string& label : host.missedLabels()) {
+        std::cout << "script: no item labeled \"" << label << "\"\n";
+    }
+
+    int status = host.missedLabels().empty() ? 0 : 1;
+    if (!options.png.empty()) {
+        // the draw data of the last frame stays valid until the next NewFrame
+        SoftwareRenderer renderer(options.rasterThreads);
+        renderer.setFontAtlas();
+        Image image;
+        std::vector<double> rasterMs;
+        for (int i = 0; i < 20; i++) {
+            auto start = std::chrono::steady_clock::now();
+            renderer.render(ImGui::GetDrawData(), image);
+            rasterMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::snprintf(line, sizeof(line), "raster ms   median %.4f  min %.4f on %d threads\n", percentile(rasterMs, 0.5), percentile(rasterMs, 0.0), renderer.threadCount());
+        std::cout << line;
+        if (!PngWriter::write(options.png, image)) {
+            std::cout << "Couldn't write " << options.png << "\n";
+            status = 1;
+        }
+    }
+    if (!options.record.empty()) {
+        if (recorder.save(options.record)) {
+            std::cout << "recorded    " << recorder.frames() << " frames, " << recorder.bytes() << " bytes to " << options.record << "\n";
+        }
+        else {
+            std::cout << "Couldn't write " << options.record << "\n";
+            status = 1;
+        }
+    }
+    if (!options.replay.empty()) {
+        std::vector<double> recorded;
+        for (int i = std::min(options.warmup, player.frameCount()); i < player.frameCount(); i++) recorded.push_back(player.frame(i).cpuMs);
+        std::snprintf(line, sizeof(line), "replayed    %d frames, recorded cpu ms median %.4f  p95 %.4f\n", player.frameCount(),
+                      percentile(recorded, 0.5), percentile(recorded, 0.95));
+        std::cout << line;
+        if (!player.comparesChecksums()) {
+            std::cout << "replay: recorded with the " << player.renderer() << " renderer, checksums not compared\n";
+        }
+        else if (player.mismatches() > 0) {
+            std::cout << "FAIL: " << player.mismatches() << " frames draw differently than recorded, the first is frame " << player.firstMismatch() << "\n";
+            status = 1;
+        }
+    }
+    if (!options.trace.empty()) {
+#ifndef PROFILING
+        std::cout << "trace: no zones are recorded without -DPROFILING\n";
+#endif
+        if (!Profiler::exportTrace(options.trace)) {
+            std::cout << "Couldn't write " << options.trace << "\n";
+            status = 1;
+        }
+    }
+    if (options.budgetMs > 0.0 && p95 > options.budgetMs) {
+        std::cout << "FAIL: p95 frame time over the " << options.budgetMs << " ms budget\n";
+        status = 1;
+    }
+    if (options.maxAllocations >= 0 && allocationsMax + newMax > options.maxAllocations) {
+        std::cout << "FAIL: more than " << options.maxAllocations << " allocations in a frame\n";
+        status = 1;
+    }
+    return status;
+}
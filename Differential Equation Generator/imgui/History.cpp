@@ -0,0 +1,112 @@
+#include "History.h"
+
+#include <algorithm>
+#include <iterator>
+
+static_assert(sizeof(EquationHistory::Row) == 24, "history rows should stay compact");
+
+void EquationHistory::add(const Row& row) {
+    uint32_t index = (uint32_t)rows.size();
+    rows.push_back(row);
+    if (key == ByTime) {
+        if (descending) order.insert(order.begin(), index);
+        else order.push_back(index);
+        return;
+    }
+    // after the rows with an equal key, where the stable sort would have put it
+    uint64_t value = sortValue(row);
+    auto at = std::upper_bound(order.begin(), order.end(), value,
+        [this](uint64_t v, uint32_t i) { return v < sortValue(rows[i]); });
+    order.insert(at, index);
+}
+
+void EquationHistory::clear() {
+    rows.clear();
+    order.clear();
+    texts.clear();
+    textIndex.clear();
+}
+
+void EquationHistory::sort(SortKey sortKey, bool sortDescending) {
+    // add() keeps the order, so only a different key needs a pass over the rows
+    if (sortKey == key && sortDescending == descending) return;
+    key = sortKey;
+    descending = sortDescending;
+    size_t n = rows.size();
+    order.resize(n);
+    if (key == ByTime) {
+        for (size_t i = 0; i < n; i++) order[i] = (uint32_t)(descending ? n - 1 - i : i);
+        return;
+    }
+    items.resize(n);
+    for (size_t i = 0; i < n; i++) items[i] = { sortValue(rows[i]), (uint32_t)i };
+    radixSort(items, scratch, counts);
+    for (size_t i = 0; i < n; i++) order[i] = items[i].index;
+}
+
+uint64_t EquationHistory::sortValue(const Row& row) const {
+    uint64_t value = key == ByType ? row.type : row.coefficients;
+    // inverted instead of sorted backwards, so equal keys stay oldest first
+    return descending ? ~value : value;
+}
+
+void EquationHistory::radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch, std::vector<uint32_t>& count) {
+    size_t n = items.size();
+    if (n < 2) return;
+    scratch.resize(n);
+    count.resize(1 << 16);
+    // digits where some key differs from the first; a pass over any other would move nothing
+    uint64_t varying = 0;
+    for (const SortItem& item : items) varying |= item.key ^ items[0].key;
+    // 16-bit digits, least significant first, each pass stable. A type sort is one pass,
+    // a coefficient sort one per coefficient that differs
+    for (int shift = 0; shift < 64; shift += 16) {
+        if (!(varying >> shift & 0xffff)) continue;
+        std::fill(count.begin(), count.end(), 0);
+        for (const SortItem& item : items) count[item.key >> shift & 0xffff]++;
+        uint32_t offset = 0;
+        for (uint32_t& c : count) {
+            uint32_t next = offset + c;
+            c = offset;
+            offset = next;
+        }
+        for (const SortItem& item : items) scratch[count[item.key >> shift & 0xffff]++] = item;
+        items.swap(scratch);
+    }
+}
+
+const std::string& EquationHistory::text(uint32_t index, Describe describe) {
+    auto found = textIndex.find(index);
+    if (found != textIndex.end()) {
+        texts.splice(texts.begin(), texts, found->second);
+        return found->second->text;
+    }
+    if (texts.size() == TextCapacity) {
+        // the least recently used entry takes the new row, keeping its string's buffer
+        textIndex.erase(texts.back().index);
+        texts.splice(texts.begin(), texts, std::prev(texts.end()));
+    }
+    else {
+        texts.push_front(CachedText());
+    }
+    CachedText& entry = texts.front();
+    entry.index = index;
+    entry.text = describe(rows[index]);
+    textIndex[index] = texts.begin();
+    return entry.text;
+}
+
+uint64_t EquationHistory::packCoefficients(const std::vector<long long>& coeffs) {
+    // biased so a missing coefficient is 0 and sorts first, like the end of a shorter vector
+    uint64_t packed = 0;
+    for (int i = 0; i < PackedCoefficients; i++) {
+        uint64_t field = 0;
+        if (i < (int)coeffs.size()) field = (uint64_t)(std::max(-32767LL, std::min(32767LL, coeffs[i])) + 32768);
+        packed = packed << 16 | field;
+    }
+    return packed;
+}
+
+long long EquationHistory::coefficient(const Row& row, int i) {
+    return (long long)(row.coefficients >> (16 * (PackedCoefficients - 1 - i)) & 0xffff) - 32768;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Session history of generated equations, sized for millions of rows. A row holds what
+// makes its equation again (the type, the generator settings and the seed) and its sort
+// keys, 24 bytes in all; the text of a row is only made while the row is on screen and
+// kept in a small least recently used cache. Sorting is a stable radix sort of the
+// precomputed keys
+class EquationHistory {
+public:
+    static const int PackedCoefficients = 4;
+    static const size_t TextCapacity = 512;     // rows whose text is kept, well over a screenful
+
+    enum Flags : uint8_t { Homogeneous = 1, VariableCoefficient = 2, Inverse = 4 };
+    enum SortKey { ByTime, ByType, ByCoefficients };
+
+    struct Row {
+        // the first key coefficients, 16 bits each and the first one highest, so the
+        // number orders rows like their coefficient vectors
+        uint64_t coefficients;
+        uint32_t seed;
+        uint16_t terms;
+        uint8_t type, flags, order, dimension;
+        uint8_t coefficientCount;   // of the whole key, can be more than PackedCoefficients
+    };
+
+    // text of a row, made from scratch
+    typedef std::string (*Describe)(const Row& row);
+
+    // rows keep their place in the current sort order as they are added
+    void add(const Row& row);
+    size_t size() const { return rows.size(); }
+    void clear();
+
+    // i-th row in the current order
+    const Row& row(size_t i) const { return rows[order[i]]; }
+    // position of the i-th row in the order rows were added
+    uint32_t index(size_t i) const { return order[i]; }
+
+    void sort(SortKey key, bool descending);
+    SortKey sortKey() const { return key; }
+
+    // text of the row added index-th, from the cache or from describe
+    const std::string& text(uint32_t index, Describe describe);
+
+    static uint64_t packCoefficients(const std::vector<long long>& coeffs);
+    // i-th packed coefficient of row, i < min(coefficientCount, PackedCoefficients)
+    static long long coefficient(const Row& row, int i);
+
+private:
+    struct SortItem {
+        uint64_t key;
+        uint32_t index;
+    };
+    struct CachedText {
+        uint32_t index;
+        std::string text;
+    };
+
+    std::vector<Row> rows;
+    std::vector<uint32_t> order;
+    std::vector<SortItem> items, scratch;   // kept between sorts, like counts
+    std::vector<uint32_t> counts;
+    std::list<CachedText> texts;            // most recently used first
+    std::unordered_map<uint32_t, std::list<CachedText>::iterator> textIndex;
+    SortKey key = ByTime;
+    bool descending = false;
+
+    uint64_t sortValue(const Row& row) const;
+    static void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch, std::vector<uint32_t>& count);
+};
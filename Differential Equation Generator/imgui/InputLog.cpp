@@ -0,0 +1,278 @@
+#include "InputLog.h"
+#include "FrameScheduler.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    const char Magic[4] = { 'D', 'E', 'Q', 'L' };
+
+    template <typename T>
+    void put(std::vector<uint8_t>& out, T value) {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    // bounds-checked reads, ok turns false on the first one past the end
+    struct Reader {
+        const uint8_t* p;
+        const uint8_t* end;
+        bool ok = true;
+
+        template <typename T>
+        T get() {
+            T value = T();
+            if (end - p < (ptrdiff_t)sizeof(T)) {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, p, sizeof(T));
+            p += sizeof(T);
+            return value;
+        }
+
+        uint32_t varint() {
+            uint32_t value = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                uint8_t byte = get<uint8_t>();
+                value |= (uint32_t)(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) return value;
+            }
+            ok = false;
+            return value;
+        }
+    };
+}
+
+InputRecorder::InputRecorder(unsigned seed) : seed(seed) {
+}
+
+void InputRecorder::beginFrame() {
+    ImGuiContext& g = *GImGui;
+    ImGuiIO& io = g.IO;
+    // the header waits for the first frame, the backends have named themselves by then
+    if (data.empty()) {
+        for (char c : Magic) put<char>(data, c);
+        put<uint8_t>(data, InputLog::Version);
+        put<uint32_t>(data, seed);
+        put<float>(data, io.DisplaySize.x);
+        put<float>(data, io.DisplaySize.y);
+        std::string renderer = io.BackendRendererName ? io.BackendRendererName : "";
+        if (renderer.size() > 255) renderer.resize(255);
+        put<uint8_t>(data, (uint8_t)renderer.size());
+        data.insert(data.end(), renderer.begin(), renderer.end());
+        displaySize = io.DisplaySize;
+    }
+
+    bool resized = io.DisplaySize.x != displaySize.x || io.DisplaySize.y != displaySize.y;
+    put<uint8_t>(data, resized ? 1 : 0);
+    if (resized) {
+        put<float>(data, io.DisplaySize.x);
+        put<float>(data, io.DisplaySize.y);
+        displaySize = io.DisplaySize;
+    }
+    put<float>(data, io.DeltaTime);
+
+    uint32_t count = 0;
+    for (const ImGuiInputEvent& e : g.InputEventsQueue) {
+        if (e.EventId >= nextEventId) count++;
+    }
+    putVarint(data, count);
+    for (const ImGuiInputEvent& e : g.InputEventsQueue) {
+        if (e.EventId >= nextEventId) writeEvent(e);
+    }
+    nextEventId = g.InputEventsNextEventId;
+}
+
+void InputRecorder::writeEvent(const ImGuiInputEvent& e) {
+    put<uint8_t>(data, (uint8_t)(e.Type | e.Source << 4));
+    switch (e.Type) {
+    case ImGuiInputEventType_MousePos:
+        put<float>(data, e.MousePos.PosX);
+        put<float>(data, e.MousePos.PosY);
+        put<uint8_t>(data, (uint8_t)e.MousePos.MouseSource);
+        break;
+    case ImGuiInputEventType_MouseWheel:
+        put<float>(data, e.MouseWheel.WheelX);
+        put<float>(data, e.MouseWheel.WheelY);
+        put<uint8_t>(data, (uint8_t)e.MouseWheel.MouseSource);
+        break;
+    case ImGuiInputEventType_MouseButton:
+        put<uint8_t>(data, (uint8_t)(e.MouseButton.Button | (e.MouseButton.Down ? 0x80 : 0)));
+        put<uint8_t>(data, (uint8_t)e.MouseButton.MouseSource);
+        break;
+    case ImGuiInputEventType_Key: {
+        // digital keys carry 0 or 1, only gamepad sticks and triggers need the value
+        bool analog = e.Key.AnalogValue != (e.Key.Down ? 1.0f : 0.0f);
+        putVarint(data, (uint32_t)e.Key.Key);
+        put<uint8_t>(data, (uint8_t)((e.Key.Down ? 1 : 0) | (analog ? 2 : 0)));
+        if (analog) put<float>(data, e.Key.AnalogValue);
+        break;
+    }
+    case ImGuiInputEventType_Text:
+        putVarint(data, e.Text.Char);
+        break;
+    case ImGuiInputEventType_Focus:
+        put<uint8_t>(data, e.AppFocused.Focused ? 1 : 0);
+        break;
+    default:
+        break;
+    }
+}
+
+void InputRecorder::endFrame(double cpuMs) {
+    put<float>(data, (float)cpuMs);
+    put<uint64_t>(data, FrameScheduler::checksum(ImGui::GetDrawData()));
+    frameCount++;
+}
+
+bool InputRecorder::save(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+bool InputPlayer::load(const std::string& path, std::string* error) {
+    frames.clear();
+    events.clear();
+    next = 0;
+    mismatchCount = 0;
+    firstMismatchFrame = -1;
+
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        if (error) *error = "can't open " + path;
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + n);
+    std::fclose(file);
+
+    Reader in = { data.data(), data.data() + data.size() };
+    if (data.size() < sizeof(Magic) + 1 || std::memcmp(data.data(), Magic, sizeof(Magic)) != 0) {
+        if (error) *error = path + " isn't an input log";
+        return false;
+    }
+    in.p += sizeof(Magic);
+    if (in.get<uint8_t>() != InputLog::Version) {
+        if (error) *error = path + " was written by another version";
+        return false;
+    }
+    logSeed = in.get<uint32_t>();
+    ImVec2 displaySize;
+    displaySize.x = in.get<float>();
+    displaySize.y = in.get<float>();
+    uint8_t length = in.get<uint8_t>();
+    if (in.ok && in.end - in.p >= length) {
+        logRenderer.assign((const char*)in.p, length);
+        in.p += length;
+    }
+    else {
+        in.ok = false;
+    }
+
+    while (in.ok && in.p < in.end) {
+        InputLog::Frame frame;
+        if (in.get<uint8_t>() & 1) {
+            displaySize.x = in.get<float>();
+            displaySize.y = in.get<float>();
+        }
+        frame.displaySize = displaySize;
+        frame.deltaTime = in.get<float>();
+        frame.firstEvent = (int)events.size();
+        frame.eventCount = (int)in.varint();
+        for (int i = 0; i < frame.eventCount && in.ok; i++) {
+            ImGuiInputEvent e;
+            uint8_t kind = in.get<uint8_t>();
+            e.Type = (ImGuiInputEventType)(kind & 0x0f);
+            e.Source = (ImGuiInputSource)(kind >> 4);
+            switch (e.Type) {
+            case ImGuiInputEventType_MousePos:
+                e.MousePos.PosX = in.get<float>();
+                e.MousePos.PosY = in.get<float>();
+                e.MousePos.MouseSource = (ImGuiMouseSource)in.get<uint8_t>();
+                break;
+            case ImGuiInputEventType_MouseWheel:
+                e.MouseWheel.WheelX = in.get<float>();
+                e.MouseWheel.WheelY = in.get<float>();
+                e.MouseWheel.MouseSource = (ImGuiMouseSource)in.get<uint8_t>();
+                break;
+            case ImGuiInputEventType_MouseButton: {
+                uint8_t button = in.get<uint8_t>();
+                e.MouseButton.Button = button & 0x7f;
+                e.MouseButton.Down = (button & 0x80) != 0;
+                e.MouseButton.MouseSource = (ImGuiMouseSource)in.get<uint8_t>();
+                in.ok = in.ok && e.MouseButton.Button < ImGuiMouseButton_COUNT;
+                break;
+            }
+            case ImGuiInputEventType_Key: {
+                e.Key.Key = (ImGuiKey)in.varint();
+                uint8_t flags = in.get<uint8_t>();
+                e.Key.Down = (flags & 1) != 0;
+                e.Key.AnalogValue = (flags & 2) ? in.get<float>() : (e.Key.Down ? 1.0f : 0.0f);
+                in.ok = in.ok && ImGui::IsNamedKeyOrMod(e.Key.Key);
+                break;
+            }
+            case ImGuiInputEventType_Text:
+                e.Text.Char = in.varint();
+                break;
+            case ImGuiInputEventType_Focus:
+                e.AppFocused.Focused = in.get<uint8_t>() != 0;
+                break;
+            default:
+                in.ok = false;
+                break;
+            }
+            events.push_back(e);
+        }
+        frame.cpuMs = in.get<float>();
+        frame.checksum = in.get<uint64_t>();
+        if (in.ok) frames.push_back(frame);
+    }
+    if (!in.ok) {
+        if (error) *error = path + " is cut short or corrupt after frame " + std::to_string(frames.size());
+        frames.clear();
+        events.clear();
+        return false;
+    }
+    return true;
+}
+
+bool InputPlayer::comparesChecksums() const {
+    const char* renderer = ImGui::GetIO().BackendRendererName;
+    return logRenderer == (renderer ? renderer : "");
+}
+
+void InputPlayer::beginFrame() {
+    if (done()) return;
+    ImGuiContext& g = *GImGui;
+    const InputLog::Frame& frame = frames[next];
+    g.IO.DeltaTime = frame.deltaTime;
+    g.IO.DisplaySize = frame.displaySize;
+    // straight into the queue: the events were filtered and remapped when they were recorded
+    for (int i = 0; i < frame.eventCount; i++) {
+        ImGuiInputEvent e = events[frame.firstEvent + i];
+        e.EventId = g.InputEventsNextEventId++;
+        g.InputEventsQueue.push_back(e);
+    }
+}
+
+void InputPlayer::endFrame() {
+    if (done()) return;
+    if (comparesChecksums() && FrameScheduler::checksum(ImGui::GetDrawData()) != frames[next].checksum) {
+        if (mismatchCount++ == 0) firstMismatchFrame = next;
+    }
+    next++;
+}
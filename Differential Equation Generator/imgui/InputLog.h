@@ -0,0 +1,94 @@
+#pragma once
+
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary log of a session's input: every event ImGui was given, each frame's DeltaTime and
+// display size, and what the frame cost and drew. Replaying it feeds ImGui the same events
+// on the same frames, so the UI runs the same way again and the draw checksums must match.
+//
+// Little-endian, after an 'DEQL' magic and a version byte:
+//   header  u32 rand() seed, f32 display width and height, u8 length + renderer name
+//   frame   u8 flags (1: display size follows as 2 x f32), f32 DeltaTime,
+//           varint event count, events, f32 CPU ms, u64 FrameScheduler::checksum
+//   event   u8 type | source << 4, then by type
+//           mouse pos/wheel: f32 x, f32 y, u8 mouse source
+//           mouse button:    u8 button | down << 7, u8 mouse source
+//           key:             varint ImGuiKey, u8 down | 2 when an f32 analog value follows
+//           text:            varint codepoint
+//           focus:           u8 focused
+namespace InputLog {
+    const uint8_t Version = 1;
+
+    struct Frame {
+        float deltaTime = 0.0f;
+        ImVec2 displaySize;
+        int firstEvent = 0, eventCount = 0;
+        float cpuMs = 0.0f;
+        uint64_t checksum = 0;
+    };
+}
+
+// Appends to a log frame by frame. Events are picked out of ImGui's queue by id, so ones
+// still waiting there from an earlier frame aren't written twice
+class InputRecorder {
+public:
+    explicit InputRecorder(unsigned seed);
+
+    // after the platform backend's NewFrame, before ImGui::NewFrame
+    void beginFrame();
+    // after ImGui::Render()
+    void endFrame(double cpuMs);
+
+    int frames() const { return frameCount; }
+    size_t bytes() const { return data.size(); }
+    // false when the file can't be written
+    bool save(const std::string& path) const;
+
+private:
+    unsigned seed;
+    std::vector<uint8_t> data;
+    int frameCount = 0;
+    ImU32 nextEventId = 0;
+    ImVec2 displaySize;
+
+    void writeEvent(const ImGuiInputEvent& e);
+};
+
+// Feeds a recorded log back to ImGui and compares each frame's draw data with the recording
+class InputPlayer {
+public:
+    // false with a reason in error when the file is missing or malformed
+    bool load(const std::string& path, std::string* error = nullptr);
+
+    unsigned seed() const { return logSeed; }
+    ImVec2 displaySize() const { return frames.empty() ? ImVec2(0.0f, 0.0f) : frames[0].displaySize; }
+    const std::string& renderer() const { return logRenderer; }
+    // checksums only match when the log was drawn by the same kind of renderer
+    bool comparesChecksums() const;
+
+    int frameCount() const { return (int)frames.size(); }
+    const InputLog::Frame& frame(int i) const { return frames[i]; }
+    bool done() const { return next >= (int)frames.size(); }
+
+    // before ImGui::NewFrame: queues the next frame's events, sets its DeltaTime and display size
+    void beginFrame();
+    // after ImGui::Render()
+    void endFrame();
+
+    int mismatches() const { return mismatchCount; }
+    // first frame whose draw data differed from the recording, -1 for none
+    int firstMismatch() const { return firstMismatchFrame; }
+
+private:
+    unsigned logSeed = 0;
+    std::string logRenderer;
+    std::vector<InputLog::Frame> frames;
+    std::vector<ImGuiInputEvent> events;
+    int next = 0;
+    int mismatchCount = 0, firstMismatchFrame = -1;
+};
@@ -0,0 +1,232 @@
+#include "Integrator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    const double StiffThreshold = 3.25; // h * |lambda| beyond the DOPRI5 stability boundary
+    const int StiffCount = 15;          // consecutive stiff-looking steps before switching
+
+    // Dormand-Prince 5(4) tableau
+    const double c2 = 1.0 / 5, c3 = 3.0 / 10, c4 = 4.0 / 5, c5 = 8.0 / 9;
+    const double a21 = 1.0 / 5;
+    const double a31 = 3.0 / 40, a32 = 9.0 / 40;
+    const double a41 = 44.0 / 45, a42 = -56.0 / 15, a43 = 32.0 / 9;
+    const double a51 = 19372.0 / 6561, a52 = -25360.0 / 2187, a53 = 64448.0 / 6561, a54 = -212.0 / 729;
+    const double a61 = 9017.0 / 3168, a62 = -355.0 / 33, a63 = 46732.0 / 5247, a64 = 49.0 / 176, a65 = -5103.0 / 18656;
+    const double a71 = 35.0 / 384, a73 = 500.0 / 1113, a74 = 125.0 / 192, a75 = -2187.0 / 6784, a76 = 11.0 / 84;
+    const double e1 = 71.0 / 57600, e3 = -71.0 / 16695, e4 = 71.0 / 1920, e5 = -17253.0 / 339200, e6 = 22.0 / 525, e7 = -1.0 / 40;
+
+    // LU factorization with partial pivoting, reused across steps while h and J don't change
+    struct LU {
+        int n = 0;
+        std::vector<double> m;
+        std::vector<int> perm;
+
+        void factor(const std::vector<double>& W, int size) {
+            n = size;
+            m = W;
+            perm.resize(n);
+            for (int i = 0; i < n; i++) perm[i] = i;
+            for (int c = 0; c < n; c++) {
+                int p = c;
+                for (int r = c + 1; r < n; r++) {
+                    if (std::fabs(m[r * n + c]) > std::fabs(m[p * n + c])) p = r;
+                }
+                if (p != c) {
+                    for (int j = 0; j < n; j++) std::swap(m[c * n + j], m[p * n + j]);
+                    std::swap(perm[c], perm[p]);
+                }
+                for (int r = c + 1; r < n; r++) {
+                    double f = m[r * n + c] /= m[c * n + c];
+                    for (int j = c + 1; j < n; j++) m[r * n + j] -= f * m[c * n + j];
+                }
+            }
+        }
+        void solve(const double* b, double* x) const {
+            for (int i = 0; i < n; i++) {
+                double s = b[perm[i]];
+                for (int j = 0; j < i; j++) s -= m[i * n + j] * x[j];
+                x[i] = s;
+            }
+            for (int i = n - 1; i >= 0; i--) {
+                double s = x[i];
+                for (int j = i + 1; j < n; j++) s -= m[i * n + j] * x[j];
+                x[i] = s / m[i * n + i];
+            }
+        }
+    };
+
+    // weighted RMS norm used for error control; local scales the tolerance per component
+    double errorNorm(const std::vector<double>& e, const std::vector<double>& y, const std::vector<double>& ynew, double tol,
+                     const double* local = nullptr) {
+        double sum = 0.0;
+        for (size_t i = 0; i < e.size(); i++) {
+            double scale = (tol + tol * std::max(std::fabs(y[i]), std::fabs(ynew[i]))) * (local ? local[i] : 1.0);
+            sum += (e[i] / scale) * (e[i] / scale);
+        }
+        return std::sqrt(sum / e.size());
+    }
+}
+
+OdeProblem OdeProblem::linear(const std::vector<double>& A, int n, std::function<double(double t, int row)> g) {
+    OdeProblem p;
+    p.n = n;
+    p.f = [A, n, g](double t, const double* y, double* dy) {
+        for (int i = 0; i < n; i++) {
+            double s = g ? g(t, i) : 0.0;
+            for (int j = 0; j < n; j++) s += A[i * n + j] * y[j];
+            dy[i] = s;
+        }
+    };
+    p.jacobian = [A](double, const double*, double* J) {
+        std::copy(A.begin(), A.end(), J);
+    };
+    p.constantJacobian = true;
+    if (!g) {
+        p.timeDerivative = [n](double, const double*, double* dt) { std::fill(dt, dt + n, 0.0); };
+    }
+    return p;
+}
+
+Integrator::Result Integrator::integrate(const OdeProblem& problem, std::vector<double> y, double t0, double t1, double tol) {
+    Result result;
+    const int n = problem.n;
+    double t = t0;
+    double span = t1 - t0;
+
+    std::vector<double> k1(n), k2(n), k3(n), k4(n), k5(n), k6(n), k7(n);
+    std::vector<double> tmp(n), ynew(n), err(n), dfdt(n), local(n);
+
+    // initial step from the size of y'
+    problem.f(t, y.data(), k1.data());
+    double ynorm = 0.0, dnorm = 0.0;
+    for (int i = 0; i < n; i++) {
+        ynorm = std::max(ynorm, std::fabs(y[i]));
+        dnorm = std::max(dnorm, std::fabs(k1[i]));
+    }
+    double h = std::min(0.1 * span, dnorm > 0.0 ? 0.01 * std::max(ynorm, 1e-3) / dnorm : 0.1 * span);
+
+    bool stiff = false;
+    int stiffSteps = 0, nonStiffSteps = 0;
+
+    // Rosenbrock state
+    const double d = 1.0 / (2.0 + std::sqrt(2.0));
+    const double e32 = 6.0 + std::sqrt(2.0);
+    std::vector<double> J(n * n), W(n * n);
+    LU lu;
+    double factoredH = -1.0;
+
+    while (t < t1 && result.steps + result.rejected < MaxSteps) {
+        if (t + h > t1) h = t1 - t;
+
+        if (!stiff) {
+            // explicit Dormand-Prince step, k1 holds f(t, y) (FSAL)
+            for (int i = 0; i < n; i++) tmp[i] = y[i] + h * a21 * k1[i];
+            problem.f(t + c2 * h, tmp.data(), k2.data());
+            for (int i = 0; i < n; i++) tmp[i] = y[i] + h * (a31 * k1[i] + a32 * k2[i]);
+            problem.f(t + c3 * h, tmp.data(), k3.data());
+            for (int i = 0; i < n; i++) tmp[i] = y[i] + h * (a41 * k1[i] + a42 * k2[i] + a43 * k3[i]);
+            problem.f(t + c4 * h, tmp.data(), k4.data());
+            for (int i = 0; i < n; i++) tmp[i] = y[i] + h * (a51 * k1[i] + a52 * k2[i] + a53 * k3[i] + a54 * k4[i]);
+            problem.f(t + c5 * h, tmp.data(), k5.data());
+            for (int i = 0; i < n; i++) tmp[i] = y[i] + h * (a61 * k1[i] + a62 * k2[i] + a63 * k3[i] + a64 * k4[i] + a65 * k5[i]);
+            problem.f(t + h, tmp.data(), k6.data());
+            for (int i = 0; i < n; i++) ynew[i] = y[i] + h * (a71 * k1[i] + a73 * k3[i] + a74 * k4[i] + a75 * k5[i] + a76 * k6[i]);
+            problem.f(t + h, ynew.data(), k7.data());
+            for (int i = 0; i < n; i++) err[i] = h * (e1 * k1[i] + e3 * k3[i] + e4 * k4[i] + e5 * k5[i] + e6 * k6[i] + e7 * k7[i]);
+
+            double e = errorNorm(err, y, ynew, tol);
+            double fac = std::min(10.0, std::max(0.2, 0.9 * std::pow(std::max(e, 1e-10), -0.2)));
+            if (e > 1.0) {
+                result.rejected++;
+                h *= std::min(1.0, fac);
+                continue;
+            }
+
+            // Hairer's test: h * |lambda| estimated from stages 6 and 7 (both at t + h)
+            double num = 0.0, den = 0.0;
+            for (int i = 0; i < n; i++) {
+                num += (k7[i] - k6[i]) * (k7[i] - k6[i]);
+                den += (ynew[i] - tmp[i]) * (ynew[i] - tmp[i]);
+            }
+            if (den > 0.0 && h * std::sqrt(num / den) > StiffThreshold) {
+                nonStiffSteps = 0;
+                if (++stiffSteps >= StiffCount) stiff = true;
+            }
+            else if (++nonStiffSteps >= 6) {
+                stiffSteps = 0;
+            }
+
+            t += h;
+            y.swap(ynew);
+            k1.swap(k7);
+            result.steps++;
+            h *= fac;
+            continue;
+        }
+
+        // Rosenbrock 2(3) step (ode23s) with W = I - h d J
+        result.stiff = true;
+        if (factoredH != h || !problem.constantJacobian) {
+            problem.jacobian(t, y.data(), J.data());
+            for (int i = 0; i < n * n; i++) W[i] = -h * d * J[i];
+            for (int i = 0; i < n; i++) W[i * n + i] += 1.0;
+            lu.factor(W, n);
+            factoredH = h;
+            result.factorizations++;
+        }
+
+        // k1 = W^-1 (F0 + h d T) with T = df/dt
+        problem.f(t, y.data(), k1.data());
+        std::vector<double>& F0 = k4;
+        F0 = k1;
+        if (problem.timeDerivative) {
+            problem.timeDerivative(t, y.data(), dfdt.data());
+        }
+        else {
+            double dt = 1e-8 * std::max(1.0, std::fabs(t));
+            problem.f(t + dt, y.data(), dfdt.data());
+            for (int i = 0; i < n; i++) dfdt[i] = (dfdt[i] - F0[i]) / dt;
+        }
+        for (int i = 0; i < n; i++) tmp[i] = F0[i] + h * d * dfdt[i];
+        lu.solve(tmp.data(), k1.data());
+
+        // k2 = W^-1 (F1 - k1) + k1
+        std::vector<double>& F1 = k5;
+        for (int i = 0; i < n; i++) tmp[i] = y[i] + 0.5 * h * k1[i];
+        problem.f(t + 0.5 * h, tmp.data(), F1.data());
+        for (int i = 0; i < n; i++) tmp[i] = F1[i] - k1[i];
+        lu.solve(tmp.data(), k2.data());
+        for (int i = 0; i < n; i++) k2[i] += k1[i];
+
+        for (int i = 0; i < n; i++) ynew[i] = y[i] + h * k2[i];
+
+        // k3 = W^-1 (F2 - e32 (k2 - F1) - 2 (k1 - F0) + h d T)
+        problem.f(t + h, ynew.data(), k6.data());
+        for (int i = 0; i < n; i++) tmp[i] = k6[i] - e32 * (k2[i] - F1[i]) - 2.0 * (k1[i] - F0[i]) + h * d * dfdt[i];
+        lu.solve(tmp.data(), k3.data());
+        for (int i = 0; i < n; i++) err[i] = h / 6.0 * (k1[i] - 2.0 * k2[i] + k3[i]);
+
+        // a local error in component i fades like exp(J_ii h) per step, so only the parts that don't decay
+        // within a step add up over the span; those get tol per unit step rather than tol per step
+        for (int i = 0; i < n; i++) local[i] = std::min(1.0, h * std::max(1.0 / span, -J[i * n + i]));
+        double e = errorNorm(err, y, ynew, tol, local.data());
+        double fac = std::min(5.0, std::max(0.2, 0.9 * std::pow(std::max(e, 1e-10), -1.0 / 3.0)));
+        if (e > 1.0) {
+            result.rejected++;
+            h *= std::min(1.0, fac);
+            continue;
+        }
+        t += h;
+        y.swap(ynew);
+        result.steps++;
+        // hold h unless it can grow a lot, so the factorization keeps being reused
+        if (fac > 2.0 || fac < 1.0) h *= fac;
+    }
+
+    result.y = y;
+    result.completed = t >= t1;
+    return result;
+}
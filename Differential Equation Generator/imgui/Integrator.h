@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+// Initial value problem y' = f(t, y) for numeric answer keys
+struct OdeProblem {
+    int n = 0;
+    std::function<void(double t, const double* y, double* dy)> f;
+    // row-major n x n Jacobian df/dy
+    std::function<void(double t, const double* y, double* J)> jacobian;
+    // df/dt; when empty the implicit method takes a difference quotient of f in t
+    std::function<void(double t, const double* y, double* dt)> timeDerivative;
+    // true when df/dy doesn't change, so a factorization stays valid while h does
+    bool constantJacobian = false;
+
+    // y' = A y + g(t) with constant A, g may be empty
+    static OdeProblem linear(const std::vector<double>& A, int n, std::function<double(double t, int row)> g = nullptr);
+};
+
+// Dormand-Prince 5(4) with stiffness detection, switching to the
+// Rosenbrock 2(3) pair of ode23s once the problem looks stiff
+class Integrator {
+public:
+    static const int MaxSteps = 1000000; // accepted and rejected steps
+    struct Result {
+        std::vector<double> y; // y(t1), or y where it stopped when not completed
+        int steps = 0;
+        int rejected = 0;
+        int factorizations = 0; // LU factorizations of W = I - h d J
+        bool stiff = false;     // switched to the implicit method
+        bool completed = false; // reached t1; otherwise y is at an earlier t, where MaxSteps ran out
+    };
+
+    static Result integrate(const OdeProblem& problem, std::vector<double> y0, double t0, double t1, double tol = 1e-8);
+};
@@ -0,0 +1,123 @@
+#include "Inverse.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+thread_local bool InverseGenerator::enabled = false;  // default value
+
+namespace {
+
+    // sum and product of the two roots of a quadratic, exact for integer or conjugate roots
+    void sumProduct(const std::vector<PolyRoot>& roots, int& sum, int& product) {
+        std::vector<std::complex<double>> z;
+        for (const PolyRoot& r : roots) {
+            for (int k = 0; k < r.multiplicity; k++) z.push_back(r.value);
+        }
+        sum = (int)std::lround((z[0] + z[1]).real());
+        product = (int)std::lround((z[0] * z[1]).real());
+    }
+}
+
+std::vector<PolyRoot> InverseGenerator::sampleRoots(int degree, bool allowZero) {
+    std::vector<PolyRoot> roots;
+    int remaining = degree;
+
+    // pool of distinct integer roots
+    std::vector<int> pool;
+    for (int v = -5; v <= 5; v++) {
+        if (v != 0 || allowZero) pool.push_back(v);
+    }
+    for (int i = (int)pool.size() - 1; i > 0; i--) std::swap(pool[i], pool[Random::next() % (i + 1)]);
+
+    int structure = Random::next() % 3;
+    if (structure == 2 && remaining >= 2) {
+        // complex pair a ± bi
+        double a = Random::next() % 7 - 3;
+        double b = Random::next() % 3 + 1;
+        PolyRoot upper = { std::complex<double>(a, b), 1 };
+        PolyRoot lower = { std::complex<double>(a, -b), 1 };
+        roots.push_back(upper);
+        roots.push_back(lower);
+        remaining -= 2;
+    }
+    else if (structure == 1 && remaining >= 2) {
+        // repeated root, the resonance case
+        int m = std::min(remaining, Random::next() % 2 + 2);
+        PolyRoot repeated = { std::complex<double>(pool.back(), 0.0), m };
+        pool.pop_back();
+        roots.push_back(repeated);
+        remaining -= m;
+    }
+
+    while (remaining > 0) {
+        if (pool.empty()) {
+            // out of distinct values, raise the multiplicity of a real root
+            for (PolyRoot& r : roots) {
+                if (r.value.imag() == 0.0) { r.multiplicity++; break; }
+            }
+            remaining--;
+            continue;
+        }
+        PolyRoot root = { std::complex<double>(pool.back(), 0.0), 1 };
+        pool.pop_back();
+        roots.push_back(root);
+        remaining--;
+    }
+
+    // same order PolynomialRoots reports them in
+    std::sort(roots.begin(), roots.end(), [](const PolyRoot& a, const PolyRoot& b) {
+        if ((a.value.imag() == 0.0) != (b.value.imag() == 0.0)) return a.value.imag() == 0.0;
+        if (a.value.real() != b.value.real()) return a.value.real() < b.value.real();
+        return a.value.imag() > b.value.imag();
+    });
+    return roots;
+}
+
+std::vector<int> InverseGenerator::expand(const std::vector<PolyRoot>& roots) {
+    // poly[0] is the leading coefficient
+    std::vector<long long> poly(1, 1);
+    auto multiply = [&poly](const std::vector<long long>& factor) {
+        std::vector<long long> out(poly.size() + factor.size() - 1, 0);
+        for (size_t i = 0; i < poly.size(); i++) {
+            for (size_t j = 0; j < factor.size(); j++) out[i + j] += poly[i] * factor[j];
+        }
+        poly = out;
+    };
+
+    for (const PolyRoot& r : roots) {
+        long long a = std::llround(r.value.real());
+        long long b = std::llround(r.value.imag());
+        if (b < 0) continue; // handled together with its conjugate
+        for (int k = 0; k < r.multiplicity; k++) {
+            if (b == 0) multiply({ 1, -a });
+            else multiply({ 1, -2 * a, a * a + b * b });
+        }
+    }
+    return std::vector<int>(poly.begin() + 1, poly.end());
+}
+
+void InverseGenerator::cauchyEuler(const std::vector<PolyRoot>& roots, int& a, int& b) {
+    // r(r - 1) + a r + b = r^2 + (a - 1) r + b
+    int sum, product;
+    sumProduct(roots, sum, product);
+    a = 1 - sum;
+    b = product;
+}
+
+void InverseGenerator::system(const std::vector<PolyRoot>& roots, int& x_coeff, int& y_coeff, int& rhs) {
+    // trace = x_coeff and det = -y_coeff * rhs
+    int sum, product;
+    sumProduct(roots, sum, product);
+    x_coeff = sum;
+
+    // split -product into y_coeff * rhs using a random divisor
+    int target = -product;
+    int magnitude = target < 0 ? -target : target;
+    std::vector<int> divisors;
+    for (int d = 1; d <= magnitude; d++) {
+        if (magnitude % d == 0) divisors.push_back(d);
+    }
+    y_coeff = divisors[Random::next() % divisors.size()];
+    rhs = target / y_coeff;
+}
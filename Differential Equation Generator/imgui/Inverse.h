@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Polynomial.h"
+
+#include <vector>
+
+// Builds equation coefficients backwards from a sampled solution structure,
+// so every generated equation has integer roots or a simple complex pair
+class InverseGenerator {
+public:
+    static thread_local bool enabled; // "Nice answers" mode, per thread like the other generator settings
+
+    // random root structure for a degree n polynomial: distinct integers,
+    // a repeated (resonant) root or a complex pair a ± bi
+    static std::vector<PolyRoot> sampleRoots(int degree, bool allowZero);
+    // monic integer polynomial with these roots, coefficients after the leading 1
+    static std::vector<int> expand(const std::vector<PolyRoot>& roots);
+
+    // x^2 y'' + a x y' + b y = 0 whose indicial equation has the two given roots
+    static void cauchyEuler(const std::vector<PolyRoot>& roots, int& a, int& b);
+    // [[x_coeff, y_coeff], [rhs, 0]] with the two given eigenvalues
+    static void system(const std::vector<PolyRoot>& roots, int& x_coeff, int& y_coeff, int& rhs);
+};
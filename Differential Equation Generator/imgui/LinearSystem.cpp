@@ -0,0 +1,233 @@
+#include "LinearSystem.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+    // largest entry allowed while mixing, keeps the generated systems readable and well-conditioned
+    const long long EntryBound = 12;
+
+    // mixes generated systems before falling back to the diagonal one
+    const int MixTries = 4;
+
+    // out = a*b - c*d, false on 64-bit overflow
+    bool mulSub(long long a, long long b, long long c, long long d, long long& out) {
+        auto mul = [](long long x, long long y, long long& r) {
+            if (x != 0 && (y > LLONG_MAX / (x < 0 ? -x : x) || y < -(LLONG_MAX / (x < 0 ? -x : x)))) return false;
+            r = x * y;
+            return true;
+        };
+        long long ab, cd;
+        if (!mul(a, b, ab) || !mul(c, d, cd)) return false;
+        if ((cd < 0 && ab > LLONG_MAX + cd) || (cd > 0 && ab < LLONG_MIN + cd)) return false;
+        out = ab - cd;
+        return true;
+    }
+
+    // similarity by transvations E = I + c e_i e_j^T: row i += c row j, then column j -= c column i
+    void mix(std::vector<long long>& A, int n) {
+        for (int attempt = 0; attempt < 3 * n && n > 1; attempt++) {
+            int i = Random::next() % n, j = Random::next() % (n - 1);
+            if (j >= i) j++;
+            long long c = Random::next() % 2 ? 1 : -1;
+
+            for (int k = 0; k < n; k++) A[i * n + k] += c * A[j * n + k];
+            for (int k = 0; k < n; k++) A[k * n + j] -= c * A[k * n + i];
+
+            bool tooLarge = false;
+            for (int k = 0; k < n && !tooLarge; k++) {
+                tooLarge = std::llabs(A[i * n + k]) > EntryBound || std::llabs(A[k * n + j]) > EntryBound;
+            }
+            if (tooLarge) {
+                // undo in reverse order
+                for (int k = 0; k < n; k++) A[k * n + j] += c * A[k * n + i];
+                for (int k = 0; k < n; k++) A[i * n + k] -= c * A[j * n + k];
+            }
+        }
+    }
+
+    bool isZero(long long v) { return v == 0; }
+    bool isZero(const BigInt& v) { return v.isZero(); }
+
+    // Bareiss elimination over T; step(a, b, c, d, p, out) sets out = (a*b - c*d) / p,
+    // false when T can't hold it
+    template<class T, class Step>
+    bool bareiss(std::vector<T> M, int n, T& det, Step step) {
+        T previous(1);
+        bool negate = false;
+        for (int k = 0; k < n - 1; k++) {
+            // pivot on a non-zero entry of column k
+            if (isZero(M[k * n + k])) {
+                int swapRow = -1;
+                for (int r = k + 1; r < n; r++) {
+                    if (!isZero(M[r * n + k])) { swapRow = r; break; }
+                }
+                if (swapRow < 0) { det = T(0); return true; }
+                for (int j = 0; j < n; j++) std::swap(M[k * n + j], M[swapRow * n + j]);
+                negate = !negate;
+            }
+            for (int i = k + 1; i < n; i++) {
+                for (int j = k + 1; j < n; j++) {
+                    // M_ij = (M_kk M_ij - M_ik M_kj) / previous pivot, the division is exact
+                    if (!step(M[k * n + k], M[i * n + j], M[i * n + k], M[k * n + j], previous, M[i * n + j])) return false;
+                }
+            }
+            previous = M[k * n + k];
+        }
+        det = n > 0 ? M[(n - 1) * n + (n - 1)] : T(1);
+        if (negate) det = -det;
+        return true;
+    }
+
+    std::vector<double> multiply(const std::vector<double>& X, const std::vector<double>& Y, int n) {
+        std::vector<double> Z(n * n, 0.0);
+        for (int i = 0; i < n; i++) {
+            for (int k = 0; k < n; k++) {
+                double x = X[i * n + k];
+                if (x == 0.0) continue;
+                for (int j = 0; j < n; j++) Z[i * n + j] += x * Y[k * n + j];
+            }
+        }
+        return Z;
+    }
+
+    // solves D X = N in place (N becomes X) with partial pivoting
+    void solve(std::vector<double> D, std::vector<double>& N, int n) {
+        for (int c = 0; c < n; c++) {
+            int pivot = c;
+            for (int r = c + 1; r < n; r++) {
+                if (std::fabs(D[r * n + c]) > std::fabs(D[pivot * n + c])) pivot = r;
+            }
+            if (pivot != c) {
+                for (int j = 0; j < n; j++) {
+                    std::swap(D[c * n + j], D[pivot * n + j]);
+                    std::swap(N[c * n + j], N[pivot * n + j]);
+                }
+            }
+            for (int r = c + 1; r < n; r++) {
+                double f = D[r * n + c] / D[c * n + c];
+                if (f == 0.0) continue;
+                for (int j = c; j < n; j++) D[r * n + j] -= f * D[c * n + j];
+                for (int j = 0; j < n; j++) N[r * n + j] -= f * N[c * n + j];
+            }
+        }
+        for (int c = n - 1; c >= 0; c--) {
+            for (int j = 0; j < n; j++) {
+                double sum = N[c * n + j];
+                for (int k = c + 1; k < n; k++) sum -= D[c * n + k] * N[k * n + j];
+                N[c * n + j] = sum / D[c * n + c];
+            }
+        }
+    }
+}
+
+LinearSystem LinearSystem::generate(const std::vector<int>& eigenvalues) {
+    LinearSystem sys;
+    sys.n = (int)eigenvalues.size();
+    sys.eigenvalues = eigenvalues;
+    std::sort(sys.eigenvalues.begin(), sys.eigenvalues.end());
+
+    int n = sys.n;
+    std::vector<long long>& A = sys.A;
+
+    // D with the eigenvalues in random diagonal order
+    std::vector<int> diag = eigenvalues;
+    for (int i = n - 1; i > 0; i--) std::swap(diag[i], diag[Random::next() % (i + 1)]);
+
+    // the similarity is exact, so det(A) has to come out as the product of the eigenvalues.
+    // A mix that doesn't is thrown away, and after a few D itself is kept
+    BigInt product(1);
+    for (int v : eigenvalues) product = product * BigInt(v);
+    for (int tries = 0; tries <= MixTries; tries++) {
+        A.assign(n * n, 0);
+        for (int i = 0; i < n; i++) A[i * n + i] = diag[i];
+        if (tries == MixTries) break;
+        mix(A, n);
+        if (determinant(A, n).compare(product) == 0) break;
+    }
+    return sys;
+}
+
+LinearSystem LinearSystem::random(int n, bool allowZero) {
+    std::vector<int> eigenvalues(n);
+    for (int& v : eigenvalues) {
+        if (allowZero) {
+            v = Random::next() % 11 - 5;
+        }
+        else {
+            v = Random::next() % 10 - 5;
+            if (v >= 0) v++;
+        }
+    }
+    return generate(eigenvalues);
+}
+
+BigInt LinearSystem::determinant(const std::vector<long long>& M, int n) {
+    long long small;
+    auto smallStep = [](long long a, long long b, long long c, long long d, long long p, long long& out) {
+        long long v;
+        if (!mulSub(a, b, c, d, v)) return false;
+        out = v / p;
+        return true;
+    };
+    if (bareiss(M, n, small, smallStep)) return BigInt(small);
+
+    std::vector<BigInt> big(M.begin(), M.end());
+    BigInt det;
+    bareiss(big, n, det, [](const BigInt& a, const BigInt& b, const BigInt& c, const BigInt& d, const BigInt& p, BigInt& out) {
+        BigInt remainder;
+        BigInt::divMod(a * b - c * d, p, out, remainder);
+        return true;
+    });
+    return det;
+}
+
+std::vector<double> LinearSystem::expm(const std::vector<double>& M, int n) {
+    // scale so the norm is at most 1/2
+    double norm = 0.0;
+    for (int i = 0; i < n; i++) {
+        double row = 0.0;
+        for (int j = 0; j < n; j++) row += std::fabs(M[i * n + j]);
+        norm = std::max(norm, row);
+    }
+    int s = norm > 0.5 ? (int)std::ceil(std::log2(norm / 0.5)) : 0;
+    double scale = std::ldexp(1.0, -s);
+
+    std::vector<double> X(M.size());
+    for (size_t k = 0; k < M.size(); k++) X[k] = M[k] * scale;
+
+    // N = sum c_k X^k, D = sum (-1)^k c_k X^k
+    const int q = 6;
+    std::vector<double> N(n * n, 0.0), D(n * n, 0.0), P(n * n, 0.0);
+    for (int i = 0; i < n; i++) { N[i * n + i] = 1.0; D[i * n + i] = 1.0; P[i * n + i] = 1.0; }
+    double c = 1.0;
+    for (int k = 1; k <= q; k++) {
+        c = c * (q - k + 1) / (k * (2.0 * q - k + 1));
+        P = multiply(P, X, n);
+        double sign = (k % 2) ? -1.0 : 1.0;
+        for (int i = 0; i < n * n; i++) {
+            N[i] += c * P[i];
+            D[i] += sign * c * P[i];
+        }
+    }
+    solve(D, N, n);
+
+    // undo the scaling by repeated squaring
+    for (int k = 0; k < s; k++) N = multiply(N, N, n);
+    return N;
+}
+
+std::vector<double> LinearSystem::evolve(const std::vector<double>& x0, double t) const {
+    std::vector<double> At(A.size());
+    for (size_t k = 0; k < A.size(); k++) At[k] = double(A[k]) * t;
+    std::vector<double> E = expm(At, n);
+    std::vector<double> x(n, 0.0);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) x[i] += E[i * n + j] * x0[j];
+    }
+    return x;
+}
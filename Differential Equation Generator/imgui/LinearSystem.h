@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Rational.h"
+
+#include <vector>
+
+// N x N constant coefficient system x' = Ax with prescribed integer eigenvalues
+class LinearSystem {
+public:
+    static const int MaxDimension = 32;
+
+    int n = 0;
+    std::vector<long long> A;     // row-major n x n
+    std::vector<int> eigenvalues; // ascending, with repeats
+
+    // builds A = U D U^-1 from D = diag(eigenvalues) and a unimodular U made of
+    // integer transvations, so A stays integer and keeps small entries
+    static LinearSystem generate(const std::vector<int>& eigenvalues);
+    // n random eigenvalues in [-5, 5], without 0 unless allowZero
+    static LinearSystem random(int n, bool allowZero = false);
+
+    // exact determinant of an integer matrix by fraction-free Bareiss elimination, in
+    // long longs and again in BigInts when an intermediate minor overflows them
+    static BigInt determinant(const std::vector<long long>& M, int n);
+    // e^M by scaling and squaring with a [6/6] Pade approximant
+    static std::vector<double> expm(const std::vector<double>& M, int n);
+
+    // x(t) = e^(At) x0
+    std::vector<double> evolve(const std::vector<double>& x0, double t) const;
+};
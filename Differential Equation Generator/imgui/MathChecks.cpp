@@ -0,0 +1,365 @@
+// Deterministic checks of the math modules against results worked out by hand. Prints each
+// check that fails and exits with 1 if any did. Built on Linux next to the headless harness,
+// see the README; not part of the Visual Studio build
+#include "Exactness.h"
+#include "Expr.h"
+#include "Grader.h"
+#include "Integrator.h"
+#include "Parser.h"
+#include "Polynomial.h"
+#include "Random.h"
+#include "Rational.h"
+#include "Series.h"
+#include "Simplifier.h"
+
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    int checks = 0, failures = 0;
+
+    void check(bool ok, const std::string& what) {
+        checks++;
+        if (!ok) {
+            failures++;
+            std::printf("FAIL %s\n", what.c_str());
+        }
+    }
+
+    void checkEqual(const std::string& got, const std::string& expected, const std::string& what) {
+        check(got == expected, what + ": got \"" + got + "\", expected \"" + expected + "\"");
+    }
+
+    const Expr* parse(const std::string& text, ExprArena& arena) {
+        const Expr* e = ExprParser::parse(text, arena);
+        check(e != nullptr, "parse \"" + text + "\"");
+        return e ? e : arena.constant(0);
+    }
+
+    const Expr* canonical(const std::string& text, ExprArena& arena) {
+        return Simplifier::simplify(parse(text, arena), arena);
+    }
+
+    void checkParser() {
+        ExprArena arena;
+        // what ExprFormat prints parses back to the node it was printed from
+        const char* printed[] = {
+            "dy/dx + 8y = 0",
+            "x^2*d^2y/dx^2 + 3x*dy/dx + 2y = 0",
+            "y'(t) + 3y(t) = sin(4t)",
+            "(3x/y + 12y)*dy",
+            "dy/(6y) = dx/(14x)",
+            "\u2202^2u/\u2202x^2 = \u2202u/\u2202t",
+            "e^x*sin(2x)",
+            "dx/dt = 2x + 3y,\ndy/dt = x - y",
+        };
+        for (const char* text : printed) {
+            const Expr* e = parse(text, arena);
+            checkEqual(ExprFormat::format(e), text, "format of the parse");
+            check(ExprParser::parse(ExprFormat::format(e), arena) == e, std::string("\"") + text + "\" parses back to the same node");
+        }
+        // input written differently reads as the same expression
+        check(parse("2*x*3", arena) == parse("6x", arena), "numeric factors fold");
+        check(parse("y' + 8*y = 0", arena)->op == ExprOp::Equation, "an equation parses to an Equation");
+        check(parse("dx/dt = x,\ndy/dt = y", arena)->op == ExprOp::System, "a list of equations parses to a System");
+
+        // syntax errors come back as null with the byte offset of the problem
+        const struct { const char* text; size_t position; } bad[] = {
+            { "dy/dx + = 3", 8 },
+            { "(x + 1", 6 },
+            { "sin()", 4 },
+            { "y = 2 = 3", 6 },
+        };
+        for (auto& b : bad) {
+            ExprParser::Error error;
+            check(ExprParser::parse(b.text, arena, &error) == nullptr && error.position == b.position && !error.message.empty(),
+                std::string("\"") + b.text + "\" is rejected at " + std::to_string(b.position) + ", got " + std::to_string(error.position));
+        }
+    }
+
+    void checkSimplifier() {
+        ExprArena arena;
+        // equations scale to coprime integer coefficients, so multiples share one interned form
+        const char* same[][2] = {
+            { "36y*dy + 90x*dx = 0", "2y*dy + 5x*dx = 0" },
+            { "dy/(6y) = dx/(14x)", "7dy/y = 3dx/x" },
+            { "2dy/dx + 16y = 0", "dy/dx + 8y = 0" },
+        };
+        for (auto& pair : same) {
+            check(canonical(pair[0], arena) == canonical(pair[1], arena),
+                std::string("\"") + pair[0] + "\" and \"" + pair[1] + "\" share a canonical form");
+        }
+        const char* forms[][2] = {
+            { "36y*dy + 90x*dx = 0", "5x*dx + 2y*dy = 0" },
+            { "dy/(6y) = dx/(14x)", "7dy/y = 3dx/x" },
+            { "2dy/dx + 16y = 0", "dy/dx + 8y = 0" },
+            { "x + x", "2x" },
+            { "x*x", "x^2" },
+            { "-3/4*x", "-3x/4" },
+        };
+        for (auto& form : forms) {
+            checkEqual(ExprFormat::format(canonical(form[0], arena)), form[1], std::string("canonical form of \"") + form[0] + "\"");
+        }
+        // a canonical form is its own canonical form
+        const Expr* once = canonical("x^2*d^2y/dx^2 + 3x*dy/dx + 2y = 0", arena);
+        check(Simplifier::simplify(once, arena) == once, "simplify is idempotent");
+        check(canonical("dy/dx + 8y = 0", arena) != canonical("dy/dx + 7y = 0", arena), "different equations keep different forms");
+    }
+
+    void checkExactness() {
+        ExprArena arena;
+        // 2xy + e^x and x^2 + ln(y) come from F = x^2 y + e^x + y ln(y) - y; y and 2x have
+        // dM/dy = 1 against dN/dx = 2
+        ExactForm exactForm, otherForm;
+        exactForm.M = { { 2, 1, 1, 1, TermFactor::One, TermFactor::One }, { 1, 1, 0, 0, TermFactor::Exp, TermFactor::One } };
+        exactForm.N = { { 1, 1, 2, 0, TermFactor::One, TermFactor::One }, { 1, 1, 0, 0, TermFactor::One, TermFactor::Ln } };
+        otherForm.M = { { 1, 1, 0, 1, TermFactor::One, TermFactor::One } };
+        otherForm.N = { { 2, 1, 1, 0, TermFactor::One, TermFactor::One } };
+        std::vector<char> exact;
+        ExactnessVerifier::verifyBatch({ exactForm, otherForm, exactForm }, exact);
+        check(exact.size() == 3 && exact[0] && !exact[1] && exact[2], "dual-number check of an exact and a non-exact form");
+        std::vector<ExactTerm> F;
+        check(exactForm.potentialTerms(F), "potential of the exact form");
+        checkEqual(ExprFormat::format(ExactForm::termsToExpr(arena, F)), "x^2*y + e^x + y*ln(y) - y", "potential of the exact form");
+        // drawn forms that pass the batch have a potential with dF/dx == M and dF/dy == N
+        Random::Scope scope(1);
+        for (int i = 0; i < 16; i++) {
+            ExactForm form = ExactForm::randomExact();
+            bool matches = form.potentialTerms(F);
+            for (double x = 0.75; matches && x < 2; x += 0.5) {
+                double y = 2.25 - x;
+                double m = ExactForm::evalTerms(form.M, x, y), n = ExactForm::evalTerms(form.N, x, y);
+                double Fx = ExactForm::evalTerms(F, Dual(x, 1), Dual(y, 0)).der, Fy = ExactForm::evalTerms(F, Dual(x, 0), Dual(y, 1)).der;
+                matches = std::fabs(Fx - m) <= 1e-9 * (1 + std::fabs(m)) && std::fabs(Fy - n) <= 1e-9 * (1 + std::fabs(n));
+            }
+            check(matches, "potential of drawn exact form " + std::to_string(i));
+        }
+    }
+
+    // product of the factors, each raised to its power, coefficients highest degree first
+    std::vector<double> expand(const std::vector<std::pair<std::vector<double>, int>>& factors) {
+        std::vector<double> poly(1, 1.0);
+        for (auto& factor : factors) {
+            for (int k = 0; k < factor.second; k++) {
+                std::vector<double> next(poly.size() + factor.first.size() - 1, 0.0);
+                for (size_t i = 0; i < poly.size(); i++) {
+                    for (size_t j = 0; j < factor.first.size(); j++) next[i + j] += poly[i] * factor.first[j];
+                }
+                poly = next;
+            }
+        }
+        return poly;
+    }
+
+    void checkRoots() {
+        // repeated real and complex roots, ill-conditioned ones whose approximations scatter by
+        // 1e-2 and more, and simple roots close enough to pass for a double one
+        const struct { std::vector<std::pair<std::vector<double>, int>> factors; const char* roots; } cases[] = {
+            { { { { 1, -1 }, 3 } }, "1 (x3)" },
+            { { { { 1, 0, 1 }, 2 } }, "0 \u00b1 1i (x2)" },
+            { { { { 1, -2, 5 }, 2 }, { { 1, 3 }, 1 } }, "-3, 1 \u00b1 2i (x2)" },
+            { { { { 1, -2 }, 4 }, { { 1, -3 }, 7 } }, "2 (x4), 3 (x7)" },
+            { { { { 1, -4, 5 }, 2 }, { { 1, -3 }, 4 }, { { 1, -4 }, 4 } }, "3 (x4), 4 (x4), 2 \u00b1 1i (x2)" },
+            { { { { 1, -1 }, 1 }, { { 1, -1.001 }, 1 } }, "1, 1.001" },
+            { { { { 1, -2 }, 2 }, { { 1, -2.001 }, 1 } }, "2 (x2), 2.001" },
+        };
+        for (auto& c : cases) {
+            std::vector<double> poly = expand(c.factors);
+            std::vector<PolyRoot> roots = PolynomialRoots::solve(poly);
+            checkEqual(PolynomialRoots::formatRoots(roots), c.roots, "roots");
+            // every root once, with its multiplicity
+            int count = 0;
+            bool distinct = true;
+            for (size_t i = 0; i < roots.size(); i++) {
+                count += roots[i].multiplicity;
+                for (size_t j = i + 1; j < roots.size(); j++) distinct = distinct && roots[i].value != roots[j].value;
+            }
+            check(distinct && count == (int)poly.size() - 1, std::string("roots of multiplicities summing to the degree for ") + c.roots);
+        }
+        checkEqual(PolynomialRoots::solutionForm(PolynomialRoots::solve(expand({ { { 1, -1 }, 2 } }))), "C1*e^(x) + C2*x*e^(x)", "solution for a double root");
+
+        // a batch finds the same roots as each polynomial alone, whatever shares its lanes
+        std::vector<std::vector<double>> polys;
+        for (int i = 0; i < 11; i++) polys.push_back(expand({ { { 1, double(i % 4) }, i % 3 + 1 }, { { 1, 1, double(i) }, 1 } }));
+        std::vector<std::vector<PolyRoot>> batch;
+        PolynomialRoots::solveBatch(polys, batch);
+        bool same = batch.size() == polys.size();
+        for (size_t i = 0; same && i < polys.size(); i++) {
+            std::vector<PolyRoot> alone = PolynomialRoots::solve(polys[i]);
+            same = alone.size() == batch[i].size();
+            for (size_t k = 0; same && k < alone.size(); k++) same = alone[k].value == batch[i][k].value && alone[k].multiplicity == batch[i][k].multiplicity;
+        }
+        check(same, "batched roots match roots found alone");
+    }
+
+    void checkGrader() {
+        ExprArena arena;
+        // answers solved by hand, right and wrong, to one equation of each graded kind
+        const struct { const char* equation; const char* indep; const char* answer; Verdict verdict; } answers[] = {
+            { "dy/dx + 8y = 0", "x", "y = C*e^(-8x)", Verdict::Correct },
+            { "dy/dx + 8y = 0", "x", "y = C*e^(8x)", Verdict::Incorrect },
+            { "dy/dx + 8y = 0", "x", "y = (x", Verdict::ParseError },
+            { "dy/dx + 8y = 0", "x", "y = y*x", Verdict::Unsupported },
+            { "x^2*d^2y/dx^2 + 3x*dy/dx + 2y = 0", "x", "y = (C1*cos(ln(x)) + C2*sin(ln(x)))/x", Verdict::Correct },
+            { "x^2*d^2y/dx^2 + 3x*dy/dx + 2y = 0", "x", "y = C/x", Verdict::Incorrect },
+            { "d^2y/dx^2 + 4y = 0", "x", "y = A*sin(2x) + B*cos(2x)", Verdict::Correct },
+            { "d^2y/dx^2 + 4y = 0", "x", "y = sin(x)", Verdict::Incorrect },
+            { "7dy/y = 3dx/x", "x", "y = C*x^(3/7)", Verdict::Correct },
+            { "7dy/y = 3dx/x", "x", "y = C*x^(7/3)", Verdict::Incorrect },
+            { "y'(t) + 3y(t) = sin(4t)", "t", "y = (3sin(4t) - 4cos(4t))/25 + C*e^(-3t)", Verdict::Correct },
+            { "y'(t) + 3y(t) = sin(4t)", "t", "y = C*e^(-3t)", Verdict::Incorrect },
+        };
+        for (auto& a : answers) {
+            AnswerGrader grader;
+            check(grader.prepare(parse(a.equation, arena), a.indep, arena), std::string("grader takes \"") + a.equation + "\"");
+            GradeResult result = grader.grade(a.answer, arena);
+            check(result.verdict == a.verdict, std::string("\"") + a.answer + "\" for \"" + a.equation + "\" gets verdict "
+                + std::to_string((int)a.verdict) + ", got " + std::to_string((int)result.verdict));
+        }
+        // the sample points come from the options' seed, so a grade is the same every time
+        AnswerGrader first, second;
+        first.prepare(parse("d^2y/dx^2 + 4y = 0", arena), "x", arena);
+        second.prepare(parse("d^2y/dx^2 + 4y = 0", arena), "x", arena);
+        check(first.grade("y = sin(x)", arena).maxResidual == second.grade("y = sin(x)", arena).maxResidual, "a grade doesn't change");
+        // a class's homework graded on threads matches grading it one answer at a time
+        const char* homework[] = { "y = A*sin(2x) + B*cos(2x)", "y = sin(x)", "y = (x", "y=C*cos(2x)", "y = e^(2x)",
+            "y = C*cos(2*x)", "y = y*x", "3sin(2x)" };
+        std::vector<std::string> submissions;
+        for (int i = 0; i < 200; i++) submissions.push_back(homework[(i * 5 + i / 8) % 8]);
+        std::vector<GradeResult> batch;
+        first.gradeBatch(submissions, batch, 4);
+        bool same = batch.size() == submissions.size();
+        for (size_t i = 0; same && i < submissions.size(); i++) {
+            GradeResult one = second.grade(submissions[i], arena);
+            same = batch[i].verdict == one.verdict && batch[i].maxResidual == one.maxResidual && batch[i].message == one.message;
+        }
+        check(same, "grading on threads matches grading one at a time");
+        AnswerGrader partial;
+        check(!partial.prepare(parse("\u2202^2u/\u2202x^2 = \u2202u/\u2202t", arena), "x", arena), "a partial equation isn't graded");
+    }
+
+    void checkRational() {
+        // long long overflow moves to BigInt with the exact value
+        Rational twoTo64 = Rational(1LL << 62) * 4;
+        check(twoTo64.isBig(), "2^64 is a BigInt");
+        checkEqual(twoTo64.toString(), "18446744073709551616", "2^64");
+        checkEqual((Rational(LLONG_MAX) + 1).toString(), "9223372036854775808", "LLONG_MAX + 1");
+        checkEqual((-Rational(LLONG_MAX) - 2).toString(), "-9223372036854775809", "-LLONG_MAX - 2");
+        Rational tiny = Rational(1, 4052555153018976267LL) / 3;
+        check(tiny.isBig(), "1/3^40 is a BigInt");
+        checkEqual(tiny.toString(), "1/12157665459056928801", "1/3^40");
+        // and results that fit again drop back to long longs
+        Rational back = twoTo64 / Rational(1LL << 32);
+        check(!back.isBig() && back == Rational(1LL << 32), "2^64 / 2^32 is back on the fast path");
+        back = tiny * 9;
+        check(!back.isBig() && back == Rational(1, 1350851717672992089LL), "9/3^40 is back on the fast path");
+        check(Rational(LLONG_MAX) < twoTo64 && twoTo64 < twoTo64 + Rational(1, 2) && -twoTo64 < Rational(LLONG_MIN), "BigInt values order");
+
+        // the harmonic number H50 has a numerator and a denominator over 64 bits
+        Rational harmonic;
+        for (int k = 1; k <= 50; k++) harmonic += Rational(1, k);
+        checkEqual(harmonic.toString(), "13943237577224054960759/3099044504245996706400", "H50");
+        check(!(harmonic - harmonic).isBig() && (harmonic - harmonic) == Rational(0), "H50 - H50 is 0");
+
+        // truncating division with multi-limb divisors and signs
+        BigInt a(12345678901234567LL), b(98765432109876543LL), c(1000000007LL);
+        BigInt product = a * b * c;
+        checkEqual(product.toString(), "1219326319905502041335161686267337578433167", "BigInt product");
+        BigInt quotient, remainder;
+        BigInt::divMod(product + BigInt(11), b * c, quotient, remainder);
+        check(quotient.compare(a) == 0 && remainder.compare(BigInt(11)) == 0, "divMod by a multi-limb divisor");
+        BigInt::divMod(-(product + BigInt(11)), b * c, quotient, remainder);
+        check(quotient.compare(-a) == 0 && remainder.compare(BigInt(-11)) == 0, "divMod keeps the sign of the dividend");
+        BigInt::divMod(BigInt(5), product, quotient, remainder);
+        check(quotient.isZero() && remainder.compare(BigInt(5)) == 0, "divMod by a larger divisor");
+        check(BigInt::gcd(BigInt(6) * product, BigInt(-4) * product).compare(BigInt(2) * product) == 0, "BigInt gcd");
+    }
+
+    void checkSeries() {
+        // x^2 y'' + x y' + x^2 y = 0 is Bessel's equation of order 0, with J0 = sum (-1)^m x^2m / (4^m m!^2)
+        std::vector<Rational> A = { Rational(1) }, B = { Rational(1) }, C = { Rational(0), Rational(0), Rational(1) };
+        std::vector<Rational> a;
+        check(FrobeniusSolver::coefficients(A, B, C, Rational(0), 9, a), "J0 recurrence");
+        const Rational j0[] = { Rational(1), Rational(0), Rational(-1, 4), Rational(0), Rational(1, 64), Rational(0),
+            Rational(-1, 2304), Rational(0), Rational(1, 147456) };
+        for (int n = 0; n < 9 && n < (int)a.size(); n++) checkEqual(a[n].toString(), j0[n].toString(), "J0 coefficient " + std::to_string(n));
+        // order 1/2 at r = 1/2 is x^(1/2) sin(x)/x
+        C = { Rational(-1, 4), Rational(0), Rational(1) };
+        check(FrobeniusSolver::coefficients(A, B, C, Rational(1, 2), 8, a), "J1/2 recurrence");
+        const Rational sinc[] = { Rational(1), Rational(0), Rational(-1, 6), Rational(0), Rational(1, 120), Rational(0), Rational(-1, 5040), Rational(0) };
+        for (int n = 0; n < 8 && n < (int)a.size(); n++) checkEqual(a[n].toString(), sinc[n].toString(), "sin(x)/x coefficient " + std::to_string(n));
+        // order 1 at r = -1: the roots differ by 2 and the second solution needs a log term
+        C = { Rational(-1), Rational(0), Rational(1) };
+        check(!FrobeniusSolver::coefficients(A, B, C, Rational(-1), 4, a), "J1 at r = -1 is refused");
+
+        // the divide and conquer solver against the same functions' values
+        std::vector<double> dA = { 1 }, dB = { 1 }, dC = { 0, 0, 1 }, series;
+        check(FrobeniusSolver::solve(dA, dB, dC, 0, 64, series), "J0 series");
+        check(std::fabs(FrobeniusSolver::evaluate(series, 1) - 0.76519768655796655) < 1e-14, "J0(1)");
+        check(FrobeniusSolver::residual(dA, dB, dC, 0, series) < 1e-12, "J0 series residual");
+        dC = { -0.25, 0, 1 };
+        check(FrobeniusSolver::solve(dA, dB, dC, 0.5, 64, series), "J1/2 series");
+        check(std::fabs(FrobeniusSolver::evaluate(series, 2) - std::sin(2.0) / 2) < 1e-14, "sin(2)/2");
+        dC = { -1, 0, 1 };
+        check(!FrobeniusSolver::solve(dA, dB, dC, -1, 8, series), "J1 series at r = -1 is refused");
+
+        // series arithmetic on products and quotients known in closed form
+        std::vector<double> ones(100, 1.0), product = PowerSeries::multiply(ones, ones, 100);
+        bool exact = product.size() == 100;
+        for (int k = 0; exact && k < 100; k++) exact = product[k] == k + 1;
+        check(exact, "1/(1 - x)^2 by Karatsuba has coefficients k + 1");
+        std::vector<double> inverse = PowerSeries::inverse({ 1, -1 }, 50);
+        exact = inverse.size() == 50;
+        for (int k = 0; exact && k < 50; k++) exact = inverse[k] == 1;
+        check(exact, "1/(1 - x) has unit coefficients");
+        check(PowerSeries::compose({ 1, 2, 1 }, { 0, 2 }, 3) == std::vector<double>({ 1, 4, 4 }), "(1 + 2x)^2 by composition");
+    }
+
+    void checkIntegrator() {
+        // a mildly decaying problem stays on the explicit method
+        Integrator::Result decay = Integrator::integrate(OdeProblem::linear({ -1 }, 1), { 1 }, 0, 1);
+        check(decay.completed && !decay.stiff && std::fabs(decay.y[0] - std::exp(-1.0)) < 1e-8, "y' = -y on the explicit method");
+
+        // y' = diag(-1e4, -1) y switches to Rosenbrock, keeps reusing one factorization and ends within tol
+        Integrator::Result linear = Integrator::integrate(OdeProblem::linear({ -1e4, 0, 0, -1 }, 2), { 1, 1 }, 0, 1, 1e-8);
+        check(linear.completed && linear.stiff, "diag(-1e4, -1) is found stiff");
+        check(linear.factorizations * 100 < linear.steps, "a constant Jacobian reuses its factorization");
+        check(std::fabs(linear.y[0]) < 1e-12 && std::fabs(linear.y[1] - std::exp(-1.0)) < 1e-8 * std::exp(-1.0), "diag(-1e4, -1) at t = 1");
+
+        // Robertson's reactions to t = 40 against a reference solution
+        OdeProblem robertson;
+        robertson.n = 3;
+        robertson.f = [](double, const double* y, double* dy) {
+            dy[0] = -0.04 * y[0] + 1e4 * y[1] * y[2];
+            dy[1] = 0.04 * y[0] - 1e4 * y[1] * y[2] - 3e7 * y[1] * y[1];
+            dy[2] = 3e7 * y[1] * y[1];
+        };
+        robertson.jacobian = [](double, const double* y, double* J) {
+            J[0] = -0.04, J[1] = 1e4 * y[2], J[2] = 1e4 * y[1];
+            J[3] = 0.04, J[4] = -1e4 * y[2] - 6e7 * y[1], J[5] = -1e4 * y[1];
+            J[6] = 0, J[7] = 6e7 * y[1], J[8] = 0;
+        };
+        robertson.timeDerivative = [](double, const double*, double* dt) { dt[0] = dt[1] = dt[2] = 0; };
+        Integrator::Result r = Integrator::integrate(robertson, { 1, 0, 0 }, 0, 40, 1e-8);
+        check(r.completed && r.stiff, "Robertson is found stiff");
+        check(std::fabs(r.y[0] - 0.7158270687193685) < 1e-8 && std::fabs(r.y[1] - 9.185534764557001e-06) < 1e-12
+              && std::fabs(r.y[2] - 0.2841637457458669) < 1e-8, "Robertson at t = 40");
+    }
+}
+
+int main() {
+    checkParser();
+    checkSimplifier();
+    checkExactness();
+    checkRoots();
+    checkGrader();
+    checkRational();
+    checkSeries();
+    checkIntegrator();
+    std::printf("%d of %d checks passed\n", checks - failures, checks);
+    return failures ? 1 : 0;
+}
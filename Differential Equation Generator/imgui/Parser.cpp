@@ -0,0 +1,375 @@
+#include "Parser.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+    enum class Tok {
+        Number, Ident, Func, D, Partial, Prime,
+        Plus, Minus, Star, Slash, Caret, LParen, RParen, Equals, Comma, End
+    };
+
+    struct Token {
+        Tok kind;
+        size_t begin, end; // byte range in the text
+        double value;      // Number
+        std::string name;  // Ident, Func
+    };
+
+    // character classes, looked up once per byte instead of chains of isalpha/isdigit/strchr
+    enum CharClass : unsigned char { Other, Space, Digit, Letter, Operator, Quote, Utf8 };
+
+    struct ClassTable {
+        unsigned char c[256];
+        ClassTable() {
+            std::memset(c, Other, sizeof(c));
+            for (const char* s = " \t\r\n"; *s; s++) c[(unsigned char)*s] = Space;
+            for (int d = '0'; d <= '9'; d++) c[d] = Digit;
+            for (int l = 'a'; l <= 'z'; l++) c[l] = Letter;
+            for (int l = 'A'; l <= 'Z'; l++) c[l] = Letter;
+            for (const char* s = "+-*/^()=,."; *s; s++) c[(unsigned char)*s] = Operator;
+            c[(unsigned char)'\''] = Quote;
+            for (int b = 0x80; b < 0x100; b++) c[b] = Utf8;
+        }
+    };
+    const ClassTable classes;
+
+    const char* const Functions[] = { "sin", "cos", "tan", "ln", "log", "exp", "sqrt", "sinh", "cosh" };
+
+    class Lexer {
+    public:
+        explicit Lexer(const std::string& text) : s(text) {}
+
+        // false with errorAt set on an unknown character
+        bool run(std::vector<Token>& out) {
+            size_t i = 0, n = s.size();
+            while (true) {
+                // whitespace comes in runs (", \n" between system rows), skip the whole run
+                while (i < n && classes.c[(unsigned char)s[i]] == Space) i++;
+                if (i >= n) break;
+                unsigned char ch = (unsigned char)s[i];
+                Token t;
+                t.begin = i;
+                t.value = 0.0;
+                switch (classes.c[ch]) {
+                case Digit:
+                    i = number(i, t);
+                    break;
+                case Letter:
+                    i = word(i, t);
+                    break;
+                case Quote:
+                    t.kind = Tok::Prime;
+                    i++;
+                    break;
+                case Operator:
+                    if (ch == '.') {
+                        i = number(i, t);
+                        break;
+                    }
+                    t.kind = op(ch);
+                    i++;
+                    break;
+                case Utf8:
+                    // "∂" is E2 88 82, "·" is C2 B7
+                    if (s.compare(i, 3, "\xE2\x88\x82") == 0) { t.kind = Tok::Partial; i += 3; break; }
+                    if (s.compare(i, 2, "\xC2\xB7") == 0) { t.kind = Tok::Star; i += 2; break; }
+                    errorAt = i;
+                    return false;
+                default:
+                    errorAt = i;
+                    return false;
+                }
+                t.end = i;
+                out.push_back(t);
+            }
+            Token end;
+            end.kind = Tok::End;
+            end.begin = end.end = n;
+            end.value = 0.0;
+            out.push_back(end);
+            return true;
+        }
+
+        size_t errorAt = 0;
+
+    private:
+        const std::string& s;
+
+        static Tok op(unsigned char ch) {
+            switch (ch) {
+            case '+': return Tok::Plus;
+            case '-': return Tok::Minus;
+            case '*': return Tok::Star;
+            case '/': return Tok::Slash;
+            case '^': return Tok::Caret;
+            case '(': return Tok::LParen;
+            case ')': return Tok::RParen;
+            case '=': return Tok::Equals;
+            default: return Tok::Comma;
+            }
+        }
+
+        size_t number(size_t i, Token& t) {
+            size_t n = s.size();
+            size_t j = i;
+            while (j < n && (classes.c[(unsigned char)s[j]] == Digit || s[j] == '.')) j++;
+            // exponent only when digits follow, "2e^x" is 2 times e^x
+            if (j + 1 < n && (s[j] == 'e' || s[j] == 'E')) {
+                size_t k = j + 1;
+                if (k < n && (s[k] == '+' || s[k] == '-')) k++;
+                if (k < n && classes.c[(unsigned char)s[k]] == Digit) {
+                    j = k;
+                    while (j < n && classes.c[(unsigned char)s[j]] == Digit) j++;
+                }
+            }
+            t.kind = Tok::Number;
+            t.value = std::strtod(s.substr(i, j - i).c_str(), nullptr);
+            return j;
+        }
+
+        // letters are single-letter variables ("3xy" is 3*x*y) unless the run is a function
+        // name in front of "(", or a "d" that starts a derivative or differential
+        size_t word(size_t i, Token& t) {
+            size_t n = s.size();
+            size_t j = i;
+            while (j < n && classes.c[(unsigned char)s[j]] == Letter) j++;
+            if (j < n && s[j] == '(') {
+                for (const char* f : Functions) {
+                    if (s.compare(i, j - i, f) == 0) {
+                        t.kind = Tok::Func;
+                        t.name = s.substr(i, j - i);
+                        return j;
+                    }
+                }
+            }
+            if (s[i] == 'd' && i + 1 < n && (classes.c[(unsigned char)s[i + 1]] == Letter || s[i + 1] == '^' || s[i + 1] == '(')) {
+                t.kind = Tok::D;
+                return i + 1;
+            }
+            // x1, x12: digits right after a letter are part of the name
+            size_t k = i + 1;
+            while (k < n && classes.c[(unsigned char)s[k]] == Digit) k++;
+            t.kind = Tok::Ident;
+            t.name = s.substr(i, k - i);
+            return k;
+        }
+    };
+
+    // binding powers
+    const int AddBp = 10;
+    const int MulBp = 20;
+    const int UnaryBp = 25;
+    const int PowBp = 30;
+
+    class Parser {
+    public:
+        Parser(const std::vector<Token>& tokens, ExprArena& arena) : toks(tokens), arena(arena) {}
+
+        const Expr* top() {
+            std::vector<const Expr*> equations;
+            do {
+                const Expr* e = equation();
+                if (e == nullptr) return nullptr;
+                equations.push_back(e);
+            } while (accept(Tok::Comma) && peek().kind != Tok::End);
+            if (peek().kind != Tok::End) return fail("unexpected input");
+            return equations.size() == 1 ? equations[0] : arena.system(equations);
+        }
+
+        size_t errorAt = 0;
+        std::string message;
+
+    private:
+        const std::vector<Token>& toks;
+        ExprArena& arena;
+        size_t pos = 0;
+
+        const Token& peek(size_t ahead = 0) const {
+            size_t k = pos + ahead;
+            return toks[k < toks.size() ? k : toks.size() - 1];
+        }
+        const Token& next() { return toks[pos < toks.size() - 1 ? pos++ : pos]; }
+        bool accept(Tok kind) {
+            if (peek().kind != kind) return false;
+            pos++;
+            return true;
+        }
+        const Expr* fail(const char* what) {
+            if (message.empty()) {
+                message = what;
+                errorAt = peek().begin;
+            }
+            return nullptr;
+        }
+        bool expect(Tok kind, const char* what) {
+            if (accept(kind)) return true;
+            fail(what);
+            return false;
+        }
+
+        const Expr* equation() {
+            const Expr* lhs = expression(0);
+            if (lhs == nullptr) return nullptr;
+            if (!accept(Tok::Equals)) return lhs;
+            const Expr* rhs = expression(0);
+            return rhs == nullptr ? nullptr : arena.equation(lhs, rhs);
+        }
+
+        // a token that can start an operand, juxtaposition multiplies ("3x", "2sin(t)", "4∂u/∂x")
+        static bool startsOperand(Tok kind) {
+            return kind == Tok::Number || kind == Tok::Ident || kind == Tok::Func || kind == Tok::D ||
+                kind == Tok::Partial || kind == Tok::LParen;
+        }
+
+        const Expr* expression(int minBp) {
+            const Expr* lhs = prefix();
+            while (lhs != nullptr) {
+                Tok kind = peek().kind;
+                if ((kind == Tok::Plus || kind == Tok::Minus) && AddBp > minBp) {
+                    pos++;
+                    const Expr* rhs = expression(AddBp);
+                    if (rhs == nullptr) return nullptr;
+                    lhs = arena.add({ lhs, kind == Tok::Minus ? arena.mul({ arena.constant(-1.0), rhs }) : rhs });
+                }
+                else if ((kind == Tok::Star || kind == Tok::Slash) && MulBp > minBp) {
+                    pos++;
+                    const Expr* rhs = expression(MulBp);
+                    if (rhs == nullptr) return nullptr;
+                    lhs = kind == Tok::Star ? arena.mul({ lhs, rhs }) : arena.div(lhs, rhs);
+                }
+                else if (startsOperand(kind) && MulBp > minBp) {
+                    const Expr* rhs = expression(MulBp);
+                    if (rhs == nullptr) return nullptr;
+                    lhs = arena.mul({ lhs, rhs });
+                }
+                else if (kind == Tok::Caret && PowBp > minBp) {
+                    // right associative, the exponent may carry its own sign
+                    pos++;
+                    const Expr* rhs = expression(PowBp - 1);
+                    if (rhs == nullptr) return nullptr;
+                    lhs = arena.pow(lhs, rhs);
+                }
+                else {
+                    break;
+                }
+            }
+            return lhs;
+        }
+
+        const Expr* prefix() {
+            size_t at = pos;
+            const Token& t = next();
+            switch (t.kind) {
+            case Tok::Number:
+                return arena.constant(t.value);
+            case Tok::Minus: {
+                const Expr* e = expression(UnaryBp);
+                return e == nullptr ? nullptr : arena.mul({ arena.constant(-1.0), e });
+            }
+            case Tok::Plus:
+                return expression(UnaryBp);
+            case Tok::LParen: {
+                const Expr* e = expression(0);
+                if (e == nullptr || !expect(Tok::RParen, "expected ')'")) return nullptr;
+                return e;
+            }
+            case Tok::Func: {
+                if (!expect(Tok::LParen, "expected '('")) return nullptr;
+                const Expr* arg = expression(0);
+                if (arg == nullptr || !expect(Tok::RParen, "expected ')'")) return nullptr;
+                return arena.func(t.name, arg);
+            }
+            case Tok::Ident:
+                return identifier(t);
+            case Tok::D:
+                return derivative(DerivStyle::Leibniz);
+            case Tok::Partial:
+                return derivative(DerivStyle::Partial);
+            default:
+                pos = at;
+                return fail("expected an operand");
+            }
+        }
+
+        const Expr* identifier(const Token& t) {
+            // e^x
+            if (t.name == "e") {
+                if (!accept(Tok::Caret)) return arena.func("exp", arena.constant(1.0));
+                const Expr* exponent = expression(PowBp - 1);
+                return exponent == nullptr ? nullptr : arena.func("exp", exponent);
+            }
+            // y'(t), y''(t)
+            int primes = 0;
+            while (accept(Tok::Prime)) primes++;
+            // y(t): an unknown function of a single variable, written without a space
+            bool applied = peek().kind == Tok::LParen && peek().begin == toks[pos - 1].end &&
+                peek(1).kind == Tok::Ident && peek(2).kind == Tok::RParen;
+            if (primes > 0 && !applied) {
+                return arena.deriv(arena.var(t.name), "x", primes, DerivStyle::Prime);
+            }
+            if (!applied) return arena.var(t.name);
+            pos++;
+            const Token& arg = next();
+            pos++;
+            const Expr* f = arena.func(t.name, arena.var(arg.name));
+            return primes > 0 ? arena.deriv(f, arg.name, primes, DerivStyle::Prime) : f;
+        }
+
+        // after "d" or "∂": "dy/dx", "d^2y/dx^2", "∂u/∂x", "d(...)/dx", or a differential "dx"
+        const Expr* derivative(DerivStyle style) {
+            Tok dTok = style == DerivStyle::Partial ? Tok::Partial : Tok::D;
+            int order = 1;
+            if (accept(Tok::Caret)) {
+                if (peek().kind != Tok::Number) return fail("expected the derivative order");
+                order = (int)next().value;
+            }
+            const Expr* of;
+            std::string name;
+            if (accept(Tok::LParen)) {
+                of = expression(0);
+                if (of == nullptr || !expect(Tok::RParen, "expected ')'")) return nullptr;
+            }
+            else {
+                if (peek().kind != Tok::Ident) return fail("expected a variable after d");
+                name = next().name;
+                of = arena.var(name);
+            }
+            bool quotient = peek().kind == Tok::Slash && peek(1).kind == dTok && peek(2).kind == Tok::Ident;
+            if (!quotient) {
+                if (style == DerivStyle::Leibniz && order == 1 && !name.empty()) return arena.differential(name);
+                return fail("expected '/d' and the variable of differentiation");
+            }
+            pos += 2;
+            std::string wrt = next().name;
+            if (order > 1) {
+                if (!accept(Tok::Caret) || peek().kind != Tok::Number || (int)next().value != order) {
+                    return fail("the orders above and below the fraction differ");
+                }
+            }
+            return arena.deriv(of, wrt, order, style);
+        }
+    };
+}
+
+const Expr* ExprParser::parse(const std::string& text, ExprArena& arena, Error* error) {
+    std::vector<Token> tokens;
+    tokens.reserve(text.size() / 2 + 2);
+    Lexer lexer(text);
+    if (!lexer.run(tokens)) {
+        if (error != nullptr) {
+            error->position = lexer.errorAt;
+            error->message = "unexpected character";
+        }
+        return nullptr;
+    }
+    Parser parser(tokens, arena);
+    const Expr* e = parser.top();
+    if (e == nullptr && error != nullptr) {
+        error->position = parser.errorAt;
+        error->message = parser.message;
+    }
+    return e;
+}
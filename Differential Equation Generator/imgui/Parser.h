@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Expr.h"
+
+#include <string>
+
+// Parses the notation ExprFormat prints ("dy/dx + 8y = 0", "x^2*d^2y/dx^2", "∂^2u/∂x^2",
+// "y'(t) + 3y(t) = sin(4t)", "(3x/y + 12y)*dy") back into arena expressions
+class ExprParser {
+public:
+    struct Error {
+        size_t position = 0; // byte offset into the text
+        std::string message;
+    };
+
+    // an equation, a system ("dx/dt = ...,\ndy/dt = ...") or a plain expression;
+    // nullptr on a syntax error, with the reason in error when it is given
+    static const Expr* parse(const std::string& text, ExprArena& arena, Error* error = nullptr);
+};
@@ -0,0 +1,401 @@
+#include "Polynomial.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+
+namespace {
+
+    const int MaxIterations = 200;
+    const double PI = 3.14159265358979323846;
+    const double Epsilon = 2.220446049250313e-16;
+
+    // runs Aberth-Ehrlich on up to Lanes monic polynomials of the same degree.
+    // c[k * Lanes + l] is coefficient k (after the leading 1) of lane l,
+    // zr/zi[i * Lanes + l] receive root i of lane l
+    void aberthLanes(int degree, const double* c, double* zr, double* zi) {
+        const int L = PolynomialRoots::Lanes;
+
+        // start on a circle sized by the Cauchy bound, rotated off the real axis
+        for (int l = 0; l < L; l++) {
+            double bound = 0.0;
+            for (int k = 0; k < degree; k++) bound = std::max(bound, std::fabs(c[k * L + l]));
+            double radius = 0.5 * (1.0 + bound);
+            for (int i = 0; i < degree; i++) {
+                double angle = 2.0 * PI * i / degree + 0.4;
+                zr[i * L + l] = radius * std::cos(angle);
+                zi[i * L + l] = radius * std::sin(angle);
+            }
+        }
+
+        // a root stops moving once |p(z)| is down to the rounding error of computing it.
+        // How close that is to the root depends on its conditioning, which is what a step
+        // size test can't see: the approximations of a repeated root keep taking steps
+        // far above 1e-15 until the iteration limit
+        std::vector<char> done(degree * L, 0);
+        bool converged[L];
+        for (int l = 0; l < L; l++) converged[l] = false;
+
+        for (int iter = 0; iter < MaxIterations; iter++) {
+            double maxStep[L];
+            for (int l = 0; l < L; l++) maxStep[l] = 0.0;
+
+            for (int i = 0; i < degree; i++) {
+                double pr[L], pi[L], dr[L], di[L], er[L], mod[L];
+                double sr[L], si[L];
+                double* xr = zr + i * L;
+                double* xi = zi + i * L;
+
+                // Horner for p and p' across lanes, and for sum |c_k| |z|^k, which bounds
+                // the error of p
+                for (int l = 0; l < L; l++) {
+                    pr[l] = 1.0; pi[l] = 0.0; dr[l] = 0.0; di[l] = 0.0; er[l] = 1.0;
+                    mod[l] = std::sqrt(xr[l] * xr[l] + xi[l] * xi[l]);
+                }
+                for (int k = 0; k < degree; k++) {
+                    const double* ck = c + k * L;
+                    for (int l = 0; l < L; l++) {
+                        double ndr = dr[l] * xr[l] - di[l] * xi[l] + pr[l];
+                        double ndi = dr[l] * xi[l] + di[l] * xr[l] + pi[l];
+                        double npr = pr[l] * xr[l] - pi[l] * xi[l] + ck[l];
+                        double npi = pr[l] * xi[l] + pi[l] * xr[l];
+                        dr[l] = ndr; di[l] = ndi; pr[l] = npr; pi[l] = npi;
+                        er[l] = er[l] * mod[l] + std::fabs(ck[l]);
+                    }
+                }
+
+                // sum of 1 / (z_i - z_j)
+                for (int l = 0; l < L; l++) { sr[l] = 0.0; si[l] = 0.0; }
+                for (int j = 0; j < degree; j++) {
+                    if (j == i) continue;
+                    const double* yr = zr + j * L;
+                    const double* yi = zi + j * L;
+                    for (int l = 0; l < L; l++) {
+                        double ar = xr[l] - yr[l], ai = xi[l] - yi[l];
+                        double inv = 1.0 / (ar * ar + ai * ai + 1e-300);
+                        sr[l] += ar * inv;
+                        si[l] -= ai * inv;
+                    }
+                }
+
+                // z_i -= w / (1 - w * s) with w = p / p'
+                for (int l = 0; l < L; l++) {
+                    if (converged[l] || done[i * L + l]) continue;
+                    double noise = 4.0 * degree * Epsilon * er[l];
+                    if (pr[l] * pr[l] + pi[l] * pi[l] <= noise * noise) {
+                        done[i * L + l] = 1;
+                        continue;
+                    }
+                    double dd = dr[l] * dr[l] + di[l] * di[l];
+                    if (dd == 0.0) continue;
+                    double wr = (pr[l] * dr[l] + pi[l] * di[l]) / dd;
+                    double wi = (pi[l] * dr[l] - pr[l] * di[l]) / dd;
+                    double qr = 1.0 - (wr * sr[l] - wi * si[l]);
+                    double qi = -(wr * si[l] + wi * sr[l]);
+                    double qq = qr * qr + qi * qi;
+                    double stepr = (wr * qr + wi * qi) / qq;
+                    double stepi = (wi * qr - wr * qi) / qq;
+                    xr[l] -= stepr;
+                    xi[l] -= stepi;
+                    double rel = std::sqrt(stepr * stepr + stepi * stepi) / (1.0 + std::sqrt(xr[l] * xr[l] + xi[l] * xi[l]));
+                    maxStep[l] = std::max(maxStep[l], rel);
+                }
+            }
+
+            bool all = true;
+            for (int l = 0; l < L; l++) {
+                if (maxStep[l] < 1e-15) converged[l] = true;
+                all = all && converged[l];
+            }
+            if (all) break;
+        }
+    }
+
+    // coefficients of the k-th derivative, highest degree first
+    std::vector<double> derivative(const std::vector<double>& poly, int k) {
+        std::vector<double> d = poly;
+        for (int i = 0; i < k && d.size() > 1; i++) {
+            int n = int(d.size()) - 1;
+            for (int j = 0; j < n; j++) d[j] *= double(n - j);
+            d.pop_back();
+        }
+        return d;
+    }
+
+    // p(z) by Horner; noise gets the bound on its rounding error
+    std::complex<double> evaluate(const std::vector<double>& poly, std::complex<double> z, double& noise) {
+        std::complex<double> p = 0.0;
+        double a = 0.0, mod = std::abs(z);
+        for (double c : poly) {
+            p = p * z + c;
+            a = a * mod + std::fabs(c);
+        }
+        noise = 4.0 * poly.size() * Epsilon * a;
+        return p;
+    }
+
+    // Newton steps on the (m-1)th derivative, where a root of multiplicity m is simple
+    std::complex<double> polish(const std::vector<double>& poly, int m, std::complex<double> z) {
+        std::vector<double> d = derivative(poly, m - 1);
+        for (int iter = 0; iter < 4; iter++) {
+            std::complex<double> p = 0.0, dp = 0.0;
+            for (double c : d) {
+                dp = dp * z + p;
+                p = p * z + c;
+            }
+            if (std::abs(dp) == 0.0) break;
+            z -= p / dp;
+        }
+        return z;
+    }
+
+    // true when r is within 1e-6 of a root of multiplicity m. Near such a root
+    // p(r + e) ~ p^(m)(r) e^m / m!, so |p(r)| gives the distance as its m-th root;
+    // a residual below the rounding error of p passes outright
+    bool verifyRoot(const std::vector<double>& poly, int m, std::complex<double> r) {
+        double noise;
+        double residual = std::abs(evaluate(poly, r, noise));
+        if (residual <= noise) return true;
+        double ignored;
+        double slope = std::abs(evaluate(derivative(poly, m), r, ignored));
+        double factorial = 1.0;
+        for (int k = 2; k <= m; k++) factorial *= k;
+        if (slope == 0.0) return false;
+        return std::pow(factorial * residual / slope, 1.0 / m) <= 1e-6 * (1.0 + std::abs(r));
+    }
+
+    // snaps parts within 1e-7 of an integer, or of the real axis
+    std::complex<double> snap(std::complex<double> r) {
+        if (std::fabs(r.imag()) < 1e-7 * (1.0 + std::abs(r))) r = std::complex<double>(r.real(), 0.0);
+        if (std::fabs(r.real() - std::round(r.real())) < 1e-7) r = std::complex<double>(std::round(r.real()), r.imag());
+        if (std::fabs(r.imag() - std::round(r.imag())) < 1e-7) r = std::complex<double>(r.real(), std::round(r.imag()));
+        return r;
+    }
+
+    // how far rounding moves the approximations of a root r of multiplicity m: p(r + e) ~
+    // p^(m)(r) e^m / m! is lost in the rounding of p once it is below eps sum |c_k| |r|^k
+    double scatter(const std::vector<double>& poly, int m, std::complex<double> r) {
+        double noise, ignored;
+        evaluate(poly, r, noise);
+        double slope = std::abs(evaluate(derivative(poly, m), r, ignored));
+        double factorial = 1.0;
+        for (int k = 2; k <= m; k++) factorial *= k;
+        if (slope == 0.0) return 0.0;
+        return 2.0 * std::pow(factorial * noise / (4.0 * poly.size()) / slope, 1.0 / m);
+    }
+
+    // the members of groups that failed their check, polished one by one. Those of an
+    // ill-conditioned multiple root land near, or at, the same value, possibly from several
+    // groups. Each takes the most of its nearest neighbours that, centroid polished, check
+    // as one root of their summed multiplicity
+    std::vector<PolyRoot> mergeRoots(const std::vector<double>& poly, const std::vector<PolyRoot>& roots) {
+        std::vector<PolyRoot> out;
+        std::vector<char> used(roots.size(), 0);
+        for (size_t i = 0; i < roots.size(); i++) {
+            if (used[i]) continue;
+            // further than this the members of a root of any multiplicity here don't scatter
+            double reach = 0.1 * (1.0 + std::abs(roots[i].value));
+            std::vector<size_t> near;
+            for (size_t j = i + 1; j < roots.size(); j++) {
+                if (!used[j] && std::abs(roots[j].value - roots[i].value) <= reach) near.push_back(j);
+            }
+            std::sort(near.begin(), near.end(), [&](size_t a, size_t b) {
+                return std::abs(roots[a].value - roots[i].value) < std::abs(roots[b].value - roots[i].value);
+            });
+            PolyRoot root = roots[i];
+            size_t taken = 0;
+            for (size_t k = near.size(); k > 0; k--) {
+                std::complex<double> sum = roots[i].value * double(roots[i].multiplicity);
+                int m = roots[i].multiplicity;
+                for (size_t q = 0; q < k; q++) {
+                    sum += roots[near[q]].value * double(roots[near[q]].multiplicity);
+                    m += roots[near[q]].multiplicity;
+                }
+                std::complex<double> r = snap(polish(poly, m, sum / double(m)));
+                bool within = std::abs(roots[near[k - 1]].value - r) <= scatter(poly, m, r) && std::abs(roots[i].value - r) <= scatter(poly, m, r);
+                if (within && verifyRoot(poly, m, r)) {
+                    root = { r, m };
+                    taken = k;
+                    break;
+                }
+            }
+            for (size_t q = 0; q < taken; q++) used[near[q]] = 1;
+            out.push_back(root);
+        }
+        return out;
+    }
+
+    // groups the approximations into distinct roots. Each z_i gets the inclusion radius
+    // n |p(z_i)| / |lead * prod (z_i - z_j)|: the disks contain the roots, and a connected
+    // group of m disks holds exactly m of them. So the radii, and with them what counts
+    // as one repeated root, follow the conditioning instead of a fixed distance. The
+    // centroid of a group is far more accurate than its members for repeated roots
+    std::vector<PolyRoot> clusterRoots(const std::vector<double>& poly, const std::vector<std::complex<double>>& z) {
+        const size_t n = z.size();
+        std::vector<double> radius(n);
+        for (size_t i = 0; i < n; i++) {
+            double noise;
+            double residual = std::abs(evaluate(poly, z[i], noise));
+            std::complex<double> product = poly[0];
+            for (size_t j = 0; j < n; j++) {
+                if (j != i && z[j] != z[i]) product *= z[i] - z[j];
+            }
+            radius[i] = std::abs(product) == 0.0 ? 0.0 : n * std::max(residual, noise) / std::abs(product);
+        }
+        // connected groups of overlapping disks
+        std::vector<size_t> group(n);
+        for (size_t i = 0; i < n; i++) group[i] = i;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = i + 1; j < n; j++) {
+                if (std::abs(z[i] - z[j]) > radius[i] + radius[j]) continue;
+                size_t from = group[j], to = group[i];
+                for (size_t k = 0; k < n; k++) {
+                    if (group[k] == from) group[k] = to;
+                }
+            }
+        }
+
+        std::vector<PolyRoot> out, unchecked;
+        for (size_t i = 0; i < n; i++) {
+            // a group is labeled by one of its members
+            if (group[i] != i) continue;
+            std::vector<std::complex<double>> members;
+            for (size_t j = 0; j < n; j++) {
+                if (group[j] == i) members.push_back(z[j]);
+            }
+            std::complex<double> sum = 0.0;
+            for (const std::complex<double>& m : members) sum += m;
+            int count = int(members.size());
+            std::complex<double> r = sum / double(count);
+            if (count > 1) r = polish(poly, count, r);
+            r = snap(r);
+            if (verifyRoot(poly, count, r)) {
+                PolyRoot root = { r, count };
+                out.push_back(root);
+                continue;
+            }
+            // not a root of that multiplicity after all, polished as the simple roots found
+            for (const std::complex<double>& m : members) {
+                PolyRoot root = { snap(polish(poly, 1, m)), 1 };
+                unchecked.push_back(root);
+            }
+        }
+        std::vector<PolyRoot> merged = mergeRoots(poly, unchecked);
+        out.insert(out.end(), merged.begin(), merged.end());
+        // real roots first, then by real part
+        std::sort(out.begin(), out.end(), [](const PolyRoot& a, const PolyRoot& b) {
+            if ((a.value.imag() == 0.0) != (b.value.imag() == 0.0)) return a.value.imag() == 0.0;
+            if (a.value.real() != b.value.real()) return a.value.real() < b.value.real();
+            return a.value.imag() > b.value.imag();
+        });
+        return out;
+    }
+
+    std::string xPower(int k, const char* var) {
+        if (k == 0) return "";
+        if (k == 1) return var;
+        return std::string(var) + "^" + std::to_string(k);
+    }
+
+    // "e^(3x)", "e^(-x)", "" for r = 0
+    std::string expTerm(double r, const char* var) {
+        if (r == 0.0) return "";
+        std::string k = PolynomialRoots::formatNumber(r);
+        if (k == "1") k = "";
+        else if (k == "-1") k = "-";
+        return "e^(" + k + var + ")";
+    }
+
+    std::string trigArg(double b, const char* var) {
+        std::string k = PolynomialRoots::formatNumber(b);
+        return (k == "1" ? std::string() : k) + var;
+    }
+}
+
+void PolynomialRoots::solveBatch(const std::vector<std::vector<double>>& polys, std::vector<std::vector<PolyRoot>>& roots) {
+    roots.assign(polys.size(), std::vector<PolyRoot>());
+
+    // bucket by degree so every lane in a group runs the same loop bounds
+    std::map<int, std::vector<size_t>> byDegree;
+    for (size_t p = 0; p < polys.size(); p++) {
+        if (polys[p].size() >= 2 && polys[p][0] != 0.0) byDegree[int(polys[p].size()) - 1].push_back(p);
+    }
+
+    for (auto& group : byDegree) {
+        int n = group.first;
+        const std::vector<size_t>& ids = group.second;
+        std::vector<double> c(n * Lanes), zr(n * Lanes), zi(n * Lanes);
+
+        for (size_t start = 0; start < ids.size(); start += Lanes) {
+            // pad unused lanes with the last polynomial of the chunk
+            for (int l = 0; l < Lanes; l++) {
+                size_t p = ids[std::min(start + l, ids.size() - 1)];
+                double lead = polys[p][0];
+                for (int k = 0; k < n; k++) c[k * Lanes + l] = polys[p][k + 1] / lead;
+            }
+
+            aberthLanes(n, c.data(), zr.data(), zi.data());
+
+            for (int l = 0; l < Lanes && start + l < ids.size(); l++) {
+                std::vector<std::complex<double>> z(n);
+                for (int i = 0; i < n; i++) z[i] = std::complex<double>(zr[i * Lanes + l], zi[i * Lanes + l]);
+                roots[ids[start + l]] = clusterRoots(polys[ids[start + l]], z);
+            }
+        }
+    }
+}
+
+std::vector<PolyRoot> PolynomialRoots::solve(const std::vector<double>& poly) {
+    std::vector<std::vector<PolyRoot>> roots;
+    solveBatch(std::vector<std::vector<double>>(1, poly), roots);
+    return roots[0];
+}
+
+std::string PolynomialRoots::formatNumber(double v) {
+    if (std::fabs(v - std::round(v)) < 1e-9) return std::to_string((long long)std::round(v));
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", v);
+    return buf;
+}
+
+std::string PolynomialRoots::formatRoots(const std::vector<PolyRoot>& roots) {
+    std::string s;
+    for (const PolyRoot& r : roots) {
+        if (r.value.imag() < 0.0) continue; // shown with its conjugate
+        if (!s.empty()) s += ", ";
+        s += formatNumber(r.value.real());
+        if (r.value.imag() > 0.0) s += " ± " + formatNumber(r.value.imag()) + "i";
+        if (r.multiplicity > 1) s += " (x" + std::to_string(r.multiplicity) + ")";
+    }
+    return s;
+}
+
+std::string PolynomialRoots::solutionForm(const std::vector<PolyRoot>& roots, const char* var) {
+    std::string s;
+    int constant = 1;
+    auto nextC = [&constant]() { return "C" + std::to_string(constant++); };
+    auto join = [](const std::string& a, const std::string& b) {
+        if (a.empty()) return b;
+        if (b.empty()) return a;
+        return a + "*" + b;
+    };
+
+    for (const PolyRoot& r : roots) {
+        double a = r.value.real(), b = r.value.imag();
+        if (b < 0.0) continue;
+        for (int k = 0; k < r.multiplicity; k++) {
+            std::string factor = join(xPower(k, var), expTerm(a, var));
+            if (!s.empty()) s += " + ";
+            if (b == 0.0) {
+                s += join(nextC(), factor);
+            }
+            else {
+                std::string c1 = nextC(), c2 = nextC();
+                std::string trig = c1 + "cos(" + trigArg(b, var) + ") + " + c2 + "sin(" + trigArg(b, var) + ")";
+                s += factor.empty() ? trig : join(factor, "(" + trig + ")");
+            }
+        }
+    }
+    return s;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <complex>
+#include <string>
+#include <vector>
+
+// Distinct root of a polynomial with its multiplicity
+struct PolyRoot {
+    std::complex<double> value;
+    int multiplicity;
+};
+
+// Batched Aberth-Ehrlich root finder
+class PolynomialRoots {
+public:
+    // polynomials evaluated side by side in one iteration
+    static const int Lanes = 8;
+
+    // polys[p] holds the coefficients of polynomial p, highest degree first.
+    // Polynomials of equal degree share lanes, roots[p] gets the distinct roots of polys[p]
+    static void solveBatch(const std::vector<std::vector<double>>& polys, std::vector<std::vector<PolyRoot>>& roots);
+    // single polynomial
+    static std::vector<PolyRoot> solve(const std::vector<double>& poly);
+
+    // Homogeneous solution y_h(x) of the constant coefficient ODE with these characteristic roots
+    static std::string solutionForm(const std::vector<PolyRoot>& roots, const char* var = "x");
+    // "2", "-1 (x2)", "1 ± 2i"
+    static std::string formatRoots(const std::vector<PolyRoot>& roots);
+    // integers print without decimals, anything else with 3 places
+    static std::string formatNumber(double v);
+};
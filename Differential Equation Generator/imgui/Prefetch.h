@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed ring between exactly one producer thread and one consumer thread. push() and pop()
+// never lock or wait: each side writes only its own index and reads the other's
+template <typename T, size_t Capacity>
+class SpscRing {
+public:
+    // producer side, false when the ring is full
+    bool push(T&& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == Capacity) return false;
+        slots[h % Capacity] = std::move(value);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    // consumer side, false when the ring is empty
+    bool pop(T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) return false;
+        value = std::move(slots[t % Capacity]);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+    bool full() const {
+        return size() == Capacity;
+    }
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T slots[Capacity];
+    // own cache lines, so the two threads don't bounce one between them
+    alignas(64) std::atomic<size_t> head{ 0 };
+    alignas(64) std::atomic<size_t> tail{ 0 };
+};
+
+// Makes items ahead of the UI thread on a background thread and hands them over through an
+// SpscRing. Once half the ring is free the thread fills it with one produce() call, which
+// returns the items for seeds seed, seed + 1, ..., each the same as if it were made alone.
+// Item i for a restart() depends on nothing but settings and seed + i, so take() returns the
+// same sequence however far ahead the thread is and however it batched. Items are only ever
+// made on the thread; the UI thread asks again on a later frame or waits for it. The mutex
+// only guards the settings handoff and the two threads' sleeps
+template <typename Item, typename Settings, size_t Depth = 4>
+class Prefetcher {
+public:
+    typedef std::function<std::vector<Item>(const Settings&, unsigned seed, size_t count)> Produce;
+
+    explicit Prefetcher(Produce produce) : produce(produce) {}
+    ~Prefetcher() { stop(); }
+    Prefetcher(const Prefetcher&) = delete;
+    Prefetcher& operator=(const Prefetcher&) = delete;
+
+    // UI thread: drops everything made so far and starts over for new settings, starting
+    // the thread on first use
+    void restart(const Settings& settings, unsigned seed) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return;
+            requested = settings;
+            requestedSeed = seed;
+            epoch++;
+            // drained under the lock: the thread only sees the new epoch once it has the lock,
+            // so nothing it makes for the new settings can be in the ring yet
+            currentEpoch = epoch;
+            nextIndex = 0;
+            Slot stale;
+            while (ring.pop(stale)) {}
+            if (!worker.joinable()) worker = std::thread(&Prefetcher::run, this);
+        }
+        wake.notify_one();
+    }
+
+    // UI thread: moves the next item into item once the thread has made it. With wait it
+    // blocks until then; without, it returns false at once and the same item is next again
+    bool take(Item& item, bool wait) {
+        while (true) {
+            Slot slot;
+            bool ready = false;
+            while (!ready && ring.pop(slot)) {
+                // anything else was left over from earlier settings
+                ready = slot.epoch == currentEpoch && slot.index == nextIndex;
+            }
+            {
+                // an empty critical section, so the wake-up can't slip in between the thread's
+                // check of the ring and its wait
+                std::lock_guard<std::mutex> lock(mutex);
+            }
+            wake.notify_one();
+            if (ready) {
+                nextIndex++;
+                item = std::move(slot.item);
+                return true;
+            }
+            if (!wait) return false;
+            std::unique_lock<std::mutex> lock(mutex);
+            made.wait(lock, [&] { return stopping || !ring.empty(); });
+            if (stopping) return false;
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        made.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+private:
+    struct Slot {
+        Item item;
+        unsigned epoch = 0, index = 0;
+    };
+
+    Produce produce;
+    SpscRing<Slot, Depth> ring;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;   // the thread's, for new settings or room in the ring
+    std::condition_variable made;   // the UI thread's, for a new item in the ring
+
+    // guarded by mutex
+    Settings requested;
+    unsigned requestedSeed = 0, epoch = 0;
+    bool stopping = false;
+
+    // UI thread only
+    unsigned currentEpoch = 0, nextIndex = 0;
+
+    void run() {
+        Settings settings;
+        unsigned seed = 0, seen = 0, index = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            // new settings wait for room too: the ring may still hold items the UI thread
+            // hasn't popped, stale or not
+            wake.wait(lock, [&] { return stopping || ring.size() <= Depth / 2; });
+            if (stopping) return;
+            if (epoch != seen) {
+                seen = epoch;
+                settings = requested;
+                seed = requestedSeed;
+                index = 0;
+            }
+            size_t count = Depth - ring.size();
+            lock.unlock();
+            std::vector<Item> items = produce(settings, seed + index, count);
+            assert(items.size() == count);
+            for (Item& item : items) {
+                Slot slot;
+                slot.item = std::move(item);
+                slot.epoch = seen;
+                slot.index = index++;
+                // only this thread pushes, and there was room for the batch when it last looked
+                bool pushed = ring.push(std::move(slot));
+                assert(pushed);
+                (void)pushed;
+            }
+            lock.lock();
+            made.notify_one();
+        }
+    }
+};
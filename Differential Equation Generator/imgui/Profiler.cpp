@@ -0,0 +1,248 @@
+#include "Profiler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+std::atomic<Profiler::Ring*> Profiler::rings[Profiler::MaxThreads];
+std::atomic<int> Profiler::ringCount{ 0 };
+std::atomic<long long> Profiler::droppedZones{ 0 };
+std::vector<Profiler::Zone> Profiler::current, Profiler::trace;
+size_t Profiler::traceNext = 0;
+bool Profiler::traceWrapped = false;
+Profiler::Histogram Profiler::histograms[Profiler::MaxZoneNames];
+int Profiler::histogramCount = 0;
+int Profiler::historyIndex = 0;
+int64_t Profiler::frameStart = 0;
+int64_t Profiler::frameEnd = 0;
+
+// the calling thread's ring, handed back for reuse when the thread exits
+struct ProfilerThread {
+    Profiler::Ring* ring = nullptr;
+    int index = -1;
+    int depth = 0;
+    bool registered = false;
+
+    ~ProfilerThread() {
+        if (ring) ring->free.store(true, std::memory_order_release);
+    }
+};
+
+namespace {
+    thread_local ProfilerThread profilerThread;
+
+    ImU32 zoneColor(const char* name) {
+        // names are literals, so one name always gets the same colour
+        uint32_t h = (uint32_t)(uintptr_t)name * 2654435761u;
+        return ImColor::HSV((h >> 8 & 0xff) / 255.0f, 0.45f, 0.85f);
+    }
+
+    void writeEscaped(FILE* file, const char* s) {
+        for (; *s; s++) {
+            if (*s == '"' || *s == '\\') std::fputc('\\', file);
+            if ((unsigned char)*s < 0x20) std::fprintf(file, "\\u%04x", (unsigned char)*s);
+            else std::fputc(*s, file);
+        }
+    }
+}
+
+Profiler::Scope::Scope(const char* name) : name(name), start(now()) {
+    profilerThread.depth++;
+}
+
+Profiler::Scope::~Scope() {
+    int64_t end = now();
+    int depth = --profilerThread.depth;
+    int thread;
+    if (threadRing(thread)) push({ name, start, end, depth, thread });
+}
+
+int64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::Ring* Profiler::threadRing(int& index) {
+    ProfilerThread& t = profilerThread;
+    if (!t.registered) {
+        t.registered = true;
+        // a ring left behind by an exited thread first, then a new one
+        int count = ringCount.load(std::memory_order_acquire);
+        for (int i = 0; i < count && i < MaxThreads && !t.ring; i++) {
+            Ring* ring = rings[i].load(std::memory_order_acquire);
+            bool exited = true;
+            if (ring && ring->free.compare_exchange_strong(exited, false, std::memory_order_acq_rel)) {
+                t.ring = ring;
+                t.index = i;
+            }
+        }
+        if (!t.ring) {
+            int i = ringCount.fetch_add(1, std::memory_order_acq_rel);
+            if (i < MaxThreads) {
+                t.ring = new Ring();
+                t.index = i;
+                rings[i].store(t.ring, std::memory_order_release);
+            }
+        }
+    }
+    index = t.index;
+    return t.ring;
+}
+
+void Profiler::push(const Zone& zone) {
+    Ring& ring = *profilerThread.ring;
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) == RingSize) {
+        droppedZones.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring.zones[head % RingSize] = zone;
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+long long Profiler::dropped() {
+    return droppedZones.load(std::memory_order_relaxed);
+}
+
+Profiler::Histogram* Profiler::histogram(const char* name) {
+    for (int i = 0; i < histogramCount; i++) {
+        if (histograms[i].name == name || std::strcmp(histograms[i].name, name) == 0) return &histograms[i];
+    }
+    if (histogramCount == MaxZoneNames) return nullptr;
+    histograms[histogramCount].name = name;
+    return &histograms[histogramCount++];
+}
+
+void Profiler::frame() {
+    if (trace.empty()) {
+        trace.resize(TraceZones);
+        current.reserve(RingSize);
+    }
+    current.clear();
+    int count = ringCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count && i < MaxThreads; i++) {
+        Ring* ring = rings[i].load(std::memory_order_acquire);
+        if (!ring) continue;
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            const Zone& zone = ring->zones[tail % RingSize];
+            current.push_back(zone);
+            trace[traceNext] = zone;
+            if (++traceNext == trace.size()) {
+                traceNext = 0;
+                traceWrapped = true;
+            }
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+
+    frameStart = frameEnd;
+    frameEnd = now();
+    if (frameStart == 0) {
+        frameStart = frameEnd;
+        for (const Zone& zone : current) frameStart = zone.start < frameStart ? zone.start : frameStart;
+    }
+
+    historyIndex = (historyIndex + 1) % HistoryFrames;
+    for (int i = 0; i < histogramCount; i++) histograms[i].ms[historyIndex] = 0.0f;
+    for (const Zone& zone : current) {
+        if (Histogram* h = histogram(zone.name)) h->ms[historyIndex] += (zone.end - zone.start) * 1e-6f;
+    }
+}
+
+void Profiler::showOverlay(bool* open) {
+    ImGui::SetNextWindowPos(ImVec2(20.0f, 380.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(440.0f, 320.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Profiler", open, ImGuiWindowFlags_NoFocusOnAppearing)) {
+        ImGui::End();
+        return;
+    }
+    double frameMs = (frameEnd - frameStart) * 1e-6;
+    ImGui::Text("Frame %.3f ms, %d zones, %lld dropped", frameMs, (int)current.size(), dropped());
+
+    // flame graph: a band of rows per thread, one row per nesting level, time across
+    int rowOffset[MaxThreads] = {}, rows = 0;
+    int maxDepth[MaxThreads];
+    std::fill(maxDepth, maxDepth + MaxThreads, -1);
+    for (const Zone& zone : current) {
+        if (zone.depth > maxDepth[zone.thread]) maxDepth[zone.thread] = zone.depth;
+    }
+    for (int i = 0; i < MaxThreads; i++) {
+        rowOffset[i] = rows;
+        rows += maxDepth[i] + 1;
+    }
+    float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    float width = ImGui::GetContentRegionAvail().x;
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::Dummy(ImVec2(width, rows * rowHeight));
+    if (rows > 0 && frameEnd > frameStart) {
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+        bool hovered = ImGui::IsItemHovered();
+        double scale = width / (double)(frameEnd - frameStart);
+        for (const Zone& zone : current) {
+            float x0 = origin.x + (float)((zone.start - frameStart) * scale);
+            float x1 = origin.x + (float)((zone.end - frameStart) * scale);
+            if (x0 < origin.x) x0 = origin.x;
+            if (x1 > origin.x + width) x1 = origin.x + width;
+            if (x1 - x0 < 1.0f) x1 = x0 + 1.0f;
+            float y0 = origin.y + (rowOffset[zone.thread] + zone.depth) * rowHeight;
+            ImVec2 min(x0, y0), max(x1, y0 + rowHeight - 1.0f);
+            drawList->AddRectFilled(min, max, zoneColor(zone.name));
+            if (x1 - x0 > 8.0f) {
+                drawList->PushClipRect(min, max, true);
+                drawList->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32(0, 0, 0, 255), zone.name);
+                drawList->PopClipRect();
+            }
+            if (hovered && mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < max.y) {
+                ImGui::SetTooltip("%s\n%.3f ms, thread %d", zone.name, (zone.end - zone.start) * 1e-6, zone.thread);
+            }
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Histograms", ImGuiTreeNodeFlags_DefaultOpen)) {
+        for (int i = 0; i < histogramCount; i++) {
+            const Histogram& h = histograms[i];
+            char overlay[32];
+            std::snprintf(overlay, sizeof(overlay), "%.3f ms", h.ms[historyIndex]);
+            ImGui::PlotHistogram(h.name, h.ms, HistoryFrames, (historyIndex + 1) % HistoryFrames, overlay, 0.0f, FLT_MAX, ImVec2(0.0f, 32.0f));
+        }
+    }
+
+    static const char* exported = nullptr;
+    if (ImGui::Button("Export trace")) {
+        exported = exportTrace("trace.json") ? "Wrote trace.json" : "Couldn't write trace.json";
+    }
+    if (exported) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(exported);
+    }
+    ImGui::End();
+}
+
+bool Profiler::exportTrace(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    size_t count = traceWrapped ? trace.size() : traceNext;
+    size_t first = traceWrapped ? traceNext : 0;
+    int64_t origin = 0;
+    for (size_t i = 0; i < count; i++) {
+        const Zone& zone = trace[(first + i) % trace.size()];
+        if (i == 0 || zone.start < origin) origin = zone.start;
+    }
+    std::fputs("{\"traceEvents\":[\n", file);
+    for (size_t i = 0; i < count; i++) {
+        const Zone& zone = trace[(first + i) % trace.size()];
+        std::fputs(i ? ",\n{\"name\":\"" : "{\"name\":\"", file);
+        writeEscaped(file, zone.name);
+        std::fprintf(file, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+            (zone.start - origin) * 1e-3, (zone.end - zone.start) * 1e-3, zone.thread);
+    }
+    std::fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped timing zones. Each thread writes finished zones into its own fixed ring that
+// only the UI thread reads, with no locks on either side; frame() collects them once a
+// frame for the flame graph, the per-zone histograms and the Chrome trace export.
+// PROFILE_ZONE compiles to nothing unless PROFILING is defined
+class Profiler {
+public:
+    static const int MaxThreads = 16;
+    static const int RingSize = 4096;       // zones a thread can finish between two frame() calls
+    static const int MaxZoneNames = 64;
+    static const int HistoryFrames = 120;   // histogram length
+    static const int TraceZones = 1 << 16;  // zones kept for the trace export
+
+    struct Zone {
+        const char* name;
+        int64_t start, end;                 // steady_clock nanoseconds
+        int depth, thread;
+    };
+
+    // times the enclosing block; name must be a string literal
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char* name;
+        int64_t start;
+    };
+
+    static int64_t now();
+    // ends a frame: drains every thread's ring and updates the histograms
+    static void frame();
+    // zones of the last frame, every thread, in the order they finished
+    static const std::vector<Zone>& lastFrame() { return current; }
+    // zones dropped because a ring was full
+    static long long dropped();
+
+    // flame graph of the last frame and a frame time histogram per zone
+    static void showOverlay(bool* open = nullptr);
+    // Trace Event Format JSON for chrome://tracing or Perfetto, false when the file can't be written
+    static bool exportTrace(const std::string& path);
+
+private:
+    // single producer (the owning thread), single consumer (frame())
+    struct Ring {
+        Zone zones[RingSize];
+        std::atomic<uint64_t> head{ 0 }, tail{ 0 };
+        std::atomic<bool> free{ false };    // its thread has exited, the next thread may take it
+    };
+    struct Histogram {
+        const char* name = nullptr;
+        float ms[HistoryFrames] = {};
+    };
+
+    static std::atomic<Ring*> rings[MaxThreads];
+    static std::atomic<int> ringCount;
+    static std::atomic<long long> droppedZones;
+
+    static std::vector<Zone> current, trace;
+    static size_t traceNext;                // oldest zone once the trace has wrapped
+    static bool traceWrapped;
+    static Histogram histograms[MaxZoneNames];
+    static int histogramCount, historyIndex;
+    static int64_t frameStart, frameEnd;
+
+    static Ring* threadRing(int& index);
+    static void push(const Zone& zone);
+    static Histogram* histogram(const char* name);
+
+    friend struct ProfilerThread;
+};
+
+#ifdef PROFILING
+#define PROFILE_ZONE(name) Profiler::Scope profile_zone(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
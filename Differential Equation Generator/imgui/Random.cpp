@@ -0,0 +1,27 @@
+#include "Random.h"
+
+namespace {
+    thread_local uint64_t state = 0x853c49e6748fea9bULL;
+}
+
+void Random::seed(uint32_t s) {
+    // splitmix64 of the seed, so seeds 1, 2, 3... don't start the LCG on neighbouring states
+    uint64_t z = s + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    state = z ^ (z >> 31);
+}
+
+int Random::next() {
+    // 64-bit LCG (Knuth's MMIX constants); the low bits are weak, so return the top 31
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (int)(state >> 33);
+}
+
+Random::Scope::Scope(uint32_t s) : saved(state) {
+    seed(s);
+}
+
+Random::Scope::~Scope() {
+    state = saved;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// rand() replacement for the generators. Each thread has its own state, so equations made
+// on the prefetch thread don't disturb the UI thread's sequence and the same seed always
+// gives the same equation on either
+class Random {
+public:
+    static const int Max = 0x7fffffff;
+
+    // seeds the calling thread, nearby seeds still give unrelated sequences
+    static void seed(uint32_t s);
+    // 0..Max
+    static int next();
+
+    // seeds the calling thread for one scope and puts its old state back afterwards, so
+    // making an equation from a fixed seed leaves the thread's own sequence where it was
+    class Scope {
+    public:
+        explicit Scope(uint32_t s);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        uint64_t saved;
+    };
+};
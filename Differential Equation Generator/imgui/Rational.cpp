@@ -0,0 +1,444 @@
+#include "Rational.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+
+namespace {
+
+    // overflow checks that only use portable arithmetic; LLONG_MIN counts as overflow
+    // so negation and abs are always safe on the fast path
+    inline bool addOverflows(long long a, long long b, long long& out) {
+        if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN + 1 - b)) return true;
+        out = a + b;
+        return false;
+    }
+
+    inline bool mulOverflows(long long a, long long b, long long& out) {
+        if (a == 0 || b == 0) {
+            out = 0;
+            return false;
+        }
+        unsigned long long ua = a < 0 ? 0ULL - (unsigned long long)a : (unsigned long long)a;
+        unsigned long long ub = b < 0 ? 0ULL - (unsigned long long)b : (unsigned long long)b;
+        if (ua > (unsigned long long)LLONG_MAX / ub) return true;
+        long long magnitude = (long long)(ua * ub);
+        out = (a < 0) != (b < 0) ? -magnitude : magnitude;
+        return false;
+    }
+
+    inline long long gcd(long long a, long long b) {
+        if (a < 0) a = -a;
+        if (b < 0) b = -b;
+        while (b != 0) {
+            long long t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+}
+
+BigInt::BigInt(long long v) {
+    neg = v < 0;
+    unsigned long long m = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    while (m != 0) {
+        mag.push_back(uint32_t(m));
+        m >>= 32;
+    }
+}
+
+void BigInt::trim() {
+    while (!mag.empty() && mag.back() == 0) mag.pop_back();
+    if (mag.empty()) neg = false;
+}
+
+bool BigInt::fitsLong() const {
+    if (mag.size() > 2) return false;
+    unsigned long long m = 0;
+    for (size_t i = mag.size(); i-- > 0;) m = (m << 32) | mag[i];
+    return m <= (unsigned long long)LLONG_MAX;
+}
+
+long long BigInt::toLong() const {
+    unsigned long long m = 0;
+    for (size_t i = mag.size(); i-- > 0;) m = (m << 32) | mag[i];
+    return neg ? -(long long)m : (long long)m;
+}
+
+double BigInt::toDouble() const {
+    double v = 0.0;
+    for (size_t i = mag.size(); i-- > 0;) v = v * 4294967296.0 + mag[i];
+    return neg ? -v : v;
+}
+
+std::string BigInt::toString() const {
+    if (mag.empty()) return "0";
+    // peel off 9 decimal digits at a time
+    std::vector<uint32_t> m = mag;
+    std::string digits;
+    while (!m.empty()) {
+        unsigned long long rem = 0;
+        for (size_t i = m.size(); i-- > 0;) {
+            unsigned long long cur = (rem << 32) | m[i];
+            m[i] = uint32_t(cur / 1000000000ULL);
+            rem = cur % 1000000000ULL;
+        }
+        while (!m.empty() && m.back() == 0) m.pop_back();
+        for (int k = 0; k < 9 && (!m.empty() || rem != 0); k++) {
+            digits.push_back(char('0' + rem % 10));
+            rem /= 10;
+        }
+    }
+    if (neg) digits.push_back('-');
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+int BigInt::compareMag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+int BigInt::compare(const BigInt& other) const {
+    if (neg != other.neg) return neg ? -1 : 1;
+    int c = compareMag(mag, other.mag);
+    return neg ? -c : c;
+}
+
+std::vector<uint32_t> BigInt::addMag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    std::vector<uint32_t> r;
+    r.reserve(std::max(a.size(), b.size()) + 1);
+    unsigned long long carry = 0;
+    for (size_t i = 0; i < std::max(a.size(), b.size()); i++) {
+        unsigned long long s = carry;
+        if (i < a.size()) s += a[i];
+        if (i < b.size()) s += b[i];
+        r.push_back(uint32_t(s));
+        carry = s >> 32;
+    }
+    if (carry) r.push_back(uint32_t(carry));
+    return r;
+}
+
+std::vector<uint32_t> BigInt::subMag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    std::vector<uint32_t> r(a.size());
+    long long borrow = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        long long d = (long long)a[i] - borrow - (i < b.size() ? (long long)b[i] : 0);
+        borrow = d < 0;
+        r[i] = uint32_t(d + (borrow << 32));
+    }
+    while (!r.empty() && r.back() == 0) r.pop_back();
+    return r;
+}
+
+std::vector<uint32_t> BigInt::shiftLeft(const std::vector<uint32_t>& a, int bits) {
+    if (bits == 0) return a;
+    std::vector<uint32_t> r(a.size());
+    uint32_t carry = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        r[i] = a[i] << bits | carry;
+        carry = a[i] >> (32 - bits);
+    }
+    if (carry) r.push_back(carry);
+    return r;
+}
+
+std::vector<uint32_t> BigInt::shiftRight(const std::vector<uint32_t>& a, int bits) {
+    std::vector<uint32_t> r(a);
+    if (bits > 0) {
+        for (size_t i = 0; i < r.size(); i++) {
+            r[i] = a[i] >> bits | (i + 1 < a.size() ? a[i + 1] << (32 - bits) : 0U);
+        }
+    }
+    while (!r.empty() && r.back() == 0) r.pop_back();
+    return r;
+}
+
+BigInt BigInt::operator-() const {
+    BigInt r = *this;
+    if (!r.mag.empty()) r.neg = !r.neg;
+    return r;
+}
+
+BigInt BigInt::abs() const {
+    BigInt r = *this;
+    r.neg = false;
+    return r;
+}
+
+BigInt operator+(const BigInt& a, const BigInt& b) {
+    BigInt r;
+    if (a.neg == b.neg) {
+        r.mag = BigInt::addMag(a.mag, b.mag);
+        r.neg = a.neg;
+    }
+    else if (BigInt::compareMag(a.mag, b.mag) >= 0) {
+        r.mag = BigInt::subMag(a.mag, b.mag);
+        r.neg = a.neg;
+    }
+    else {
+        r.mag = BigInt::subMag(b.mag, a.mag);
+        r.neg = b.neg;
+    }
+    r.trim();
+    return r;
+}
+
+BigInt operator-(const BigInt& a, const BigInt& b) {
+    return a + (-b);
+}
+
+BigInt operator*(const BigInt& a, const BigInt& b) {
+    BigInt r;
+    if (a.isZero() || b.isZero()) return r;
+    r.mag.assign(a.mag.size() + b.mag.size(), 0);
+    for (size_t i = 0; i < a.mag.size(); i++) {
+        unsigned long long carry = 0;
+        for (size_t j = 0; j < b.mag.size(); j++) {
+            unsigned long long cur = r.mag[i + j] + (unsigned long long)a.mag[i] * b.mag[j] + carry;
+            r.mag[i + j] = uint32_t(cur);
+            carry = cur >> 32;
+        }
+        r.mag[i + b.mag.size()] += uint32_t(carry);
+    }
+    r.neg = a.neg != b.neg;
+    r.trim();
+    return r;
+}
+
+void BigInt::divMod(const BigInt& a, const BigInt& b, BigInt& quotient, BigInt& remainder) {
+    assert(!b.isZero() && "division by zero");
+    BigInt q, r;
+    if (b.mag.size() == 1) {
+        // single limb divisor, the common case after gcd reduction
+        unsigned long long d = b.mag[0], rem = 0;
+        q.mag.resize(a.mag.size());
+        for (size_t i = a.mag.size(); i-- > 0;) {
+            unsigned long long cur = (rem << 32) | a.mag[i];
+            q.mag[i] = uint32_t(cur / d);
+            rem = cur % d;
+        }
+        r = BigInt((long long)rem);
+    }
+    else if (a.mag.size() >= b.mag.size()) {
+        // schoolbook long division (Knuth's algorithm D), a limb of the quotient per step.
+        // Both sides are shifted so the divisor's top bit is set; then the guess from the
+        // top two limbs is at most 2 too big and the next divisor limb nearly always fixes it
+        int shift = 0;
+        while (!(b.mag.back() << shift & 0x80000000U)) shift++;
+        std::vector<uint32_t> v = shiftLeft(b.mag, shift);
+        std::vector<uint32_t> u = shiftLeft(a.mag, shift);
+        if (u.size() == a.mag.size()) u.push_back(0);
+        const size_t n = v.size();
+        const unsigned long long base = 1ULL << 32;
+        q.mag.assign(u.size() - n, 0);
+        for (size_t j = u.size() - n; j-- > 0;) {
+            unsigned long long top = (unsigned long long)u[j + n] << 32 | u[j + n - 1];
+            unsigned long long guess = top / v[n - 1], rest = top % v[n - 1];
+            while (guess >= base || guess * v[n - 2] > (rest << 32 | u[j + n - 2])) {
+                guess--;
+                rest += v[n - 1];
+                if (rest >= base) break;
+            }
+            // u[j..j+n] -= guess * v
+            long long borrow = 0;
+            unsigned long long carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                unsigned long long p = guess * v[i] + carry;
+                carry = p >> 32;
+                long long t = (long long)u[i + j] - borrow - (long long)uint32_t(p);
+                u[i + j] = uint32_t(t);
+                borrow = t < 0;
+            }
+            long long t = (long long)u[j + n] - borrow - (long long)carry;
+            u[j + n] = uint32_t(t);
+            if (t < 0) {
+                // the guess was one too big, rare enough that adding v back is cheap
+                guess--;
+                carry = 0;
+                for (size_t i = 0; i < n; i++) {
+                    unsigned long long sum = (unsigned long long)u[i + j] + v[i] + carry;
+                    u[i + j] = uint32_t(sum);
+                    carry = sum >> 32;
+                }
+                u[j + n] += uint32_t(carry);
+            }
+            q.mag[j] = uint32_t(guess);
+        }
+        u.resize(n);
+        r.mag = shiftRight(u, shift);
+    }
+    else {
+        r = a;
+    }
+    q.neg = a.neg != b.neg;
+    q.trim();
+    r.neg = a.neg;
+    r.trim();
+    quotient = q;
+    remainder = r;
+}
+
+BigInt BigInt::gcd(BigInt a, BigInt b) {
+    a = a.abs();
+    b = b.abs();
+    while (!b.isZero()) {
+        BigInt q, r;
+        divMod(a, b, q, r);
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+Rational::Rational(long long n) : num(n) {
+    if (n == LLONG_MIN) *this = fromBig(BigInt(n), BigInt(1));
+}
+
+Rational::Rational(long long n, long long d) {
+    assert(d != 0 && "zero denominator");
+    if (n == LLONG_MIN || d == LLONG_MIN) {
+        *this = fromBig(BigInt(n), BigInt(d));
+        return;
+    }
+    if (d < 0) {
+        n = -n;
+        d = -d;
+    }
+    long long g = gcd(n, d);
+    num = g > 1 ? n / g : n;
+    den = g > 1 ? d / g : d;
+}
+
+Rational Rational::fromBig(BigInt n, BigInt d) {
+    if (d.negative()) {
+        n = -n;
+        d = -d;
+    }
+    BigInt g = BigInt::gcd(n, d);
+    if (g.compare(BigInt(1)) != 0) {
+        BigInt rest;
+        BigInt::divMod(n, g, n, rest);
+        BigInt::divMod(d, g, d, rest);
+    }
+    Rational r;
+    if (n.fitsLong() && d.fitsLong()) {
+        r.num = n.toLong();
+        r.den = d.toLong();
+        return r;
+    }
+    std::shared_ptr<Big> b = std::make_shared<Big>();
+    b->num = n;
+    b->den = d;
+    r.big = b;
+    return r;
+}
+
+bool Rational::isInteger() const {
+    return big ? big->den.compare(BigInt(1)) == 0 : den == 1;
+}
+
+int Rational::sign() const {
+    if (big) return big->num.negative() ? -1 : 1;
+    return num < 0 ? -1 : (num > 0 ? 1 : 0);
+}
+
+double Rational::toDouble() const {
+    if (big) return big->num.toDouble() / big->den.toDouble();
+    return double(num) / double(den);
+}
+
+std::string Rational::toString() const {
+    if (big) {
+        std::string s = big->num.toString();
+        return isInteger() ? s : s + "/" + big->den.toString();
+    }
+    return den == 1 ? std::to_string(num) : std::to_string(num) + "/" + std::to_string(den);
+}
+
+const Expr* Rational::toExpr(ExprArena& arena) const {
+    // doubles hold integers exactly only up to 2^53
+    const long long exact = 1LL << 53;
+    if (big || num > exact || num < -exact || den > exact) return arena.constant(toDouble());
+    if (den == 1) return arena.constant(double(num));
+    const Expr* fraction = arena.div(arena.constant(double(num < 0 ? -num : num)), arena.constant(double(den)));
+    return num < 0 ? arena.neg(fraction) : fraction;
+}
+
+const Expr* Rational::combination(ExprArena& arena, const std::vector<Rational>& k, const std::vector<const Expr*>& f) {
+    std::vector<const Expr*> terms;
+    for (size_t i = 0; i < k.size(); i++) {
+        if (k[i] == 0) continue;
+        Rational magnitude = k[i].sign() < 0 ? -k[i] : k[i];
+        const Expr* scaled = !f[i] ? magnitude.toExpr(arena) : magnitude == 1 ? f[i] : arena.mul({ magnitude.toExpr(arena), f[i] });
+        terms.push_back(k[i].sign() < 0 ? arena.neg(scaled) : scaled);
+    }
+    return terms.empty() ? arena.constant(0) : terms.size() == 1 ? terms[0] : arena.add(terms);
+}
+
+Rational Rational::operator-() const {
+    if (big) return fromBig(-big->num, big->den);
+    Rational r = *this;
+    r.num = -num;
+    return r;
+}
+
+Rational operator+(const Rational& a, const Rational& b) {
+    if (!a.big && !b.big) {
+        // a/b + c/d = (a (d/g) + c (b/g)) / (b (d/g)) with g = gcd(b, d)
+        long long g = gcd(a.den, b.den);
+        long long x, y, n, d;
+        if (!mulOverflows(a.num, b.den / g, x) && !mulOverflows(b.num, a.den / g, y) &&
+            !addOverflows(x, y, n) && !mulOverflows(a.den, b.den / g, d)) {
+            return Rational(n, d);
+        }
+    }
+    return Rational::fromBig(a.bigNum() * b.bigDen() + b.bigNum() * a.bigDen(), a.bigDen() * b.bigDen());
+}
+
+Rational operator-(const Rational& a, const Rational& b) {
+    return a + (-b);
+}
+
+Rational operator*(const Rational& a, const Rational& b) {
+    if (!a.big && !b.big) {
+        // cross-cancel first so the products stay small and already reduced
+        long long g1 = gcd(a.num, b.den), g2 = gcd(b.num, a.den);
+        if (g1 == 0) g1 = 1;
+        if (g2 == 0) g2 = 1;
+        long long n, d;
+        if (!mulOverflows(a.num / g1, b.num / g2, n) && !mulOverflows(a.den / g2, b.den / g1, d)) {
+            Rational r;
+            r.num = n;
+            r.den = n == 0 ? 1 : d;
+            return r;
+        }
+    }
+    return Rational::fromBig(a.bigNum() * b.bigNum(), a.bigDen() * b.bigDen());
+}
+
+Rational operator/(const Rational& a, const Rational& b) {
+    assert(b != 0 && "division by zero");
+    if (!b.big) return a * Rational(b.den, b.num);
+    return a * Rational::fromBig(b.big->den, b.big->num);
+}
+
+bool operator==(const Rational& a, const Rational& b) {
+    // both sides are in lowest terms, so equal values have equal parts
+    if (!a.big && !b.big) return a.num == b.num && a.den == b.den;
+    return a.bigNum().compare(b.bigNum()) == 0 && a.bigDen().compare(b.bigDen()) == 0;
+}
+
+bool operator<(const Rational& a, const Rational& b) {
+    if (!a.big && !b.big) {
+        long long x, y;
+        if (!mulOverflows(a.num, b.den, x) && !mulOverflows(b.num, a.den, y)) return x < y;
+    }
+    return (a.bigNum() * b.bigDen()).compare(b.bigNum() * a.bigDen()) < 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Expr.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Arbitrary precision integer, only reached when a Rational overflows 64 bits
+class BigInt {
+public:
+    BigInt(long long v = 0);
+
+    bool isZero() const { return mag.empty(); }
+    bool negative() const { return neg; }
+    // true when the value fits a long long other than LLONG_MIN
+    bool fitsLong() const;
+    long long toLong() const;
+    double toDouble() const;
+    std::string toString() const;
+
+    int compare(const BigInt& other) const;
+    BigInt operator-() const;
+    BigInt abs() const;
+    friend BigInt operator+(const BigInt& a, const BigInt& b);
+    friend BigInt operator-(const BigInt& a, const BigInt& b);
+    friend BigInt operator*(const BigInt& a, const BigInt& b);
+    // truncating division, the remainder takes the sign of a; b must not be zero
+    static void divMod(const BigInt& a, const BigInt& b, BigInt& quotient, BigInt& remainder);
+    static BigInt gcd(BigInt a, BigInt b);
+
+private:
+    std::vector<uint32_t> mag; // magnitude, least significant limb first, no leading zeros
+    bool neg = false;
+
+    void trim();
+    static int compareMag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+    static std::vector<uint32_t> addMag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+    // a - b for |a| >= |b|
+    static std::vector<uint32_t> subMag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+    // magnitudes shifted by 0..31 bits
+    static std::vector<uint32_t> shiftLeft(const std::vector<uint32_t>& a, int bits);
+    static std::vector<uint32_t> shiftRight(const std::vector<uint32_t>& a, int bits);
+};
+
+// Exact fraction in lowest terms with a positive denominator. Values live in two
+// long longs and only move to BigInt when an operation would overflow; results that
+// fit again drop back to the fast path
+class Rational {
+public:
+    Rational(long long n = 0);
+    // d must not be zero, nor may the divisor of operator/
+    Rational(long long n, long long d);
+
+    bool isBig() const { return big != nullptr; }
+    bool isInteger() const;
+    int sign() const;
+    double toDouble() const;
+    // "3", "-5/2"
+    std::string toString() const;
+    // constant, or num/den for a fraction the way ExprFormat prints coefficients
+    const Expr* toExpr(ExprArena& arena) const;
+    // sum of k_i f_i with unit coefficients dropped and negative ones written as a minus,
+    // a null f stands for 1
+    static const Expr* combination(ExprArena& arena, const std::vector<Rational>& k, const std::vector<const Expr*>& f);
+
+    friend Rational operator+(const Rational& a, const Rational& b);
+    friend Rational operator-(const Rational& a, const Rational& b);
+    friend Rational operator*(const Rational& a, const Rational& b);
+    friend Rational operator/(const Rational& a, const Rational& b);
+    Rational operator-() const;
+    Rational& operator+=(const Rational& b) { return *this = *this + b; }
+    Rational& operator-=(const Rational& b) { return *this = *this - b; }
+    Rational& operator*=(const Rational& b) { return *this = *this * b; }
+    Rational& operator/=(const Rational& b) { return *this = *this / b; }
+    friend bool operator==(const Rational& a, const Rational& b);
+    friend bool operator!=(const Rational& a, const Rational& b) { return !(a == b); }
+    friend bool operator<(const Rational& a, const Rational& b);
+
+private:
+    struct Big {
+        BigInt num, den;
+    };
+
+    long long num = 0, den = 1;
+    std::shared_ptr<const Big> big; // set only when the value doesn't fit num and den
+
+    BigInt bigNum() const { return big ? big->num : BigInt(num); }
+    BigInt bigDen() const { return big ? big->den : BigInt(den); }
+    // reduces n/d and drops back to long longs when they fit
+    static Rational fromBig(BigInt n, BigInt d);
+};
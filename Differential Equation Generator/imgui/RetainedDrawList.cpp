@@ -0,0 +1,160 @@
+#include "RetainedDrawList.h"
+
+#include "imgui_internal.h"
+
+#include <cstring>
+
+bool RetainedDrawList::Interaction::operator==(const Interaction& other) const {
+    return activeId == other.activeId && navId == other.navId && focused == other.focused &&
+        navVisible == other.navVisible && overItem == other.overItem &&
+        (!overItem || (mouse.x == other.mouse.x && mouse.y == other.mouse.y && buttons == other.buttons));
+}
+
+void RetainedDrawList::buildKey(const void* state, size_t size) {
+    ImGuiContext& g = *GImGui;
+    ImGuiWindow* window = g.CurrentWindow;
+    Layout layout;
+    // zeroed first so padding compares equal too
+    std::memset(static_cast<void*>(&layout), 0, sizeof(layout));
+    layout.window = window->ID;
+    layout.pos = window->Pos;
+    layout.size = window->Size;
+    layout.scroll = window->Scroll;
+    layout.cursor = window->DC.CursorPos;
+    layout.clipRect = window->DrawList->_CmdHeader.ClipRect;
+    layout.font = g.Font;
+    layout.fontSize = g.FontSize;
+
+    current.resize(size + sizeof(Layout) + sizeof(ImGuiStyle));
+    std::memcpy(current.data(), state, size);
+    std::memcpy(current.data() + size, &layout, sizeof(Layout));
+    std::memcpy(current.data() + size + sizeof(Layout), &g.Style, sizeof(ImGuiStyle));
+}
+
+RetainedDrawList::Interaction RetainedDrawList::currentInteraction() const {
+    ImGuiContext& g = *GImGui;
+    Interaction result = {};
+    result.activeId = g.ActiveId;
+    result.focused = g.NavWindow == g.CurrentWindow;
+    result.navId = result.focused ? g.NavId : 0;
+    result.navVisible = result.focused && g.NavCursorVisible;
+    // outside every item rect nothing in the body can be hovered, wherever the mouse is
+    if (ImGui::IsWindowHovered()) {
+        for (const ImVec4& r : items) {
+            if (g.IO.MousePos.x >= r.x && g.IO.MousePos.y >= r.y && g.IO.MousePos.x < r.z && g.IO.MousePos.y < r.w) {
+                result.overItem = true;
+                result.mouse = g.IO.MousePos;
+                for (int button = 0; button < ImGuiMouseButton_COUNT; button++) {
+                    if (g.IO.MouseDown[button]) result.buttons |= 1 << button;
+                }
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+bool RetainedDrawList::keyboardPending() {
+    ImGuiContext& g = *GImGui;
+    if (g.NavWindow != g.CurrentWindow) return false;
+    if (g.NavInitRequest || g.NavMoveSubmitted || g.NavActivateId != 0 || g.IO.InputQueueCharacters.Size > 0) return true;
+    for (int key = ImGuiKey_NamedKey_BEGIN; key < ImGuiKey_NamedKey_END; key++) {
+        if (ImGui::IsKeyDown((ImGuiKey)key)) return true;
+    }
+    return false;
+}
+
+bool RetainedDrawList::replay(const void* state, size_t size) {
+    ImGuiContext& g = *GImGui;
+    ImGuiWindow* window = g.CurrentWindow;
+#ifdef IMGUI_ENABLE_TEST_ENGINE
+    // a test engine is collecting items, and only submitted widgets report theirs
+    if (g.TestEngineHookItems) return false;
+#endif
+    buildKey(state, size);
+    bool hit = valid && !window->SkipItems && current == key && currentInteraction() == interaction &&
+        !(g.ActiveId != 0 && g.ActiveIdWindow == window) && !keyboardPending();
+    if (!hit) return false;
+
+    ImDrawList* list = window->DrawList;
+    size_t next = 0;
+    unsigned int base = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        const Segment& s = segments[i];
+        list->PushClipRect(ImVec2(s.clipRect.x, s.clipRect.y), ImVec2(s.clipRect.z, s.clipRect.w));
+        list->PushTextureID(s.texture);
+        int vertexCount = i == 0 ? (int)vertices.size() : 0;
+        list->PrimReserve((int)s.elemCount, vertexCount);
+        if (i == 0) {
+            // after the reserve, which may have started a new VtxOffset past 64K vertices
+            base = list->_VtxCurrentIdx;
+            std::memcpy(list->_VtxWritePtr, vertices.data(), vertices.size() * sizeof(ImDrawVert));
+            list->_VtxWritePtr += vertexCount;
+            list->_VtxCurrentIdx += vertexCount;
+        }
+        for (unsigned int k = 0; k < s.elemCount; k++) {
+            list->_IdxWritePtr[k] = (ImDrawIdx)(indices[next + k] + base);
+        }
+        list->_IdxWritePtr += s.elemCount;
+        next += s.elemCount;
+        list->PopTextureID();
+        list->PopClipRect();
+    }
+    // the content size comes from the cursor, as if the widgets had been submitted
+    window->DC.CursorPos = cursor;
+    window->DC.CursorMaxPos = cursorMax;
+    window->DC.IdealMaxPos = idealMax;
+    window->DC.CursorPosPrevLine = prevLine;
+    return true;
+}
+
+void RetainedDrawList::record() {
+    ImDrawList* list = GImGui->CurrentWindow->DrawList;
+    startVtx = list->VtxBuffer.Size;
+    startIdx = list->IdxBuffer.Size;
+    items.clear();
+    recording = true;
+}
+
+void RetainedDrawList::item() {
+    if (!recording) return;
+    const ImRect& r = GImGui->LastItemData.Rect;
+    items.push_back(ImVec4(r.Min.x, r.Min.y, r.Max.x, r.Max.y));
+}
+
+void RetainedDrawList::commit() {
+    ImGuiWindow* window = GImGui->CurrentWindow;
+    ImDrawList* list = window->DrawList;
+    recording = false;
+    valid = false;
+    // nothing was drawn, and the next frame may well draw
+    if (window->SkipItems) return;
+    vertices.assign(list->VtxBuffer.Data + startVtx, list->VtxBuffer.Data + list->VtxBuffer.Size);
+    indices.clear();
+    segments.clear();
+    // commands may have merged with the one open before record(), so segments are cut by
+    // index range rather than by command
+    int first = list->CmdBuffer.Size;
+    while (first > 0 && (int)(list->CmdBuffer[first - 1].IdxOffset + list->CmdBuffer[first - 1].ElemCount) > startIdx) first--;
+    for (int c = first; c < list->CmdBuffer.Size; c++) {
+        const ImDrawCmd& cmd = list->CmdBuffer[c];
+        if (cmd.UserCallback != nullptr) return;
+        int begin = cmd.IdxOffset > (unsigned int)startIdx ? (int)cmd.IdxOffset : startIdx;
+        int end = (int)(cmd.IdxOffset + cmd.ElemCount);
+        if (end <= begin) continue;
+        for (int k = begin; k < end; k++) {
+            long long vertex = (long long)list->IdxBuffer[k] + cmd.VtxOffset - startVtx;
+            // only vertices of the body itself can be replayed
+            if (vertex < 0 || vertex >= (long long)vertices.size()) return;
+            indices.push_back((unsigned int)vertex);
+        }
+        segments.push_back({ cmd.ClipRect, cmd.TextureId, (unsigned int)(end - begin) });
+    }
+    cursor = window->DC.CursorPos;
+    cursorMax = window->DC.CursorMaxPos;
+    idealMax = window->DC.IdealMaxPos;
+    prevLine = window->DC.CursorPosPrevLine;
+    key.swap(current);
+    interaction = currentInteraction();
+    valid = true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <cstddef>
+#include <vector>
+
+// Keeps what a window body drew and appends it to the window's draw list again on later
+// frames while nothing it depends on has changed: the caller's state, the window's place
+// and style, and the mouse and keyboard as far as they reach the body's widgets. Widgets
+// aren't submitted on those frames, so this only suits bodies that change with their
+// state and with hovering, clicking and keyboard navigation, nothing else.
+//
+//     if (!cache.replay(&state, sizeof(state))) {
+//         cache.record();
+//         ImGui::Button("Go"); cache.item();
+//         cache.commit();
+//     }
+class RetainedDrawList {
+public:
+    // between Begin() and End(); true when the last recording was appended, false when the
+    // body has to be submitted between record() and commit()
+    bool replay(const void* state, size_t size);
+    void record();
+    // after each widget the mouse can interact with, so hovering it redraws the body
+    void item();
+    void commit();
+    void invalidate() { valid = false; }
+
+private:
+    // where the body starts and what it looks like, compared byte for byte
+    struct Layout {
+        ImGuiID window;
+        ImVec2 pos, size, scroll, cursor;
+        ImVec4 clipRect;
+        const ImFont* font;
+        float fontSize;
+    };
+    // the part of the input the body's widgets see
+    struct Interaction {
+        ImGuiID activeId, navId;
+        bool focused, navVisible;
+        bool overItem;          // mouse inside one of the item rects
+        ImVec2 mouse;           // these two only while it is
+        int buttons;
+
+        bool operator==(const Interaction& other) const;
+    };
+    struct Segment {
+        ImVec4 clipRect;
+        ImTextureID texture;
+        unsigned int elemCount;
+    };
+
+    bool valid = false, recording = false;
+    std::vector<char> key, current;       // state, Layout and ImGuiStyle bytes
+    Interaction interaction = {};
+    std::vector<ImVec4> items;
+    std::vector<ImDrawVert> vertices;
+    std::vector<unsigned int> indices;    // relative to the first recorded vertex
+    std::vector<Segment> segments;
+    ImVec2 cursor, cursorMax, idealMax, prevLine;
+    int startVtx = 0, startIdx = 0;
+
+    void buildKey(const void* state, size_t size);
+    Interaction currentInteraction() const;
+    // keys, characters and navigation requests that the skipped widgets would have handled
+    static bool keyboardPending();
+};
@@ -0,0 +1,232 @@
+#include "Series.h"
+
+#include <cmath>
+
+namespace {
+
+    // out[0..2m-1) += a[0..m) * b[0..m)
+    void schoolbook(const double* a, const double* b, int m, double* out) {
+        for (int i = 0; i < m; i++) {
+            if (a[i] == 0.0) continue;
+            for (int j = 0; j < m; j++) out[i + j] += a[i] * b[j];
+        }
+    }
+
+    // out[0..2m-1) = a[0..m) * b[0..m)
+    void karatsuba(const double* a, const double* b, int m, double* out) {
+        std::fill(out, out + 2 * m - 1, 0.0);
+        if (m <= PowerSeries::KaratsubaThreshold) {
+            schoolbook(a, b, m, out);
+            return;
+        }
+        // a = a0 + x^h a1 with len(a0) = h <= len(a1) = m - h
+        int h = m / 2, hi = m - h;
+        std::vector<double> z0(2 * h - 1), z1(2 * hi - 1), z2(2 * hi - 1);
+        std::vector<double> sa(a + h, a + m), sb(b + h, b + m);
+        for (int i = 0; i < h; i++) {
+            sa[i] += a[i];
+            sb[i] += b[i];
+        }
+        karatsuba(a, b, h, z0.data());
+        karatsuba(a + h, b + h, hi, z2.data());
+        karatsuba(sa.data(), sb.data(), hi, z1.data());
+        // (a0 + a1)(b0 + b1) - a0 b0 - a1 b1 is the middle term
+        for (int i = 0; i < 2 * h - 1; i++) z1[i] -= z0[i];
+        for (int i = 0; i < 2 * hi - 1; i++) z1[i] -= z2[i];
+        for (int i = 0; i < 2 * h - 1; i++) out[i] += z0[i];
+        for (int i = 0; i < 2 * hi - 1; i++) out[h + i] += z1[i];
+        for (int i = 0; i < 2 * hi - 1; i++) out[2 * h + i] += z2[i];
+    }
+
+    // CDQ solver for sum over k of A_k T2_(n-k) + B_k T1_(n-k) + C_k a_(n-k) = 0, where
+    // T2_m = (m+r)(m+r-1)a_m and T1_m = (m+r)a_m. The left half of a range is solved
+    // first, then its terms are pushed into the right half with one product per coefficient
+    struct OnlineRecurrence {
+        const std::vector<double>& A;
+        const std::vector<double>& B;
+        const std::vector<double>& C;
+        double r;
+        std::vector<double>& a;
+        std::vector<double> t2, t1, pending;
+        bool ok;
+
+        // a_n from everything pushed into pending[n]
+        bool finish(int n) {
+            double e = n + r;
+            if (n == 0) {
+                a[0] = 1.0;
+            }
+            else {
+                double pivot = A[0] * e * (e - 1.0) + B[0] * e + C[0];
+                if (std::fabs(pivot) < 1e-12 * (std::fabs(A[0]) * e * e + std::fabs(B[0] * e) + std::fabs(C[0]) + 1.0)) {
+                    return false;
+                }
+                a[n] = -pending[n] / pivot;
+            }
+            t2[n] = e * (e - 1.0) * a[n];
+            t1[n] = e * a[n];
+            return true;
+        }
+
+        void run(int lo, int hi) {
+            if (!ok) return;
+            if (hi - lo <= PowerSeries::KaratsubaThreshold) {
+                // small ranges term by term, products wouldn't pay off here
+                for (int n = lo; n < hi; n++) {
+                    if (!(ok = finish(n))) return;
+                    for (int m = n + 1; m < hi; m++) {
+                        pending[m] += A[m - n] * t2[n] + B[m - n] * t1[n] + C[m - n] * a[n];
+                    }
+                }
+                return;
+            }
+            int mid = (lo + hi) / 2;
+            run(lo, mid);
+            if (!ok) return;
+            // sources m in [lo, mid) reach targets n in [mid, hi) through k = n - m >= 1
+            int len = hi - lo;
+            std::vector<double> k2(A.begin(), A.begin() + len), k1(B.begin(), B.begin() + len), k0(C.begin(), C.begin() + len);
+            // polynomial coefficients end early, which keeps their products on the short path
+            for (std::vector<double>* k : { &k2, &k1, &k0 }) {
+                while (!k->empty() && k->back() == 0.0) k->pop_back();
+            }
+            std::vector<double> s2(t2.begin() + lo, t2.begin() + mid), s1(t1.begin() + lo, t1.begin() + mid), s0(a.begin() + lo, a.begin() + mid);
+            std::vector<double> p2 = PowerSeries::multiply(k2, s2, len);
+            std::vector<double> p1 = PowerSeries::multiply(k1, s1, len);
+            std::vector<double> p0 = PowerSeries::multiply(k0, s0, len);
+            for (int n = mid; n < hi; n++) pending[n] += p2[n - lo] + p1[n - lo] + p0[n - lo];
+            run(mid, hi);
+        }
+    };
+}
+
+std::vector<double> PowerSeries::multiply(const std::vector<double>& a, const std::vector<double>& b, int n) {
+    std::vector<double> out(n > 0 ? n : 0, 0.0);
+    int la = std::min((int)a.size(), n), lb = std::min((int)b.size(), n);
+    if (la == 0 || lb == 0) return out;
+    if (std::min(la, lb) <= KaratsubaThreshold) {
+        // short operand, e.g. an equation coefficient times a long series
+        for (int i = 0; i < la; i++) {
+            if (a[i] == 0.0) continue;
+            for (int j = 0; j < lb && i + j < n; j++) out[i + j] += a[i] * b[j];
+        }
+        return out;
+    }
+    int m = std::max(la, lb);
+    std::vector<double> pa(a.begin(), a.begin() + la), pb(b.begin(), b.begin() + lb), full(2 * m - 1);
+    pa.resize(m, 0.0);
+    pb.resize(m, 0.0);
+    karatsuba(pa.data(), pb.data(), m, full.data());
+    for (int i = 0; i < n && i < 2 * m - 1; i++) out[i] = full[i];
+    return out;
+}
+
+std::vector<double> PowerSeries::inverse(const std::vector<double>& a, int n) {
+    std::vector<double> g(1, 1.0 / a[0]);
+    // each step doubles the number of correct terms
+    for (int m = 1; m < n;) {
+        m = std::min(2 * m, n);
+        std::vector<double> e = multiply(a, g, m);
+        for (double& v : e) v = -v;
+        e[0] += 2.0;
+        g = multiply(g, e, m);
+    }
+    g.resize(n > 0 ? n : 0, 0.0);
+    return g;
+}
+
+std::vector<double> PowerSeries::divide(const std::vector<double>& a, const std::vector<double>& b, int n) {
+    return multiply(a, inverse(b, n), n);
+}
+
+std::vector<double> PowerSeries::compose(const std::vector<double>& a, const std::vector<double>& b, int n) {
+    std::vector<double> out(n > 0 ? n : 0, 0.0);
+    if (a.empty() || n <= 0) return out;
+    // baby steps b^0 .. b^k, then Horner in b^k over blocks of k coefficients of a
+    int k = (int)std::ceil(std::sqrt((double)a.size()));
+    std::vector<std::vector<double>> powers(1, std::vector<double>(n, 0.0));
+    powers[0][0] = 1.0;
+    for (int j = 1; j <= k; j++) powers.push_back(multiply(powers.back(), b, n));
+    int blocks = ((int)a.size() + k - 1) / k;
+    for (int block = blocks - 1; block >= 0; block--) {
+        if (block != blocks - 1) out = multiply(out, powers[k], n);
+        for (int j = 0; j < k && block * k + j < (int)a.size(); j++) {
+            double c = a[block * k + j];
+            if (c == 0.0) continue;
+            for (int i = 0; i < n; i++) out[i] += c * powers[j][i];
+        }
+    }
+    return out;
+}
+
+bool FrobeniusSolver::solve(const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& C, double r, int terms, std::vector<double>& a) {
+    a.assign(terms > 0 ? terms : 0, 0.0);
+    if (terms <= 0) return true;
+    // solved in u = x / rho, which leaves x d/dx alone and only scales coefficient k by rho^k.
+    // The scaled terms are of similar size, so Karatsuba's cancellation stays harmless
+    double rho = scaleFor(A, B, C, terms);
+    std::vector<double> sA = scaled(A, rho, terms), sB = scaled(B, rho, terms), sC = scaled(C, rho, terms);
+    OnlineRecurrence solver = { sA, sB, sC, r, a, std::vector<double>(terms), std::vector<double>(terms), std::vector<double>(terms, 0.0), true };
+    solver.run(0, terms);
+    double w = 1.0;
+    for (int n = 0; n < terms; n++, w /= rho) a[n] *= w;
+    return solver.ok;
+}
+
+double FrobeniusSolver::residual(const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& C, double r, const std::vector<double>& a) {
+    // x^(-r) L[y] = A T2 + B T1 + C a with T2_n = (n+r)(n+r-1)a_n and T1_n = (n+r)a_n.
+    // Coefficients below a.size() only involve known terms, so all of them have to vanish.
+    // Measured on |x| = rho like solve(), relative to the largest term
+    int n = (int)a.size();
+    double rho = scaleFor(A, B, C, n);
+    std::vector<double> sA = scaled(A, rho, n), sB = scaled(B, rho, n), sC = scaled(C, rho, n), sa = scaled(a, rho, n);
+    std::vector<double> t2(n), t1(n), absA(n), absB(n), absC(n), a2(n), a1(n), a0(n);
+    for (int i = 0; i < n; i++) {
+        double e = i + r;
+        t2[i] = e * (e - 1.0) * sa[i];
+        t1[i] = e * sa[i];
+        a2[i] = std::fabs(t2[i]);
+        a1[i] = std::fabs(t1[i]);
+        a0[i] = std::fabs(sa[i]);
+        absA[i] = std::fabs(sA[i]);
+        absB[i] = std::fabs(sB[i]);
+        absC[i] = std::fabs(sC[i]);
+    }
+
+    std::vector<double> L2 = PowerSeries::multiply(sA, t2, n), L1 = PowerSeries::multiply(sB, t1, n), L0 = PowerSeries::multiply(sC, sa, n);
+    std::vector<double> S2 = PowerSeries::multiply(absA, a2, n), S1 = PowerSeries::multiply(absB, a1, n), S0 = PowerSeries::multiply(absC, a0, n);
+    double worst = 0.0, scale = 0.0;
+    for (int i = 0; i < n; i++) {
+        worst = std::max(worst, std::fabs(L2[i] + L1[i] + L0[i]));
+        scale = std::max(scale, S2[i] + S1[i] + S0[i]);
+    }
+    return scale == 0.0 ? 0.0 : worst / scale;
+}
+
+double FrobeniusSolver::scaleFor(const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& C, int terms) {
+    // root test |c_n|^(-1/n) on the last coefficient of 1/A, B and C. Polynomial B and C
+    // end early and don't limit it; entire solutions are left at rho = 1
+    double rho = 1.0;
+    std::vector<double> inv = PowerSeries::inverse(A, terms);
+    const std::vector<double>* series[] = { &inv, &B, &C };
+    for (const std::vector<double>* c : series) {
+        int last = std::min((int)c->size(), terms) - 1;
+        if (last < 1 || (*c)[last] == 0.0 || (int)c->size() < terms) continue;
+        rho = std::min(rho, std::pow(std::fabs((*c)[last]) / std::fabs((*c)[0] != 0.0 ? (*c)[0] : 1.0), -1.0 / last));
+    }
+    return rho;
+}
+
+std::vector<double> FrobeniusSolver::scaled(const std::vector<double>& c, double rho, int terms) {
+    // c_k rho^k, padded with zeros to terms coefficients
+    std::vector<double> out(terms, 0.0);
+    double w = 1.0;
+    for (int k = 0; k < terms && k < (int)c.size(); k++, w *= rho) out[k] = c[k] * w;
+    return out;
+}
+
+double FrobeniusSolver::evaluate(const std::vector<double>& a, double x) {
+    double v = 0.0;
+    for (size_t i = a.size(); i-- > 0;) v = v * x + a[i];
+    return v;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+// Truncated power series a[0] + a[1]x + ... with double coefficients, lowest degree first
+class PowerSeries {
+public:
+    // products of shorter operands use the schoolbook loop
+    static const int KaratsubaThreshold = 32;
+
+    // first n coefficients of a*b, Karatsuba above the threshold. Rounding errors are relative
+    // to the largest coefficients, so series that decay fast should be rescaled first
+    static std::vector<double> multiply(const std::vector<double>& a, const std::vector<double>& b, int n);
+    // 1/a to n terms by Newton iteration g <- g(2 - ag), a[0] must be nonzero
+    static std::vector<double> inverse(const std::vector<double>& a, int n);
+    // a/b to n terms, b[0] must be nonzero
+    static std::vector<double> divide(const std::vector<double>& a, const std::vector<double>& b, int n);
+    // a(b(x)) to n terms, with a read as the polynomial it stores. Baby-step giant-step,
+    // so only about 2 sqrt(a.size()) series products are needed
+    static std::vector<double> compose(const std::vector<double>& a, const std::vector<double>& b, int n);
+};
+
+// Frobenius series about the regular singular point x = 0 of
+// x^2 A(x) y'' + x B(x) y' + C(x) y = 0 with A, B, C analytic and A(0) != 0.
+// Each root r of A0 r(r - 1) + B0 r + C0 = 0 gives y = x^r (a0 + a1 x + ...)
+class FrobeniusSolver {
+public:
+    // a[0..terms) for exponent r with a0 = 1, from A, B, C given to at least terms coefficients.
+    // The recurrence is an online convolution, solved divide and conquer so the work is
+    // O(M(terms) log terms) instead of quadratic. False when it would divide by zero (roots
+    // differing by an integer, where the second solution needs a log term)
+    static bool solve(const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& C, double r, int terms, std::vector<double>& a);
+
+    // the same recurrence term by term, quadratic, for a few exact leading coefficients
+    template <class T>
+    static bool coefficients(const std::vector<T>& A, const std::vector<T>& B, const std::vector<T>& C, const T& r, int terms, std::vector<T>& a) {
+        // coefficient of a_(n-k) in the x^(n+r) equation, with e = n - k + r
+        auto part = [&](size_t k, const T& e) {
+            T v = T(0);
+            if (k < A.size()) v = v + A[k] * e * (e - T(1));
+            if (k < B.size()) v = v + B[k] * e;
+            if (k < C.size()) v = v + C[k];
+            return v;
+        };
+        a.assign(terms > 0 ? terms : 0, T(0));
+        if (terms <= 0) return true;
+        a[0] = T(1);
+        for (int n = 1; n < terms; n++) {
+            T pivot = part(0, r + T(n));
+            if (pivot == T(0)) return false;
+            T sum = T(0);
+            for (int k = 1; k <= n; k++) sum = sum + part(k, r + T(n - k)) * a[n - k];
+            a[n] = -sum / pivot;
+        }
+        return true;
+    }
+
+    // largest coefficient of x^(-r) L[y] relative to the size of its terms, from series
+    // products taken independently of the recurrence. Near 1e-16 for a correct series
+    static double residual(const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& C, double r, const std::vector<double>& a);
+    // sum of a_n x^n by Horner, without the x^r factor
+    static double evaluate(const std::vector<double>& a, double x);
+
+private:
+    // radius for the change of variable x = rho u, about the radius of convergence capped at 1
+    static double scaleFor(const std::vector<double>& A, const std::vector<double>& B, const std::vector<double>& C, int terms);
+    static std::vector<double> scaled(const std::vector<double>& c, double rho, int terms);
+};
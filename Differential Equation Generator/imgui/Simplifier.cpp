@@ -0,0 +1,910 @@
+#include "Simplifier.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+
+namespace {
+
+    // e-node: an operator over e-classes instead of over expressions
+    struct ENode {
+        ExprOp op;
+        double value = 0.0;
+        int name = -1; // index into EGraph::names
+        int order = 0;
+        DerivStyle style = DerivStyle::Leibniz;
+        std::vector<int> kids;
+    };
+
+    struct ENodeHash {
+        size_t operator()(const ENode& n) const {
+            size_t h = std::hash<int>()(int(n.op) * 31 + n.order * 4 + int(n.style));
+            h ^= std::hash<double>()(n.value) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            h ^= size_t(n.name + 1) + (h << 6) + (h >> 2);
+            for (int k : n.kids) h ^= size_t(k) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    struct ENodeEqual {
+        bool operator()(const ENode& a, const ENode& b) const {
+            return a.op == b.op && a.value == b.value && a.order == b.order && a.style == b.style &&
+                a.name == b.name && a.kids == b.kids;
+        }
+    };
+
+    long long gcd(long long a, long long b) {
+        a = a < 0 ? -a : a;
+        b = b < 0 ? -b : b;
+        while (b != 0) {
+            long long t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    // v as num/den with a small denominator, false if there is none
+    bool rational(double v, long long& num, long long& den) {
+        const long long MaxDen = 100000;
+        double x = std::fabs(v);
+        long long p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+        for (int i = 0; i < 20; i++) {
+            if (x > 1e12) return false;
+            long long a = (long long)std::floor(x);
+            long long p2 = a * p1 + p0, q2 = a * q1 + q0;
+            if (q2 > MaxDen) return false;
+            p0 = p1; q0 = q1; p1 = p2; q1 = q2;
+            if (std::fabs(double(p1) / double(q1) - std::fabs(v)) <= 1e-9 * std::max(1.0, std::fabs(v))) {
+                num = v < 0 ? -p1 : p1;
+                den = q1;
+                return true;
+            }
+            double frac = x - double(a);
+            if (frac < 1e-12) return false;
+            x = 1.0 / frac;
+        }
+        return false;
+    }
+
+    class EGraph {
+    public:
+        std::vector<ENode> nodes;
+        std::vector<int> nodeClass;            // class each node was added to, find() it
+        std::vector<int> parent;               // union-find over classes
+        // nodes of each root class as a linked list, so a merge appends without copying
+        std::vector<int> firstMember, lastMember, classSize;
+        std::vector<int> nextMember;           // per node, -1 at the end of its class
+        std::vector<char> isConst;             // constant analysis
+        std::vector<double> constValue;
+        // canonical nodes by index in an open-addressed table of 2^k slots, -1 when empty.
+        // Clearing it is a fill, so a small graph costs no allocation per simplify
+        std::vector<int> memo;
+        std::vector<size_t> hashes;            // hash of each node as last canonicalized
+        size_t memoSize = 0;
+        std::vector<std::string> names;        // variable, function and derivative names
+        std::vector<const Expr*> source;       // per node, the input node it was loaded from
+        bool dirty = false;                    // merges since the last rebuild
+        std::vector<char> touched;             // per class: got a node or a merge since markStale()
+        std::vector<char> stale;               // per node: something below it changed
+        std::vector<std::vector<int>> spare;   // kid lists of dropped nodes, reused so making a node rarely allocates
+        std::vector<int> others;               // scratch for term()
+
+        int intern(const std::string& name) {
+            auto it = std::find(names.begin(), names.end(), name);
+            if (it != names.end()) return int(it - names.begin());
+            names.push_back(name);
+            return (int)names.size() - 1;
+        }
+
+        // an empty kid list, with the capacity of one that was dropped when there is one
+        std::vector<int> kidList() {
+            if (spare.empty()) return std::vector<int>();
+            std::vector<int> kids = std::move(spare.back());
+            spare.pop_back();
+            kids.clear();
+            return kids;
+        }
+
+        void drop(std::vector<int>& kids) {
+            if (kids.capacity() > 0) spare.push_back(std::move(kids));
+        }
+
+        void clear() {
+            for (ENode& n : nodes) drop(n.kids);
+            nodes.clear();
+            nodeClass.clear();
+            parent.clear();
+            firstMember.clear();
+            lastMember.clear();
+            classSize.clear();
+            nextMember.clear();
+            isConst.clear();
+            constValue.clear();
+            clearMemo();
+            hashes.clear();
+            names.clear();
+            source.clear();
+            dirty = false;
+            touched.clear();
+        }
+
+        int find(int c) {
+            while (parent[c] != c) {
+                parent[c] = parent[parent[c]];
+                c = parent[c];
+            }
+            return c;
+        }
+
+        void canonicalize(ENode& n) {
+            for (int& k : n.kids) k = find(k);
+            // Add and Mul are commutative, sorted children make permutations congruent
+            if (n.op == ExprOp::Add || n.op == ExprOp::Mul) std::sort(n.kids.begin(), n.kids.end());
+        }
+
+        void clearMemo() {
+            if (memo.size() < 64) memo.resize(64);
+            std::fill(memo.begin(), memo.end(), -1);
+            memoSize = 0;
+        }
+
+        // slot holding a node equal to nodes[i], or the empty slot where it goes
+        size_t slot(int i) const {
+            size_t mask = memo.size() - 1;
+            // the low bits of ENodeHash cluster, spread the high ones down first
+            size_t h = hashes[i] * 0x9e3779b97f4a7c15ULL;
+            for (size_t at = (h ^ (h >> 32)) & mask;; at = (at + 1) & mask) {
+                int m = memo[at];
+                if (m < 0 || (hashes[m] == hashes[i] && ENodeEqual()(nodes[m], nodes[i]))) return at;
+            }
+        }
+
+        // canonical node equal to nodes[i], i itself when it is new
+        int memoize(int i) {
+            size_t at = slot(i);
+            if (memo[at] >= 0) return memo[at];
+            memo[at] = i;
+            if (++memoSize * 2 > memo.size()) {
+                std::vector<int> old(memo.size() * 2, -1);
+                old.swap(memo);
+                for (int m : old) {
+                    if (m >= 0) memo[slot(m)] = m;
+                }
+            }
+            return i;
+        }
+
+        int add(ENode n) {
+            canonicalize(n);
+            int index = (int)nodes.size();
+            nodes.push_back(std::move(n));
+            hashes.push_back(ENodeHash()(nodes.back()));
+            size_t at = slot(index);
+            if (memo[at] >= 0) {
+                drop(nodes.back().kids);
+                nodes.pop_back();
+                hashes.pop_back();
+                return find(nodeClass[memo[at]]);
+            }
+
+            const ENode& added = nodes.back();
+            double folded = 0.0;
+            bool foldable = fold(added, folded);
+
+            int c = (int)parent.size();
+            nodeClass.push_back(c);
+            parent.push_back(c);
+            firstMember.push_back(index);
+            lastMember.push_back(index);
+            classSize.push_back(1);
+            nextMember.push_back(-1);
+            touched.push_back(1);
+            source.push_back(nullptr);
+            isConst.push_back(added.op == ExprOp::Const);
+            constValue.push_back(added.value);
+            memoize(index);
+
+            if (foldable) merge(c, constant(folded));
+            return find(c);
+        }
+
+        int constant(double v) {
+            ENode n;
+            n.op = ExprOp::Const;
+            n.value = v == 0.0 ? 0.0 : v;
+            return add(std::move(n));
+        }
+
+        int make(ExprOp op, const int* kids, size_t count) {
+            ENode n;
+            n.op = op;
+            n.kids = kidList();
+            n.kids.assign(kids, kids + count);
+            return add(std::move(n));
+        }
+
+        int make(ExprOp op, const std::vector<int>& kids) { return make(op, kids.data(), kids.size()); }
+        int make(ExprOp op, std::initializer_list<int> kids) { return make(op, kids.begin(), kids.size()); }
+
+        // sum or product of terms, with the usual shortcuts for zero and one terms
+        int makeAssoc(ExprOp op, const std::vector<int>& kids) {
+            if (kids.empty()) return constant(op == ExprOp::Add ? 0.0 : 1.0);
+            if (kids.size() == 1) return find(kids[0]);
+            return make(op, kids);
+        }
+
+        void merge(int a, int b) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (classSize[a] < classSize[b]) std::swap(a, b);
+            parent[b] = a;
+            dirty = true;
+            touched[a] = 1;
+            nextMember[lastMember[a]] = firstMember[b];
+            lastMember[a] = lastMember[b];
+            classSize[a] += classSize[b];
+            firstMember[b] = lastMember[b] = -1;
+            classSize[b] = 0;
+            if (isConst[b] && !isConst[a]) {
+                isConst[a] = 1;
+                constValue[a] = constValue[b];
+            }
+        }
+
+        // restores congruence: nodes that became equal through merges put their classes together
+        void rebuild() {
+            bool changed = dirty;
+            dirty = false;
+            while (changed) {
+                changed = false;
+                clearMemo();
+                for (size_t i = 0; i < nodes.size(); i++) {
+                    canonicalize(nodes[i]);
+                    hashes[i] = ENodeHash()(nodes[i]);
+                    int first = memoize((int)i);
+                    if (first != (int)i && find(nodeClass[first]) != find(nodeClass[i])) {
+                        merge(nodeClass[first], nodeClass[i]);
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // rules only look below their node, so a node is stale when a class under it was touched.
+        // Clears the touched marks for the next pass
+        void markStale() {
+            stale.assign(nodes.size(), 0);
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (size_t i = 0; i < nodes.size(); i++) {
+                    if (stale[i]) continue;
+                    for (int k : nodes[i].kids) {
+                        if (!touched[find(k)]) continue;
+                        stale[i] = 1;
+                        int c = find(nodeClass[i]);
+                        if (!touched[c]) touched[c] = 1, changed = true;
+                        break;
+                    }
+                }
+            }
+            std::fill(touched.begin(), touched.end(), 0);
+        }
+
+        bool constOf(int c, double& v) {
+            c = find(c);
+            v = constValue[c];
+            return isConst[c] != 0;
+        }
+
+        // first node of class c with the given operator, -1 if there is none
+        int nodeWith(int c, ExprOp op) {
+            for (int i = firstMember[find(c)]; i >= 0; i = nextMember[i]) {
+                if (nodes[i].op == op) return i;
+            }
+            return -1;
+        }
+
+        // splits a term into coefficient * rest, rest is -1 for a pure constant
+        void term(int t, double& coeff, int& rest) {
+            t = find(t);
+            if (constOf(t, coeff)) {
+                rest = -1;
+                return;
+            }
+            for (int i = firstMember[t]; i >= 0; i = nextMember[i]) {
+                if (nodes[i].op != ExprOp::Mul) continue;
+                double k = 1.0, v;
+                bool hasConst = false;
+                for (int kid : nodes[i].kids) {
+                    if (constOf(kid, v)) { k *= v; hasConst = true; }
+                }
+                if (!hasConst) continue;
+                others.clear();
+                for (int kid : nodes[i].kids) {
+                    if (!constOf(kid, v)) others.push_back(kid);
+                }
+                coeff = k;
+                rest = makeAssoc(ExprOp::Mul, others);
+                return;
+            }
+            coeff = 1.0;
+            rest = t;
+        }
+
+        // terms of a sum, a class without an Add node is a single term
+        void terms(int c, std::vector<int>& out) {
+            int i = nodeWith(c, ExprOp::Add);
+            if (i >= 0) out.assign(nodes[i].kids.begin(), nodes[i].kids.end());
+            else out.assign(1, find(c));
+        }
+
+    private:
+        bool fold(const ENode& n, double& v) {
+            double k[2] = { 0.0, 0.0 };
+            v = n.op == ExprOp::Mul ? 1.0 : 0.0;
+            for (size_t i = 0; i < n.kids.size(); i++) {
+                double x;
+                if (!constOf(n.kids[i], x)) return false;
+                if (n.op == ExprOp::Add) v += x;
+                else if (n.op == ExprOp::Mul) v *= x;
+                else if (i < 2) k[i] = x;
+            }
+            switch (n.op) {
+            case ExprOp::Add:
+            case ExprOp::Mul:
+                return true;
+            case ExprOp::Neg: v = -k[0]; return true;
+            case ExprOp::Div: if (k[1] == 0.0) return false; v = k[0] / k[1]; return true;
+            case ExprOp::Pow:
+                if (k[1] != std::floor(k[1]) || std::fabs(k[1]) > 16 || (k[0] == 0.0 && k[1] < 0)) return false;
+                v = std::pow(k[0], k[1]);
+                return true;
+            default:
+                return false;
+            }
+        }
+    };
+
+    // rewrite rules, each adds equivalent forms of n and merges them into its class c
+    void applyRules(EGraph& g, const ENode& n, int c) {
+        // lists kept between calls so their capacity is reused, rules don't nest
+        static thread_local std::vector<int> flat, rests, factors;
+        static thread_local std::vector<double> coeffs;
+        static thread_local std::vector<long long> nums, dens;
+        double v;
+
+        switch (n.op) {
+        case ExprOp::Neg:
+            // -a = -1 * a
+            g.merge(c, g.make(ExprOp::Mul, { g.constant(-1.0), n.kids[0] }));
+            break;
+
+        case ExprOp::Div:
+            // a / b = a * b^-1
+            g.merge(c, g.make(ExprOp::Mul, { n.kids[0], g.make(ExprOp::Pow, { n.kids[1], g.constant(-1.0) }) }));
+            break;
+
+        case ExprOp::Pow: {
+            double k;
+            if (!g.constOf(n.kids[1], k)) break;
+            if (k == 1.0) {
+                g.merge(c, n.kids[0]);
+                break;
+            }
+            if (k == 0.0) {
+                g.merge(c, g.constant(1.0));
+                break;
+            }
+            if (k != std::floor(k)) break;
+            // (a^m)^k = a^(mk)
+            int inner = g.nodeWith(n.kids[0], ExprOp::Pow);
+            double m;
+            if (inner >= 0 && g.constOf(g.nodes[inner].kids[1], m)) {
+                g.merge(c, g.make(ExprOp::Pow, { g.nodes[inner].kids[0], g.constant(m * k) }));
+            }
+            // (ab)^k = a^k b^k
+            int product = g.nodeWith(n.kids[0], ExprOp::Mul);
+            if (product >= 0) {
+                std::vector<int> factors;
+                for (int f : std::vector<int>(g.nodes[product].kids)) factors.push_back(g.make(ExprOp::Pow, { f, g.constant(k) }));
+                g.merge(c, g.make(ExprOp::Mul, factors));
+            }
+            break;
+        }
+
+        case ExprOp::Mul: {
+            // flatten, fold constants, collect powers of the same base
+            flat.clear();
+            bool nested = false;
+            for (int kid : n.kids) {
+                int inner = g.nodeWith(kid, ExprOp::Mul);
+                if (inner >= 0 && !g.constOf(kid, v)) {
+                    const std::vector<int>& sub = g.nodes[inner].kids;
+                    flat.insert(flat.end(), sub.begin(), sub.end());
+                    nested = true;
+                }
+                else {
+                    flat.push_back(kid);
+                }
+            }
+            double k = 1.0;
+            int constants = 0;
+            std::vector<int>& bases = rests;
+            std::vector<double>& exponents = coeffs;
+            bases.clear();
+            exponents.clear();
+            bool combined = false;
+            for (int kid : flat) {
+                if (g.constOf(kid, v)) {
+                    k *= v;
+                    constants++;
+                    continue;
+                }
+                int base = g.find(kid);
+                double e = 1.0;
+                int p = g.nodeWith(kid, ExprOp::Pow);
+                if (p >= 0 && g.constOf(g.nodes[p].kids[1], e)) base = g.find(g.nodes[p].kids[0]);
+                else e = 1.0;
+                auto at = std::find(bases.begin(), bases.end(), base);
+                if (at != bases.end()) {
+                    exponents[at - bases.begin()] += e;
+                    combined = true;
+                }
+                else {
+                    bases.push_back(base);
+                    exponents.push_back(e);
+                }
+            }
+            if (k == 0.0) {
+                g.merge(c, g.constant(0.0));
+                break;
+            }
+            // a numeric factor distributes over a sum: 2(2x + 7y)*dx = (4x + 14y)*dx
+            if (k != 1.0) {
+                for (size_t b = 0; b < bases.size(); b++) {
+                    int sum = g.nodeWith(bases[b], ExprOp::Add);
+                    if (sum < 0 || exponents[b] != 1.0) continue;
+                    std::vector<int> scaled;
+                    for (int t : std::vector<int>(g.nodes[sum].kids)) scaled.push_back(g.make(ExprOp::Mul, { g.constant(k), t }));
+                    std::vector<int> distributed(1, g.make(ExprOp::Add, scaled));
+                    for (size_t o = 0; o < bases.size(); o++) {
+                        if (o == b) continue;
+                        distributed.push_back(exponents[o] == 1.0 ? bases[o] : g.make(ExprOp::Pow, { bases[o], g.constant(exponents[o]) }));
+                    }
+                    g.merge(c, g.makeAssoc(ExprOp::Mul, distributed));
+                    break;
+                }
+            }
+            if (!nested && !combined && constants == 0) break;
+            if (!nested && !combined && constants == 1 && k != 1.0) break;
+            factors.clear();
+            if (k != 1.0) factors.push_back(g.constant(k));
+            for (size_t b = 0; b < bases.size(); b++) {
+                if (exponents[b] == 0.0) continue;
+                factors.push_back(exponents[b] == 1.0 ? bases[b] : g.make(ExprOp::Pow, { bases[b], g.constant(exponents[b]) }));
+            }
+            g.merge(c, g.makeAssoc(ExprOp::Mul, factors));
+            break;
+        }
+
+        case ExprOp::Add: {
+            // flatten, fold constants, combine like terms
+            flat.clear();
+            bool nested = false;
+            for (int kid : n.kids) {
+                int inner = g.nodeWith(kid, ExprOp::Add);
+                if (inner >= 0 && !g.constOf(kid, v)) {
+                    const std::vector<int>& sub = g.nodes[inner].kids;
+                    flat.insert(flat.end(), sub.begin(), sub.end());
+                    nested = true;
+                }
+                else {
+                    flat.push_back(kid);
+                }
+            }
+            double sum = 0.0;
+            int constants = 0;
+            rests.clear();
+            coeffs.clear();
+            bool combined = false;
+            for (int kid : flat) {
+                double coeff;
+                int rest;
+                g.term(kid, coeff, rest);
+                if (rest < 0) {
+                    sum += coeff;
+                    constants++;
+                    continue;
+                }
+                auto at = std::find(rests.begin(), rests.end(), rest);
+                if (at != rests.end()) {
+                    coeffs[at - rests.begin()] += coeff;
+                    combined = true;
+                }
+                else {
+                    rests.push_back(rest);
+                    coeffs.push_back(coeff);
+                }
+            }
+            // integer content of the sum: 6x + 4y = 2(3x + 2y)
+            long long content = 0;
+            bool integral = rests.size() + (sum != 0.0 ? 1 : 0) >= 2;
+            for (size_t t = 0; t <= rests.size() && integral; t++) {
+                double k = t < rests.size() ? coeffs[t] : sum;
+                if (k != std::floor(k) || std::fabs(k) > 1e15) integral = false;
+                else content = gcd(content, (long long)k);
+            }
+            if (integral && content > 1) {
+                factors.clear();
+                if (sum != 0.0) factors.push_back(g.constant(sum / content));
+                for (size_t t = 0; t < rests.size(); t++) {
+                    if (coeffs[t] == 0.0) continue;
+                    double k = coeffs[t] / content;
+                    factors.push_back(k == 1.0 ? rests[t] : g.make(ExprOp::Mul, { g.constant(k), rests[t] }));
+                }
+                g.merge(c, g.make(ExprOp::Mul, { g.constant(double(content)), g.makeAssoc(ExprOp::Add, factors) }));
+            }
+            if (!nested && !combined && constants == 0) break;
+            if (!nested && !combined && constants == 1 && sum != 0.0) break;
+            factors.clear();
+            if (sum != 0.0) factors.push_back(g.constant(sum));
+            for (size_t t = 0; t < rests.size(); t++) {
+                if (coeffs[t] == 0.0) continue;
+                factors.push_back(coeffs[t] == 1.0 ? rests[t] : g.make(ExprOp::Mul, { g.constant(coeffs[t]), rests[t] }));
+            }
+            g.merge(c, g.makeAssoc(ExprOp::Add, factors));
+            break;
+        }
+
+        case ExprOp::Equation: {
+            // both sides times the same factor: coprime integer coefficients
+            long long lcm = 1;
+            size_t leftTerms = 0;
+            rests.clear();
+            nums.clear();
+            dens.clear();
+            for (int s = 0; s < 2; s++) {
+                if (!(g.constOf(n.kids[s], v) && v == 0.0)) {
+                    g.terms(n.kids[s], flat);
+                    for (int t : flat) {
+                        double coeff;
+                        int rest;
+                        g.term(t, coeff, rest);
+                        long long num, den;
+                        if (!rational(coeff, num, den)) return;
+                        if (lcm / gcd(lcm, den) > 1000000 / std::max(1LL, den)) return;
+                        lcm = lcm / gcd(lcm, den) * den;
+                        rests.push_back(rest);
+                        nums.push_back(num);
+                        dens.push_back(den);
+                    }
+                }
+                if (s == 0) leftTerms = rests.size();
+            }
+            long long common = 0;
+            for (size_t t = 0; t < nums.size(); t++) common = gcd(common, nums[t] * (lcm / dens[t]));
+            if (common == 0 || (lcm == 1 && common == 1)) break;
+
+            int newSides[2];
+            for (int s = 0; s < 2; s++) {
+                factors.clear();
+                size_t from = s == 0 ? 0 : leftTerms, to = s == 0 ? leftTerms : rests.size();
+                for (size_t t = from; t < to; t++) {
+                    double k = double(nums[t] * (lcm / dens[t]) / common);
+                    factors.push_back(rests[t] < 0 ? g.constant(k) : g.make(ExprOp::Mul, { g.constant(k), rests[t] }));
+                }
+                newSides[s] = g.makeAssoc(ExprOp::Add, factors);
+            }
+            g.merge(c, g.make(ExprOp::Equation, newSides, 2));
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    // applies the rules to node index i, leaves and function calls have none
+    void rewrite(EGraph& g, int i) {
+        const ENode& node = g.nodes[i];
+        if (node.op == ExprOp::Const || node.op == ExprOp::Var || node.op == ExprOp::Func || node.op == ExprOp::Deriv ||
+            node.op == ExprOp::Differential || node.op == ExprOp::System) return;
+        // a copy, making nodes may move g.nodes
+        ENode n;
+        n.op = node.op;
+        n.kids = g.kidList();
+        n.kids.assign(node.kids.begin(), node.kids.end());
+        applyRules(g, n, g.find(g.nodeClass[i]));
+        g.drop(n.kids);
+    }
+
+    // total order on expressions that ignores where nodes live in memory,
+    // terms are compared without their coefficient first so "5x*dx + 2y*dy" sorts by variables
+    int compare(const Expr* a, const Expr* b);
+
+    int compareArgs(const std::vector<const Expr*>& a, size_t ia, const std::vector<const Expr*>& b, size_t ib) {
+        for (; ia < a.size() && ib < b.size(); ia++, ib++) {
+            int r = compare(a[ia], b[ib]);
+            if (r != 0) return r;
+        }
+        return (a.size() - ia) < (b.size() - ib) ? -1 : (a.size() - ia) > (b.size() - ib) ? 1 : 0;
+    }
+
+    int compare(const Expr* a, const Expr* b) {
+        if (a == b) return 0;
+        bool ca = a->op == ExprOp::Mul && a->args[0]->isConst();
+        bool cb = b->op == ExprOp::Mul && b->args[0]->isConst();
+        if (ca || cb) {
+            // compare k*rest by rest, then by k
+            size_t ia = ca ? 1 : 0, ib = cb ? 1 : 0;
+            int r;
+            if (a->args.size() - ia == 1 && ca && b->op != ExprOp::Mul) r = compare(a->args[1], b);
+            else if (b->args.size() - ib == 1 && cb && a->op != ExprOp::Mul) r = compare(a, b->args[1]);
+            else if (a->op == ExprOp::Mul && b->op == ExprOp::Mul) r = compareArgs(a->args, ia, b->args, ib);
+            else r = int(a->op) < int(b->op) ? -1 : 1;
+            if (r != 0) return r;
+            double ka = ca ? a->args[0]->value : 1.0, kb = cb ? b->args[0]->value : 1.0;
+            return ka < kb ? -1 : ka > kb ? 1 : 0;
+        }
+        if (a->op != b->op) return int(a->op) < int(b->op) ? -1 : 1;
+        if (a->name != b->name) return a->name < b->name ? -1 : 1;
+        if (a->value != b->value) return a->value < b->value ? -1 : 1;
+        if (a->order != b->order) return a->order < b->order ? -1 : 1;
+        if (a->style != b->style) return int(a->style) < int(b->style) ? -1 : 1;
+        return compareArgs(a->args, 0, b->args, 0);
+    }
+
+    int derivativeOrder(const Expr* e) {
+        int order = 0;
+        for (const Expr* a : e->args) order = std::max(order, derivativeOrder(a));
+        return e->op == ExprOp::Deriv ? e->order + order : order;
+    }
+
+    const Expr* differentialOf(const Expr* e) {
+        if (e->op == ExprOp::Differential) return e;
+        for (const Expr* a : e->args) {
+            const Expr* d = differentialOf(a);
+            if (d != nullptr) return d;
+        }
+        return nullptr;
+    }
+
+    // order of the terms of a sum: highest derivative first, then by differential (dx before dy),
+    // constants last
+    struct TermKey {
+        const Expr* term;
+        int order;
+        const Expr* differential;
+
+        explicit TermKey(const Expr* t) : term(t), order(derivativeOrder(t)), differential(differentialOf(t)) {}
+
+        bool operator<(const TermKey& b) const {
+            if (term->isConst() != b.term->isConst()) return b.term->isConst();
+            if (order != b.order) return order > b.order;
+            if (differential != b.differential && differential != nullptr && b.differential != nullptr) {
+                return differential->name < b.differential->name;
+            }
+            return compare(term, b.term) < 0;
+        }
+    };
+
+    // sorts the terms of a sum, or the factors of a product with numbers first
+    void sortArgs(ExprOp op, std::vector<const Expr*>& args) {
+        if (op == ExprOp::Add) {
+            // the keys walk the whole term, compute them once
+            std::vector<TermKey> keys;
+            keys.reserve(args.size());
+            for (const Expr* t : args) keys.push_back(TermKey(t));
+            std::sort(keys.begin(), keys.end());
+            for (size_t i = 0; i < keys.size(); i++) args[i] = keys[i].term;
+            return;
+        }
+        auto numbers = std::stable_partition(args.begin(), args.end(), [](const Expr* a) { return a->isConst(); });
+        std::sort(numbers, args.end(), [](const Expr* a, const Expr* b) { return compare(a, b) < 0; });
+    }
+
+    const Expr* sorted(ExprArena& arena, const Expr* e) {
+        if (e->op != ExprOp::Add && e->op != ExprOp::Mul) return e;
+        std::vector<const Expr*> args = e->args;
+        sortArgs(e->op, args);
+        return e->op == ExprOp::Add ? arena.add(args) : arena.mul(args);
+    }
+
+    // leading coefficient of a term is negative
+    bool negative(const Expr* e) {
+        if (e->op == ExprOp::Add) return negative(e->args[0]);
+        if (e->op == ExprOp::Neg) return true;
+        if (e->isConst()) return e->value < 0.0;
+        return e->op == ExprOp::Mul && e->args[0]->isConst() && e->args[0]->value < 0.0;
+    }
+
+    // -e with the sign moved into every term
+    const Expr* negated(ExprArena& arena, const Expr* e) {
+        if (e->op != ExprOp::Add) return arena.mul({ arena.constant(-1.0), e });
+        std::vector<const Expr*> terms;
+        for (const Expr* t : e->args) terms.push_back(arena.mul({ arena.constant(-1.0), t }));
+        return arena.add(terms);
+    }
+
+    class Extractor {
+    public:
+        Extractor(EGraph& graph, ExprArena& arena) : g(graph), arena(arena) {
+            // Bellman-Ford style relaxation of the cheapest node per class
+            size_t classes = g.parent.size();
+            cost.assign(classes, 1e30);
+            best.assign(classes, -1);
+            built.assign(classes, nullptr);
+            bool changed = true;
+            for (int pass = 0; changed && pass < 64; pass++) {
+                changed = false;
+                for (size_t i = 0; i < g.nodes.size(); i++) {
+                    int c = g.find(g.nodeClass[i]);
+                    double total = nodeCost(g.nodes[i]);
+                    for (int k : g.nodes[i].kids) total += cost[g.find(k)];
+                    if (total < cost[c] - 1e-9) {
+                        cost[c] = total;
+                        best[c] = (int)i;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        const Expr* build(int c) {
+            c = g.find(c);
+            if (built[c] != nullptr) return built[c];
+            const ENode& n = g.nodes[best[c]];
+            std::vector<const Expr*> kids;
+            kids.reserve(n.kids.size());
+            for (int k : n.kids) kids.push_back(build(k));
+
+            // an input node whose arguments came out unchanged is its own result, except where
+            // building sorts or rescales
+            const Expr* e = g.source[best[c]];
+            if (e != nullptr && n.op != ExprOp::Add && n.op != ExprOp::Mul && n.op != ExprOp::Equation && e->args == kids) {
+                built[c] = e;
+                return e;
+            }
+            switch (n.op) {
+            case ExprOp::Const: e = arena.constant(n.value); break;
+            case ExprOp::Var: e = arena.var(g.names[n.name]); break;
+            case ExprOp::Add:
+            case ExprOp::Mul: {
+                // the arena keeps the order of kids it doesn't flatten, so those are sorted first.
+                // The order isn't total, so the sort sees the same list it would in the built node
+                bool nested = false;
+                for (const Expr* k : kids) nested = nested || k->op == n.op;
+                if (nested) {
+                    e = sorted(arena, n.op == ExprOp::Add ? arena.add(kids) : arena.mul(kids));
+                    break;
+                }
+                if (n.op == ExprOp::Add) kids.erase(std::remove_if(kids.begin(), kids.end(), [](const Expr* k) { return k->isConst(0.0); }), kids.end());
+                sortArgs(n.op, kids);
+                e = n.op == ExprOp::Add ? arena.add(kids) : arena.mul(kids);
+                break;
+            }
+            case ExprOp::Div: e = arena.div(kids[0], kids[1]); break;
+            case ExprOp::Pow: e = arena.pow(kids[0], kids[1]); break;
+            case ExprOp::Neg: e = arena.neg(kids[0]); break;
+            case ExprOp::Func: e = arena.func(g.names[n.name], kids[0]); break;
+            case ExprOp::Deriv: e = arena.deriv(kids[0], g.names[n.name], n.order, n.style); break;
+            case ExprOp::Differential: e = arena.differential(g.names[n.name]); break;
+            case ExprOp::Equation:
+                // "... = 0" starts with a positive term
+                kids[0] = sorted(arena, kids[0]);
+                if (kids[1]->isConst(0.0) && negative(kids[0])) kids[0] = sorted(arena, negated(arena, kids[0]));
+                e = arena.equation(kids[0], kids[1]);
+                break;
+            case ExprOp::System: e = arena.system(kids); break;
+            }
+            built[c] = e;
+            return e;
+        }
+
+    private:
+        // prefer integer coefficients, products over quotients, small numbers
+        double nodeCost(const ENode& n) {
+            switch (n.op) {
+            case ExprOp::Const:
+                return 1.0 + (n.value == std::floor(n.value) ? 0.0 : 8.0) + 0.01 * std::log2(1.0 + std::fabs(n.value));
+            case ExprOp::Div:
+            case ExprOp::Neg:
+                return 8.0;
+            case ExprOp::Add:
+            case ExprOp::Mul: {
+                // repeated children read better as 2x or x^2
+                double c = 1.0;
+                for (size_t k = 1; k < n.kids.size(); k++) c += g.find(n.kids[k]) == g.find(n.kids[k - 1]) ? 8.0 : 0.0;
+                return c;
+            }
+            case ExprOp::Pow: {
+                // powers of sums and products read worse than products of powers
+                int base = g.find(n.kids[0]);
+                int b = best[base];
+                return b >= 0 && (g.nodes[b].op == ExprOp::Mul || g.nodes[b].op == ExprOp::Add) ? 8.0 : 1.0;
+            }
+            default:
+                return 1.0;
+            }
+        }
+
+        EGraph& g;
+        ExprArena& arena;
+        std::vector<double> cost;
+        std::vector<int> best;
+        std::vector<const Expr*> built;
+    };
+
+    // loaded holds the class of each node with arguments seen so far; inputs are small and
+    // mostly trees, so a list beats a hash map that would allocate per node
+    int load(EGraph& g, const Expr* e, std::vector<std::pair<const Expr*, int>>& loaded) {
+        if (!e->args.empty()) {
+            for (const auto& l : loaded) {
+                if (l.first == e) return g.find(l.second);
+            }
+        }
+        ENode n;
+        n.op = e->op;
+        n.value = e->value;
+        n.name = e->name.empty() ? -1 : g.intern(e->name);
+        n.order = e->order;
+        n.style = e->style;
+        n.kids = g.kidList();
+        for (const Expr* a : e->args) n.kids.push_back(load(g, a, loaded));
+        size_t index = g.nodes.size();
+        int c = g.add(std::move(n));
+        if (g.nodes.size() > index) g.source[index] = e;
+        if (!e->args.empty()) loaded.push_back(std::make_pair(e, c));
+        return c;
+    }
+}
+
+const Expr* Simplifier::simplify(const Expr* e, ExprArena& arena, const SimplifyBudget& budget) {
+    // nodes are hash-consed, so an equation seen before has its canonical form cached on it
+    if (e->simplified != nullptr) return e->simplified;
+
+    auto start = std::chrono::steady_clock::now();
+    // reused between calls so the tables keep their capacity
+    static thread_local EGraph g;
+    g.clear();
+    static thread_local std::vector<std::pair<const Expr*, int>> loaded;
+    loaded.clear();
+    int root = load(g, e, loaded);
+    bool saturated = false;
+
+    for (int iteration = 0; iteration < budget.maxIterations; iteration++) {
+        size_t before = g.nodes.size();
+        size_t classesBefore = 0;
+        for (size_t c = 0; c < g.parent.size(); c++) classesBefore += g.parent[c] == (int)c;
+
+        // after the first pass only nodes with something new below them can add anything;
+        // nodes added while rewriting are rewritten in the same pass
+        g.markStale();
+        for (size_t i = 0; i < g.nodes.size() && g.nodes.size() < size_t(budget.maxNodes); i++) {
+            if (iteration == 0 || i >= before || g.stale[i]) rewrite(g, (int)i);
+        }
+        g.rebuild();
+
+        size_t classesAfter = 0;
+        for (size_t c = 0; c < g.parent.size(); c++) classesAfter += g.parent[c] == (int)c;
+        // saturated: no new nodes and no new equalities
+        if (g.nodes.size() == before && classesAfter == classesBefore) {
+            saturated = true;
+            break;
+        }
+        if (g.nodes.size() >= size_t(budget.maxNodes)) break;
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        if (elapsed.count() > budget.maxMicroseconds) break;
+    }
+
+    Extractor extractor(g, arena);
+    const Expr* result = extractor.build(root);
+    // a form cut short by the budget isn't canonical, so it isn't cached
+    if (saturated) e->simplified = result;
+    return result;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Expr.h"
+
+// Limits for one simplification, saturation stops at whichever is hit first
+struct SimplifyBudget {
+    int maxNodes = 600;
+    int maxIterations = 10;
+    int maxMicroseconds = 500;
+};
+
+// Bounded equality saturation over an e-graph. The input is loaded into hash-consed
+// e-classes, rewrite rules add equivalent forms until nothing new appears or the
+// budget runs out, and the cheapest form is extracted
+class Simplifier {
+public:
+    // Canonical form of e. Equivalent inputs map to the same interned pointer, e.g.
+    // "36y*dy + 90x*dx = 0" and "2y*dy + 5x*dx = 0", or "dy/(6y) = dx/(14x)" and "7dy/y = 3dx/x".
+    // Equations are scaled to coprime integer coefficients with a positive leading term
+    static const Expr* simplify(const Expr* e, ExprArena& arena, const SimplifyBudget& budget = SimplifyBudget());
+};
@@ -0,0 +1,624 @@
+#include "SoftwareRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RENDERER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+    inline uint32_t channel(uint32_t c, int shift) {
+        return (c >> shift) & 0xFF;
+    }
+
+    inline uint32_t pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    // x / 255 rounded, exact for x <= 255 * 255
+    inline uint32_t div255(uint32_t x) {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    // src over dst with src alpha, alpha itself accumulated as a + dstA (1 - a) like the DX12 backend
+    inline uint32_t blend(uint32_t dst, uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+        uint32_t inv = 255 - a;
+        return pack(div255(r * a + channel(dst, 0) * inv), div255(g * a + channel(dst, 8) * inv),
+                    div255(b * a + channel(dst, 16) * inv), div255(a * 255 + channel(dst, 24) * inv));
+    }
+
+    // edge through a and b, positive on the side the triangle is wound towards. It's always
+    // computed from the lower endpoint, so two triangles sharing an edge get exact negatives
+    // of each other and every pixel center on it goes to exactly one of them
+    void edge(const ImVec2& a, const ImVec2& b, float& A, float& B, float& C) {
+        bool swap = b.x < a.x || (b.x == a.x && b.y < a.y);
+        const ImVec2& p = swap ? b : a;
+        const ImVec2& q = swap ? a : b;
+        A = p.y - q.y;
+        B = q.x - p.x;
+        C = -(A * p.x + B * p.y);
+        if (swap) {
+            A = -A;
+            B = -B;
+            C = -C;
+        }
+    }
+
+    uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+        static const std::vector<uint32_t> table = [] {
+            std::vector<uint32_t> t(256);
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void putBig32(std::vector<unsigned char>& out, uint32_t v) {
+        out.push_back((unsigned char)(v >> 24));
+        out.push_back((unsigned char)(v >> 16));
+        out.push_back((unsigned char)(v >> 8));
+        out.push_back((unsigned char)v);
+    }
+
+    void putChunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data) {
+        putBig32(out, (uint32_t)data.size());
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        putBig32(out, crc32(out.data() + start, out.size() - start));
+    }
+}
+
+std::vector<unsigned char> PngWriter::encode(const Image& image) {
+    // scanlines with filter type 0 in front of each row
+    std::vector<unsigned char> raw;
+    raw.reserve((size_t)image.height * (image.width * 4 + 1));
+    for (int y = 0; y < image.height; y++) {
+        raw.push_back(0);
+        for (int x = 0; x < image.width; x++) {
+            uint32_t c = image.pixels[(size_t)y * image.width + x];
+            raw.push_back((unsigned char)channel(c, 0));
+            raw.push_back((unsigned char)channel(c, 8));
+            raw.push_back((unsigned char)channel(c, 16));
+            raw.push_back((unsigned char)channel(c, 24));
+        }
+    }
+
+    // zlib header, stored blocks of at most 65535 bytes, Adler-32 of the raw data
+    std::vector<unsigned char> zlib = { 0x78, 0x01 };
+    size_t offset = 0;
+    do {
+        size_t size = std::min<size_t>(65535, raw.size() - offset);
+        zlib.push_back(offset + size == raw.size() ? 1 : 0);
+        zlib.push_back((unsigned char)size);
+        zlib.push_back((unsigned char)(size >> 8));
+        zlib.push_back((unsigned char)~size);
+        zlib.push_back((unsigned char)(~size >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+    } while (offset < raw.size());
+    uint32_t s1 = 1, s2 = 0;
+    for (unsigned char byte : raw) {
+        s1 = (s1 + byte) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    putBig32(zlib, (s2 << 16) | s1);
+
+    std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<unsigned char> header;
+    putBig32(header, (uint32_t)image.width);
+    putBig32(header, (uint32_t)image.height);
+    header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bits per channel, RGBA, no interlace
+    putChunk(png, "IHDR", header);
+    putChunk(png, "IDAT", zlib);
+    putChunk(png, "IEND", std::vector<unsigned char>());
+    return png;
+}
+
+bool PngWriter::write(const std::string& path, const Image& image) {
+    std::vector<unsigned char> png = encode(image);
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(png.data(), 1, png.size(), file) == png.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+SoftwareRenderer::SoftwareRenderer(int threads) : nextTile(0) {
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    for (int i = 1; i < threads; i++) workers.emplace_back(&SoftwareRenderer::workerLoop, this);
+}
+
+SoftwareRenderer::~SoftwareRenderer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void SoftwareRenderer::setTexture(ImTextureID id, const unsigned char* rgba, int width, int height) {
+    Texture& texture = textures[id];
+    texture.width = width;
+    texture.height = height;
+    texture.texels.resize((size_t)width * height);
+    for (size_t i = 0; i < texture.texels.size(); i++) {
+        texture.texels[i] = pack(rgba[4 * i], rgba[4 * i + 1], rgba[4 * i + 2], rgba[4 * i + 3]);
+    }
+}
+
+void SoftwareRenderer::setFontAtlas() {
+    ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    unsigned char* pixels;
+    int width, height;
+    atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+    setTexture(atlas->TexID, pixels, width, height);
+}
+
+void SoftwareRenderer::render(const ImDrawData* data, Image& target, ImU32 clear) {
+    ImVec2 scale = data ? data->FramebufferScale : ImVec2(1.0f, 1.0f);
+    target.width = data ? (int)(data->DisplaySize.x * scale.x) : target.width;
+    target.height = data ? (int)(data->DisplaySize.y * scale.y) : target.height;
+    target.pixels.resize((size_t)target.width * target.height);
+    frame = &target;
+    clearColor = clear;
+
+    tilesX = (target.width + TileSize - 1) / TileSize;
+    tilesY = (target.height + TileSize - 1) / TileSize;
+    bins.resize((size_t)tilesX * tilesY);
+    for (std::vector<int>& bin : bins) bin.clear();
+    triangles.clear();
+    if (data) setup(data);
+
+    // the calling thread takes tiles too, then waits for the workers to finish theirs
+    nextTile = 0;
+    if (!workers.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        busy = (int)workers.size();
+        generation++;
+    }
+    wake.notify_all();
+    drainTiles();
+    if (!workers.empty()) {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+    }
+    frame = nullptr;
+}
+
+void SoftwareRenderer::setup(const ImDrawData* data) {
+    ImVec2 scale = data->FramebufferScale;
+    for (int n = 0; n < data->CmdListsCount; n++) {
+        const ImDrawList* list = data->CmdLists[n];
+        for (const ImDrawCmd& cmd : list->CmdBuffer) {
+            // callbacks only change GPU state, which a software target doesn't have
+            if (cmd.UserCallback) continue;
+            int clip[4] = {
+                std::max(0, (int)((cmd.ClipRect.x - data->DisplayPos.x) * scale.x)),
+                std::max(0, (int)((cmd.ClipRect.y - data->DisplayPos.y) * scale.y)),
+                std::min(frame->width, (int)((cmd.ClipRect.z - data->DisplayPos.x) * scale.x)),
+                std::min(frame->height, (int)((cmd.ClipRect.w - data->DisplayPos.y) * scale.y))
+            };
+            if (clip[0] >= clip[2] || clip[1] >= clip[3]) continue;
+            auto texture = textures.find(cmd.GetTexID());
+            const Texture* sampled = texture == textures.end() ? nullptr : &texture->second;
+            const ImDrawVert* vtx = list->VtxBuffer.Data + cmd.VtxOffset;
+            const ImDrawIdx* idx = list->IdxBuffer.Data + cmd.IdxOffset;
+            for (unsigned int i = 0; i + 2 < cmd.ElemCount; i += 3) {
+                // most of the area is in solid quads, which skip the edge tests
+                if (i + 5 < cmd.ElemCount && addRect(vtx, idx + i, data->DisplayPos, scale, clip, sampled)) {
+                    i += 3;
+                    continue;
+                }
+                addTriangle(vtx[idx[i]], vtx[idx[i + 1]], vtx[idx[i + 2]], data->DisplayPos, scale, clip, sampled);
+            }
+        }
+    }
+}
+
+uint32_t SoftwareRenderer::flatColor(ImU32 col, const ImVec2& uv, const Texture* texture) {
+    uint32_t texel = 0xFFFFFFFFu;
+    if (texture && texture->width > 0) {
+        int x = std::min(texture->width - 1, std::max(0, (int)(uv.x * texture->width)));
+        int y = std::min(texture->height - 1, std::max(0, (int)(uv.y * texture->height)));
+        texel = texture->texels[(size_t)y * texture->width + x];
+    }
+    return pack(div255(channel(col, 0) * channel(texel, 0)), div255(channel(col, 8) * channel(texel, 8)),
+                div255(channel(col, 16) * channel(texel, 16)), div255(channel(col, 24) * channel(texel, 24)));
+}
+
+bool SoftwareRenderer::addRect(const ImDrawVert* vtx, const ImDrawIdx* idx, const ImVec2& offset, const ImVec2& scale, const int clip[4], const Texture* texture) {
+    // PrimRect's and RenderText's layout: (a b c)(a c d) with a, c opposite corners of an
+    // axis-aligned box, one color, and uv either constant or following the box (glyphs)
+    if (idx[3] != idx[0] || idx[4] != idx[2]) return false;
+    const ImDrawVert& a = vtx[idx[0]];
+    const ImDrawVert& b = vtx[idx[1]];
+    const ImDrawVert& c = vtx[idx[2]];
+    const ImDrawVert& d = vtx[idx[5]];
+    if (a.pos.y != b.pos.y || b.pos.x != c.pos.x || c.pos.y != d.pos.y || d.pos.x != a.pos.x) return false;
+    if (a.col != b.col || a.col != c.col || a.col != d.col) return false;
+    if (a.uv.y != b.uv.y || b.uv.x != c.uv.x || c.uv.y != d.uv.y || d.uv.x != a.uv.x) return false;
+
+    float ax = (a.pos.x - offset.x) * scale.x, cx = (c.pos.x - offset.x) * scale.x;
+    float ay = (a.pos.y - offset.y) * scale.y, cy = (c.pos.y - offset.y) * scale.y;
+    if (ax == cx || ay == cy) return true;
+    Triangle t;
+    t.rect = true;
+    t.texture = texture;
+    t.sampled = (a.uv.x != c.uv.x || a.uv.y != c.uv.y) && texture && texture->width > 0;
+    t.flat = !t.sampled;
+    if (t.sampled) {
+        // uv at pixel x is u[0] + x u[1], likewise for v
+        t.u[1] = (c.uv.x - a.uv.x) / (cx - ax);
+        t.u[0] = a.uv.x - ax * t.u[1];
+        t.v[1] = (c.uv.y - a.uv.y) / (cy - ay);
+        t.v[0] = a.uv.y - ay * t.v[1];
+        t.color = a.col;
+    }
+    else {
+        t.color = flatColor(a.col, a.uv, texture);
+    }
+    if (channel(t.color, 24) == 0) return true;
+    // pixel centers in [min, max) on both axes, which is what the edge rule gives the two triangles
+    float x0 = std::min(ax, cx), x1 = std::max(ax, cx);
+    float y0 = std::min(ay, cy), y1 = std::max(ay, cy);
+    t.minX = std::max(clip[0], (int)std::ceil(x0 - 0.5f));
+    t.minY = std::max(clip[1], (int)std::ceil(y0 - 0.5f));
+    t.maxX = std::min(clip[2], (int)std::ceil(x1 - 0.5f));
+    t.maxY = std::min(clip[3], (int)std::ceil(y1 - 0.5f));
+    if (t.minX < t.maxX && t.minY < t.maxY) bin(t);
+    return true;
+}
+
+void SoftwareRenderer::addTriangle(const ImDrawVert& p0, const ImDrawVert& p1, const ImDrawVert& p2, const ImVec2& offset, const ImVec2& scale, const int clip[4], const Texture* texture) {
+    const ImDrawVert* v[3] = { &p0, &p1, &p2 };
+    ImVec2 p[3];
+    for (int i = 0; i < 3; i++) p[i] = ImVec2((v[i]->pos.x - offset.x) * scale.x, (v[i]->pos.y - offset.y) * scale.y);
+    float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+    if (area == 0.0f) return;
+    // ImGui winds both ways, flip to positive area
+    if (area < 0.0f) {
+        std::swap(p[1], p[2]);
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+
+    Triangle t;
+    t.rect = false;
+    t.minX = std::max(clip[0], (int)std::floor(std::min({ p[0].x, p[1].x, p[2].x })));
+    t.minY = std::max(clip[1], (int)std::floor(std::min({ p[0].y, p[1].y, p[2].y })));
+    t.maxX = std::min(clip[2], (int)std::ceil(std::max({ p[0].x, p[1].x, p[2].x })));
+    t.maxY = std::min(clip[3], (int)std::ceil(std::max({ p[0].y, p[1].y, p[2].y })));
+    if (t.minX >= t.maxX || t.minY >= t.maxY) return;
+
+    for (int i = 0; i < 3; i++) {
+        edge(p[(i + 1) % 3], p[(i + 2) % 3], t.A[i], t.B[i], t.C[i]);
+        t.owns[i] = t.A[i] > 0.0f || (t.A[i] == 0.0f && t.B[i] > 0.0f);
+    }
+    t.invArea = 1.0f / area;
+    t.texture = texture;
+    // attributes as the vertex 0 value and the differences to vertices 1 and 2
+    float attributes[6][3];
+    for (int i = 0; i < 3; i++) {
+        attributes[0][i] = v[i]->uv.x;
+        attributes[1][i] = v[i]->uv.y;
+        attributes[2][i] = (float)channel(v[i]->col, 0);
+        attributes[3][i] = (float)channel(v[i]->col, 8);
+        attributes[4][i] = (float)channel(v[i]->col, 16);
+        attributes[5][i] = (float)channel(v[i]->col, 24);
+    }
+    float* targets[6] = { t.u, t.v, t.r, t.g, t.b, t.a };
+    for (int k = 0; k < 6; k++) {
+        targets[k][0] = attributes[k][0];
+        targets[k][1] = attributes[k][1] - attributes[k][0];
+        targets[k][2] = attributes[k][2] - attributes[k][0];
+    }
+
+    // one uv, like the white texel under anti-aliased fringes, is sampled once here
+    bool oneTexel = p0.uv.x == p1.uv.x && p0.uv.x == p2.uv.x && p0.uv.y == p1.uv.y && p0.uv.y == p2.uv.y;
+    t.sampled = !oneTexel && texture && texture->width > 0;
+    uint32_t texel = oneTexel ? flatColor(IM_COL32_WHITE, p0.uv, texture) : 0xFFFFFFFFu;
+    for (int c = 0; c < 4; c++) t.texel[c] = channel(texel, 8 * c) * (1.0f / 255.0f);
+    t.flat = oneTexel && p0.col == p1.col && p0.col == p2.col;
+    t.color = t.flat ? flatColor(p0.col, p0.uv, texture) : 0;
+    if (t.flat && channel(t.color, 24) == 0) return;
+    bin(t);
+}
+
+void SoftwareRenderer::bin(const Triangle& t) {
+    int index = (int)triangles.size();
+    triangles.push_back(t);
+    for (int ty = t.minY / TileSize; ty <= (t.maxY - 1) / TileSize; ty++) {
+        for (int tx = t.minX / TileSize; tx <= (t.maxX - 1) / TileSize; tx++) {
+            bins[(size_t)ty * tilesX + tx].push_back(index);
+        }
+    }
+}
+
+void SoftwareRenderer::workerLoop() {
+    int seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        drainTiles();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0) done.notify_one();
+    }
+}
+
+void SoftwareRenderer::drainTiles() {
+    for (int tile = nextTile++; tile < tilesX * tilesY; tile = nextTile++) rasterTile(tile);
+}
+
+void SoftwareRenderer::rasterTile(int tile) {
+    int x0 = (tile % tilesX) * TileSize, y0 = (tile / tilesX) * TileSize;
+    int x1 = std::min(x0 + TileSize, frame->width), y1 = std::min(y0 + TileSize, frame->height);
+    // everything under the last opaque rect that covers the tile is never seen, like the
+    // clear under a window background
+    const std::vector<int>& bin = bins[tile];
+    size_t first = bin.size();
+    while (first > 0) {
+        const Triangle& t = triangles[bin[first - 1]];
+        if (t.rect && channel(t.color, 24) == 255 && t.minX <= x0 && t.minY <= y0 && t.maxX >= x1 && t.maxY >= y1) break;
+        first--;
+    }
+    if (first == 0) {
+        for (int y = y0; y < y1; y++) {
+            std::fill(frame->pixels.begin() + (size_t)y * frame->width + x0, frame->pixels.begin() + (size_t)y * frame->width + x1, clearColor);
+        }
+    }
+    else {
+        first--;
+    }
+    for (size_t k = first; k < bin.size(); k++) {
+        const Triangle& t = triangles[bin[k]];
+        int bx0 = std::max(x0, t.minX), by0 = std::max(y0, t.minY), bx1 = std::min(x1, t.maxX), by1 = std::min(y1, t.maxY);
+        if (t.rect) fillRect(t, bx0, by0, bx1, by1);
+        else rasterTriangle(t, bx0, by0, bx1, by1);
+    }
+}
+
+namespace {
+    // flat source color prepared for blending four pixels at a time
+    struct FlatSource {
+        uint32_t r, g, b, a;
+#ifdef SOFTWARE_RENDERER_SSE2
+        __m128i source, inverse;
+
+        explicit FlatSource(uint32_t color) : r(channel(color, 0)), g(channel(color, 8)), b(channel(color, 16)), a(channel(color, 24)) {
+            // color times alpha (alpha times 255 for alpha) and 255 - alpha, as 16-bit lanes
+            source = _mm_setr_epi16((short)(r * a), (short)(g * a), (short)(b * a), (short)(a * 255),
+                                    (short)(r * a), (short)(g * a), (short)(b * a), (short)(a * 255));
+            inverse = _mm_set1_epi16((short)(255 - a));
+        }
+
+        // blend() on four pixels
+        __m128i blended4(__m128i dst) const {
+            const __m128i zero = _mm_setzero_si128(), half = _mm_set1_epi16(128);
+            __m128i lo = _mm_add_epi16(_mm_add_epi16(source, _mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inverse)), half);
+            __m128i hi = _mm_add_epi16(_mm_add_epi16(source, _mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inverse)), half);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            return _mm_packus_epi16(lo, hi);
+        }
+
+        // blend() on four pixels, written back where keep is set
+        void blend4(uint32_t* pixels, __m128i keep) const {
+            __m128i dst = _mm_loadu_si128((const __m128i*)pixels);
+            _mm_storeu_si128((__m128i*)pixels, _mm_or_si128(_mm_and_si128(keep, blended4(dst)), _mm_andnot_si128(keep, dst)));
+        }
+#else
+        explicit FlatSource(uint32_t color) : r(channel(color, 0)), g(channel(color, 8)), b(channel(color, 16)), a(channel(color, 24)) {
+        }
+#endif
+        void blend1(uint32_t* pixel) const {
+            *pixel = blend(*pixel, r, g, b, a);
+        }
+    };
+
+#ifdef SOFTWARE_RENDERER_SSE2
+    // four pixels of a triangle with interpolated color and one texel, like anti-aliased
+    // fringes. Channels hold the vertex 0 value and the differences to vertices 1 and 2
+    void shade4(const float* r, const float* g, const float* b, const float* a, const float* texel, __m128 l1, __m128 l2, uint32_t* pixels, __m128i keep) {
+        auto lerp = [&](const float* c, float scale) {
+            __m128 v = _mm_add_ps(_mm_set1_ps(c[0]), _mm_add_ps(_mm_mul_ps(l1, _mm_set1_ps(c[1])), _mm_mul_ps(l2, _mm_set1_ps(c[2]))));
+            return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(scale)), _mm_set1_ps(0.5f)));
+        };
+        // [r0..r3 g0..g3] and [b0..b3 a0..a3] as 16-bit, interleaved into two pixels per register
+        __m128i rg = _mm_packs_epi32(lerp(r, texel[0]), lerp(g, texel[1]));
+        __m128i ba = _mm_packs_epi32(lerp(b, texel[2]), lerp(a, texel[3]));
+        __m128i rb = _mm_unpacklo_epi16(rg, ba), ga = _mm_unpackhi_epi16(rg, ba);
+        const __m128i zero = _mm_setzero_si128(), full = _mm_set1_epi16(255), half = _mm_set1_epi16(128);
+        const __m128i alphaLane = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+        __m128i src[2] = { _mm_unpacklo_epi16(rb, ga), _mm_unpackhi_epi16(rb, ga) };
+        __m128i dst = _mm_loadu_si128((const __m128i*)pixels);
+        __m128i out[2];
+        for (int k = 0; k < 2; k++) {
+            __m128i s = _mm_min_epi16(_mm_max_epi16(src[k], zero), full);
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            // color times alpha, alpha times 255, plus dst times 255 - alpha, then / 255
+            __m128i factor = _mm_or_si128(_mm_andnot_si128(alphaLane, alpha), _mm_and_si128(alphaLane, full));
+            __m128i d = k == 0 ? _mm_unpacklo_epi8(dst, zero) : _mm_unpackhi_epi8(dst, zero);
+            __m128i x = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, factor), _mm_mullo_epi16(d, _mm_sub_epi16(full, alpha))), half);
+            out[k] = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+        }
+        __m128i blended = _mm_packus_epi16(out[0], out[1]);
+        _mm_storeu_si128((__m128i*)pixels, _mm_or_si128(_mm_and_si128(keep, blended), _mm_andnot_si128(keep, dst)));
+    }
+#endif
+}
+
+void SoftwareRenderer::fillRect(const Triangle& t, int x0, int y0, int x1, int y1) {
+    if (t.sampled) {
+        fillTexturedRect(t, x0, y0, x1, y1);
+        return;
+    }
+    FlatSource flat(t.color);
+    for (int y = y0; y < y1; y++) {
+        uint32_t* pixels = frame->pixels.data() + (size_t)y * frame->width;
+        if (flat.a == 255) {
+            std::fill(pixels + x0, pixels + x1, t.color);
+            continue;
+        }
+        int x = x0;
+#ifdef SOFTWARE_RENDERER_SSE2
+        for (; x + 4 <= x1; x += 4) _mm_storeu_si128((__m128i*)(pixels + x), flat.blended4(_mm_loadu_si128((const __m128i*)(pixels + x))));
+#endif
+        for (; x < x1; x++) flat.blend1(pixels + x);
+    }
+}
+
+void SoftwareRenderer::fillTexturedRect(const Triangle& t, int x0, int y0, int x1, int y1) {
+    // the mapping is separable, so bilinear taps and weights are found once per column and
+    // row. Glyphs land on texel centers, where the weights are zero and one texel is read
+    const Texture& tex = *t.texture;
+    int columns[TileSize], rows[TileSize];
+    float weightX[TileSize], weightY[TileSize];
+    auto taps = [](float s, int size, int& tap, float& weight) {
+        float f = std::floor(s);
+        weight = s - f;
+        tap = (int)f;
+        if (tap < 0) { tap = 0; weight = 0.0f; }
+        if (tap >= size - 1) { tap = size - 1; weight = 0.0f; }
+    };
+    for (int x = x0; x < x1; x++) taps((t.u[0] + (x + 0.5f) * t.u[1]) * tex.width - 0.5f, tex.width, columns[x - x0], weightX[x - x0]);
+    for (int y = y0; y < y1; y++) taps((t.v[0] + (y + 0.5f) * t.v[1]) * tex.height - 0.5f, tex.height, rows[y - y0], weightY[y - y0]);
+
+    uint32_t r = channel(t.color, 0), g = channel(t.color, 8), b = channel(t.color, 16), a = channel(t.color, 24);
+    for (int y = y0; y < y1; y++) {
+        uint32_t* pixels = frame->pixels.data() + (size_t)y * frame->width;
+        const uint32_t* texels = tex.texels.data() + (size_t)rows[y - y0] * tex.width;
+        float wy = weightY[y - y0];
+        for (int x = x0; x < x1; x++) {
+            float wx = weightX[x - x0];
+            const uint32_t* at = texels + columns[x - x0];
+            uint32_t texel = at[0];
+            if (wx != 0.0f || wy != 0.0f) {
+                // between texels, blended per channel
+                uint32_t right = wx != 0.0f ? at[1] : at[0];
+                uint32_t below = wy != 0.0f ? at[tex.width] : at[0];
+                uint32_t diagonal = wx != 0.0f && wy != 0.0f ? at[tex.width + 1] : (wx != 0.0f ? right : below);
+                texel = 0;
+                for (int c = 0; c < 32; c += 8) {
+                    float top = channel(at[0], c) + wx * ((float)channel(right, c) - (float)channel(at[0], c));
+                    float bottom = channel(below, c) + wx * ((float)channel(diagonal, c) - (float)channel(below, c));
+                    texel |= (uint32_t)(top + wy * (bottom - top) + 0.5f) << c;
+                }
+            }
+            uint32_t sa = div255(a * channel(texel, 24));
+            if (sa == 0) continue;
+            pixels[x] = blend(pixels[x], div255(r * channel(texel, 0)), div255(g * channel(texel, 8)), div255(b * channel(texel, 16)), sa);
+        }
+    }
+}
+
+void SoftwareRenderer::rasterTriangle(const Triangle& t, int x0, int y0, int x1, int y1) {
+    FlatSource flat(t.color);
+#ifdef SOFTWARE_RENDERER_SSE2
+    const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 A[3], owns[3];
+    for (int i = 0; i < 3; i++) {
+        A[i] = _mm_set1_ps(t.A[i]);
+        owns[i] = _mm_castsi128_ps(_mm_set1_epi32(t.owns[i] ? -1 : 0));
+    }
+#endif
+
+    for (int y = y0; y < y1; y++) {
+        float fy = y + 0.5f;
+        float row[3];
+        for (int i = 0; i < 3; i++) row[i] = t.B[i] * fy + t.C[i];
+        uint32_t* pixels = frame->pixels.data() + (size_t)y * frame->width;
+
+        for (int x = x0; x < x1; x += 4) {
+            float w[3][4];
+            int mask = 0;
+#ifdef SOFTWARE_RENDERER_SSE2
+            __m128 xs = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            __m128 ws[3];
+            for (int i = 0; i < 3; i++) {
+                ws[i] = _mm_add_ps(_mm_mul_ps(A[i], xs), _mm_set1_ps(row[i]));
+                // w > 0, or w == 0 on an edge this triangle owns
+                __m128 on = _mm_or_ps(_mm_cmpgt_ps(ws[i], _mm_setzero_ps()), _mm_and_ps(owns[i], _mm_cmpeq_ps(ws[i], _mm_setzero_ps())));
+                inside = _mm_and_ps(inside, on);
+            }
+            mask = _mm_movemask_ps(inside);
+#else
+            for (int lane = 0; lane < 4; lane++) {
+                bool in = true;
+                for (int i = 0; i < 3; i++) {
+                    w[i][lane] = t.A[i] * (x + lane + 0.5f) + row[i];
+                    in = in && (w[i][lane] > 0.0f || (t.owns[i] && w[i][lane] == 0.0f));
+                }
+                if (in) mask |= 1 << lane;
+            }
+#endif
+            if (x + 4 > x1) mask &= (1 << (x1 - x)) - 1;
+            if (mask == 0) continue;
+
+            if (t.flat) {
+#ifdef SOFTWARE_RENDERER_SSE2
+                if (x + 4 <= x1) {
+                    flat.blend4(pixels + x, _mm_castps_si128(inside));
+                    continue;
+                }
+#endif
+                for (int lane = 0; lane < 4; lane++) {
+                    if (mask & (1 << lane)) flat.blend1(pixels + x + lane);
+                }
+                continue;
+            }
+
+#ifdef SOFTWARE_RENDERER_SSE2
+            if (!t.sampled && x + 4 <= x1) {
+                __m128 invArea = _mm_set1_ps(t.invArea);
+                shade4(t.r, t.g, t.b, t.a, t.texel, _mm_mul_ps(ws[1], invArea), _mm_mul_ps(ws[2], invArea), pixels + x, _mm_castps_si128(inside));
+                continue;
+            }
+            for (int i = 0; i < 3; i++) _mm_storeu_ps(w[i], ws[i]);
+#endif
+            for (int lane = 0; lane < 4; lane++) {
+                if (mask & (1 << lane)) shade(t, w[1][lane] * t.invArea, w[2][lane] * t.invArea, pixels + x + lane);
+            }
+        }
+    }
+}
+
+void SoftwareRenderer::shade(const Triangle& t, float l1, float l2, uint32_t* pixel) {
+    float texel[4] = { t.texel[0], t.texel[1], t.texel[2], t.texel[3] };
+    if (t.sampled) {
+        // bilinear, thick lines come from the atlas and rely on it
+        const Texture& tex = *t.texture;
+        float su = (t.u[0] + l1 * t.u[1] + l2 * t.u[2]) * tex.width - 0.5f;
+        float sv = (t.v[0] + l1 * t.v[1] + l2 * t.v[2]) * tex.height - 0.5f;
+        int tx = (int)std::floor(su), ty = (int)std::floor(sv);
+        float ax = su - tx, ay = sv - ty;
+        int xa = std::min(tex.width - 1, std::max(0, tx)), xb = std::min(tex.width - 1, std::max(0, tx + 1));
+        int ya = std::min(tex.height - 1, std::max(0, ty)), yb = std::min(tex.height - 1, std::max(0, ty + 1));
+        uint32_t c00 = tex.texels[(size_t)ya * tex.width + xa], c10 = tex.texels[(size_t)ya * tex.width + xb];
+        uint32_t c01 = tex.texels[(size_t)yb * tex.width + xa], c11 = tex.texels[(size_t)yb * tex.width + xb];
+        for (int c = 0; c < 4; c++) {
+            float top = channel(c00, 8 * c) + ax * ((float)channel(c10, 8 * c) - (float)channel(c00, 8 * c));
+            float bottom = channel(c01, 8 * c) + ax * ((float)channel(c11, 8 * c) - (float)channel(c01, 8 * c));
+            texel[c] = (top + ay * (bottom - top)) * (1.0f / 255.0f);
+        }
+    }
+    auto byte = [](float c) { return (uint32_t)std::min(255.0f, std::max(0.0f, c + 0.5f)); };
+    *pixel = blend(*pixel, byte((t.r[0] + l1 * t.r[1] + l2 * t.r[2]) * texel[0]), byte((t.g[0] + l1 * t.g[1] + l2 * t.g[2]) * texel[1]),
+                   byte((t.b[0] + l1 * t.b[1] + l2 * t.b[2]) * texel[2]), byte((t.a[0] + l1 * t.a[1] + l2 * t.a[2]) * texel[3]));
+}
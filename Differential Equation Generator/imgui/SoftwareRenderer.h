@@ -0,0 +1,104 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// RGBA8 pixels row by row, red in the low byte like IM_COL32
+struct Image {
+    int width = 0, height = 0;
+    std::vector<uint32_t> pixels;
+};
+
+// 8-bit RGBA PNG with the deflate stream in stored blocks, so it needs no zlib
+class PngWriter {
+public:
+    static std::vector<unsigned char> encode(const Image& image);
+    // false when the file can't be written
+    static bool write(const std::string& path, const Image& image);
+};
+
+// Draws ImDrawData on the CPU, for thumbnails and visual regression on machines without
+// a GPU. Triangles are set up once, binned into 64x64 tiles in submission order, and the
+// tiles are filled by a pool of worker threads, so blending order matches a GPU. Edge
+// functions are evaluated four pixels at a time with SSE2 where it's available
+class SoftwareRenderer {
+public:
+    static const int TileSize = 64;
+
+    // threads <= 0 uses one per hardware thread; the calling thread is one of them
+    explicit SoftwareRenderer(int threads = 0);
+    ~SoftwareRenderer();
+    SoftwareRenderer(const SoftwareRenderer&) = delete;
+    SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+
+    // copies RGBA32 texels for the draw commands that use id
+    void setTexture(ImTextureID id, const unsigned char* rgba, int width, int height);
+    // the current context's font atlas under its texture id
+    void setFontAtlas();
+
+    // clears target to clear and draws data over it, at DisplaySize times FramebufferScale
+    void render(const ImDrawData* data, Image& target, ImU32 clear = IM_COL32(115, 140, 153, 255));
+
+    int threadCount() const { return (int)workers.size() + 1; }
+
+private:
+    struct Texture {
+        int width = 0, height = 0;
+        std::vector<uint32_t> texels;
+    };
+
+    // w_i = A_i x + B_i y + C_i is the edge opposite vertex i, positive inside. Pixels on an
+    // edge belong to the triangle whose gradient points right, or down for horizontal edges
+    struct Triangle {
+        float A[3], B[3], C[3];
+        bool owns[3];
+        float invArea;
+        float u[3], v[3];
+        float r[3], g[3], b[3], a[3];
+        int minX, minY, maxX, maxY;  // half-open, already clipped
+        const Texture* texture;
+        bool sampled;                // uv varies, so the texture is sampled per pixel
+        float texel[4];              // otherwise the one texel it reads, 0-1
+        bool flat;                   // one color everywhere, e.g. fills through the white texel
+        bool rect;                   // axis-aligned quad covering its whole bounds, no edges
+        uint32_t color;              // that color, straight RGBA
+    };
+
+    std::unordered_map<ImTextureID, Texture> textures;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<int>> bins;
+    int tilesX = 0, tilesY = 0;
+    Image* frame = nullptr;
+    uint32_t clearColor = 0;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    int generation = 0, busy = 0;
+    bool stopping = false;
+    std::atomic<int> nextTile;
+
+    void setup(const ImDrawData* data);
+    // the quad starting at idx as one rect, false when it isn't a flat axis-aligned one
+    bool addRect(const ImDrawVert* vtx, const ImDrawIdx* idx, const ImVec2& offset, const ImVec2& scale, const int clip[4], const Texture* texture);
+    void addTriangle(const ImDrawVert& p0, const ImDrawVert& p1, const ImDrawVert& p2, const ImVec2& offset, const ImVec2& scale, const int clip[4], const Texture* texture);
+    void bin(const Triangle& t);
+    static uint32_t flatColor(ImU32 col, const ImVec2& uv, const Texture* texture);
+
+    void workerLoop();
+    void drainTiles();
+    void rasterTile(int tile);
+    void fillRect(const Triangle& t, int x0, int y0, int x1, int y1);
+    void fillTexturedRect(const Triangle& t, int x0, int y0, int x1, int y1);
+    void rasterTriangle(const Triangle& t, int x0, int y0, int x1, int y1);
+    // interpolated color times the bilinear texel at barycentric (1 - l1 - l2, l1, l2)
+    static void shade(const Triangle& t, float l1, float l2, uint32_t* pixel);
+};
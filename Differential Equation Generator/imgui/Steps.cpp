@@ -0,0 +1,28 @@
+#include "Steps.h"
+
+#include <fstream>
+
+std::atomic<int> LazySteps::expansions{ 0 };
+
+std::string StepExport::format(const std::string& equation, const std::vector<SolutionStep>& steps) {
+    std::string s = equation + "\n";
+    for (size_t i = 0; i < steps.size(); i++) {
+        // multi-line details stay indented under their step
+        std::string detail;
+        for (char ch : steps[i].detail) {
+            detail += ch;
+            if (ch == '\n') detail += "   ";
+        }
+        s += std::to_string(i + 1) + ". " + steps[i].title + ": " + detail + "\n";
+    }
+    return s;
+}
+
+bool StepExport::append(const std::string& path, const std::string& equation, const std::vector<SolutionStep>& steps) {
+    std::ofstream out(path, std::ios::app);
+    if (!out) {
+        return false;
+    }
+    out << format(equation, steps) << "\n";
+    return (bool)out;
+}
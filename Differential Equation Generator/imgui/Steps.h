@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+// One line of a worked solution: what is done, and the result
+struct SolutionStep {
+    std::string title;  // "Characteristic equation"
+    std::string detail; // "r^2 + 3r + 2 = 0"
+};
+
+// Step-by-step derivation held as an unevaluated thunk. Generating an equation only
+// stores the thunk; the steps are worked out the first time get() is called and kept
+class LazySteps {
+public:
+    typedef std::function<std::vector<SolutionStep>()> Thunk;
+
+    LazySteps() {}
+    explicit LazySteps(Thunk thunk) : thunk(thunk) {}
+
+    const std::vector<SolutionStep>& get() {
+        if (!done) {
+            if (thunk) steps = thunk();
+            done = true;
+            expansions++;
+        }
+        return steps;
+    }
+    bool expanded() const { return done; }
+    // drops the cached steps after the owner changed, the next get() re-runs the thunk
+    void reset() {
+        done = false;
+        steps.clear();
+    }
+
+    // derivations worked out so far, over all instances and threads
+    static std::atomic<int> expansions;
+
+private:
+    Thunk thunk;
+    std::vector<SolutionStep> steps;
+    bool done = false;
+};
+
+// Plain text export of worked solutions
+class StepExport {
+public:
+    // the equation, then "1. title: detail" per step
+    static std::string format(const std::string& equation, const std::vector<SolutionStep>& steps);
+    // appends format() and a blank line to path, false when the file can't be opened
+    static bool append(const std::string& path, const std::string& equation, const std::vector<SolutionStep>& steps);
+};
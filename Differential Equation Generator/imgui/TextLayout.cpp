@@ -0,0 +1,134 @@
+#include "TextLayout.h"
+
+#include "imgui_internal.h"
+
+#include <cstring>
+#include <iterator>
+
+bool TextLayoutCache::AtlasState::operator!=(const AtlasState& other) const {
+    return atlas != other.atlas || texture != other.texture || width != other.width || height != other.height ||
+        fonts != other.fonts || sources != other.sources;
+}
+
+TextLayoutCache::TextLayoutCache(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {
+}
+
+TextLayoutCache& TextLayoutCache::shared() {
+    static TextLayoutCache cache;
+    return cache;
+}
+
+void TextLayoutCache::clear() {
+    order.clear();
+    index.clear();
+}
+
+void TextLayoutCache::breakLines(const char* text, const char* textEnd, float wrapWidth, TextLayout& layout) {
+    ImGuiContext& g = *GImGui;
+    float scale = g.FontSize / g.Font->FontSize;
+    layout.lines.clear();
+    const char* s = text;
+    while (true) {
+        const char* lineEnd = (const char*)std::memchr(s, '\n', textEnd - s);
+        if (!lineEnd) lineEnd = textEnd;
+        if (wrapWidth <= 0.0f) {
+            layout.lines.push_back({ (int)(s - text), (int)(lineEnd - text) });
+        }
+        else {
+            // the same cuts RenderText makes, blanks after a cut are skipped
+            do {
+                const char* eol = g.Font->CalcWordWrapPositionA(scale, s, lineEnd, wrapWidth);
+                layout.lines.push_back({ (int)(s - text), (int)(eol - text) });
+                s = eol;
+                while (s < lineEnd && (*s == ' ' || *s == '\t')) s++;
+            } while (s < lineEnd);
+        }
+        if (lineEnd == textEnd) break;
+        s = lineEnd + 1;
+    }
+}
+
+const TextLayout& TextLayoutCache::get(const char* text, const char* textEnd, float wrapWidth) {
+    ImGuiContext& g = *GImGui;
+    if (!textEnd) textEnd = text + std::strlen(text);
+    // ImHashStr reads up to a terminator when given no length
+    if (text == textEnd) text = textEnd = "";
+
+    AtlasState current;
+    current.atlas = g.IO.Fonts;
+    current.texture = g.IO.Fonts->TexID;
+    current.width = g.IO.Fonts->TexWidth;
+    current.height = g.IO.Fonts->TexHeight;
+    current.fonts = g.IO.Fonts->Fonts.Size;
+    current.sources = g.IO.Fonts->Sources.Size;
+    if (current != atlas) {
+        clear();
+        atlas = current;
+    }
+
+    if (wrapWidth < 0.0f) wrapWidth = 0.0f;
+    struct { const ImFont* font; float size, wrap; } params = { g.Font, g.FontSize, wrapWidth };
+    size_t length = textEnd - text;
+    ImGuiID key = ImHashStr(text, length, ImHashData(&params, sizeof(params)));
+
+    auto found = index.find(key);
+    if (found != index.end()) {
+        Entry& e = *found->second;
+        if (e.font == g.Font && e.fontSize == g.FontSize && e.wrapWidth == wrapWidth &&
+            e.text.size() == length && std::memcmp(e.text.data(), text, length) == 0) {
+            order.splice(order.begin(), order, found->second);
+            return e.layout;
+        }
+        // a hash collision, the older text gives way
+        order.erase(found->second);
+        index.erase(found);
+    }
+
+    // reuse the least recent entry's buffers once the cache is full
+    if (index.size() >= capacity) {
+        index.erase(order.back().key);
+        order.splice(order.begin(), order, std::prev(order.end()));
+    }
+    else {
+        order.emplace_front();
+    }
+    Entry& e = order.front();
+    e.key = key;
+    e.text.assign(text, length);
+    e.font = g.Font;
+    e.fontSize = g.FontSize;
+    e.wrapWidth = wrapWidth;
+    e.layout.size = ImGui::CalcTextSize(text, textEnd, false, wrapWidth);
+    breakLines(text, textEnd, wrapWidth, e.layout);
+    index[key] = order.begin();
+    return e.layout;
+}
+
+void TextLayoutCache::text(const char* text, const char* textEnd) {
+    ImGuiWindow* window = ImGui::GetCurrentWindow();
+    if (window->SkipItems) return;
+    ImGuiContext& g = *GImGui;
+    if (!textEnd) textEnd = text + std::strlen(text);
+
+    // wrapping follows PushTextWrapPos() like ImGui::Text
+    float wrapWidth = window->DC.TextWrapPos >= 0.0f ? ImGui::CalcWrapWidthForPos(window->DC.CursorPos, window->DC.TextWrapPos) : 0.0f;
+    const TextLayout& layout = get(text, textEnd, wrapWidth);
+    if (text == textEnd) text = textEnd = "";
+    ImVec2 pos(window->DC.CursorPos.x, window->DC.CursorPos.y + window->DC.CurrLineTextBaseOffset);
+    ImRect bb(pos, ImVec2(pos.x + layout.size.x, pos.y + layout.size.y));
+    ImGui::ItemSize(layout.size, 0.0f);
+    if (!ImGui::ItemAdd(bb, 0)) return;
+
+    // lines are evenly spaced, so the visible ones are found without walking the others
+    float lineHeight = g.FontSize;
+    const ImVec4& clip = window->DrawList->_CmdHeader.ClipRect;
+    int first = clip.y > pos.y ? (int)((clip.y - pos.y) / lineHeight) : 0;
+    int last = (int)((clip.w - pos.y) / lineHeight);
+    if (last >= (int)layout.lines.size()) last = (int)layout.lines.size() - 1;
+    ImU32 color = ImGui::GetColorU32(ImGuiCol_Text);
+    for (int i = first; i <= last; i++) {
+        const std::pair<int, int>& line = layout.lines[i];
+        if (line.first == line.second) continue;
+        window->DrawList->AddText(g.Font, g.FontSize, ImVec2(pos.x, pos.y + i * lineHeight), color, text + line.first, text + line.second);
+    }
+}
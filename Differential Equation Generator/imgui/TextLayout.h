@@ -0,0 +1,66 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Extent of a text in one font, size and wrap width, and the byte ranges of its lines
+// the way ImFont::RenderText breaks them
+struct TextLayout {
+    ImVec2 size;
+    std::vector<std::pair<int, int>> lines;
+};
+
+// Layouts of recently drawn texts, so long and constant strings are measured and broken
+// into lines once instead of every frame. Entries are keyed by a hash of the text, the
+// font, its size and the wrap width, checked against a copy of the text, and evicted
+// least recently used first. A font atlas rebuild drops them all
+class TextLayoutCache {
+public:
+    static const size_t DefaultCapacity = 256;
+
+    explicit TextLayoutCache(size_t capacity = DefaultCapacity);
+
+    // layout in the current font; wrapWidth <= 0 only breaks at newlines. The reference
+    // stays valid until the next call
+    const TextLayout& get(const char* text, const char* textEnd = nullptr, float wrapWidth = 0.0f);
+    // ImGui::CalcTextSize through the cache
+    ImVec2 size(const char* text, const char* textEnd = nullptr, float wrapWidth = 0.0f) { return get(text, textEnd, wrapWidth).size; }
+
+    // ImGui::TextUnformatted drawn from the cached layout, only the lines inside the clip rect
+    void text(const char* text, const char* textEnd = nullptr);
+    void text(const std::string& s) { text(s.data(), s.data() + s.size()); }
+
+    void clear();
+    size_t entries() const { return index.size(); }
+
+    // for the UI thread
+    static TextLayoutCache& shared();
+
+private:
+    struct Entry {
+        ImGuiID key;
+        std::string text;
+        const ImFont* font;
+        float fontSize, wrapWidth;
+        TextLayout layout;
+    };
+    // what a rebuilt atlas changes
+    struct AtlasState {
+        const ImFontAtlas* atlas = nullptr;
+        ImTextureID texture = 0;
+        int width = 0, height = 0, fonts = 0, sources = 0;
+
+        bool operator!=(const AtlasState& other) const;
+    };
+
+    size_t capacity;
+    std::list<Entry> order;     // most recently used first
+    std::unordered_map<ImGuiID, std::list<Entry>::iterator> index;
+    AtlasState atlas;
+
+    static void breakLines(const char* text, const char* textEnd, float wrapWidth, TextLayout& layout);
+};